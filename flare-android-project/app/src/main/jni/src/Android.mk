@@ -19,8 +19,10 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/AnimationMedia.cpp \
 	../../../../../../src/AnimationSet.cpp \
 	../../../../../../src/AStarContainer.cpp \
+	../../../../../../src/AStarHierarchy.cpp \
 	../../../../../../src/AStarNode.cpp \
 	../../../../../../src/Avatar.cpp \
+	../../../../../../src/Benchmark.cpp \
 	../../../../../../src/Camera.cpp \
 	../../../../../../src/CampaignManager.cpp \
 	../../../../../../src/CombatText.cpp \
@@ -30,10 +32,12 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/EnemyGroupManager.cpp \
 	../../../../../../src/Entity.cpp \
 	../../../../../../src/EntityBehavior.cpp \
+	../../../../../../src/EntityGrid.cpp \
 	../../../../../../src/EntityManager.cpp \
 	../../../../../../src/EngineSettings.cpp \
 	../../../../../../src/EventManager.cpp \
 	../../../../../../src/FileParser.cpp \
+	../../../../../../src/FlowField.cpp \
 	../../../../../../src/FogOfWar.cpp \
 	../../../../../../src/FontEngine.cpp \
 	../../../../../../src/GameSlotPreview.cpp \
@@ -49,14 +53,18 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/Hazard.cpp \
 	../../../../../../src/HazardManager.cpp \
 	../../../../../../src/IconManager.cpp \
+	../../../../../../src/InputReplay.cpp \
 	../../../../../../src/InputState.cpp \
 	../../../../../../src/ItemManager.cpp \
 	../../../../../../src/ItemStorage.cpp \
+	../../../../../../src/LayerChunkCache.cpp \
 	../../../../../../src/Loot.cpp \
 	../../../../../../src/LootManager.cpp \
 	../../../../../../src/Map.cpp \
 	../../../../../../src/MapParallax.cpp \
+	../../../../../../src/MapCache.cpp \
 	../../../../../../src/MapCollision.cpp \
+	../../../../../../src/MapEventIndex.cpp \
 	../../../../../../src/MapRenderer.cpp \
 	../../../../../../src/MapSaver.cpp \
 	../../../../../../src/Menu.cpp \
@@ -89,6 +97,7 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/NPC.cpp \
 	../../../../../../src/NPCManager.cpp \
 	../../../../../../src/PowerManager.cpp \
+	../../../../../../src/Profiler.cpp \
 	../../../../../../src/QuestLog.cpp \
 	../../../../../../src/RenderDevice.cpp \
 	../../../../../../src/SaveLoad.cpp \
@@ -103,7 +112,9 @@ LOCAL_SRC_FILES := $(SDL_PATH)/src/main/android/SDL_android_main.c \
 	../../../../../../src/SoundManager.cpp \
 	../../../../../../src/StatBlock.cpp \
 	../../../../../../src/Stats.cpp \
+	../../../../../../src/StringTable.cpp \
 	../../../../../../src/Subtitles.cpp \
+	../../../../../../src/ThreadPool.cpp \
 	../../../../../../src/TileSet.cpp \
 	../../../../../../src/TooltipData.cpp \
 	../../../../../../src/TooltipManager.cpp \
@@ -20,135 +20,164 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <cstring>
 #include <cfloat>
 
-AStarContainer::AStarContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit)
-	: size(0)
-	, node_limit(_node_limit)
-	, map_width(_map_width)
-	, map_height(_map_height)
+AStarContainer::AStarContainer()
+	: open_size(0)
+	, close_size(0)
+	, node_limit(0)
+	, map_width(0)
+	, map_height(0)
+	, generation(0)
 {
-	nodes.resize(node_limit, NULL);
+}
+
+AStarContainer::~AStarContainer() {
+}
+
+void AStarContainer::reset(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit) {
+	if (_map_width != map_width || _map_height != map_height) {
+		map_width = _map_width;
+		map_height = _map_height;
+		nodes.assign(map_width * map_height, AStarNode());
+		tile_states.assign(map_width * map_height, TileState());
+		generation = 0;
+	}
 
-	//initialise the map array. A -1 value will mean there is no node at that position
-	map_pos.resize(map_width);
-	for (unsigned i=0; i<map_width; ++i) {
-		map_pos[i].resize(map_height, -1);
+	node_limit = _node_limit;
+	if (open_heap.size() < node_limit) {
+		open_heap.resize(node_limit, -1);
+		close_list.resize(node_limit, -1);
+	}
+
+	open_size = 0;
+	close_size = 0;
+
+	// a new generation invalidates every tile from previous searches
+	generation++;
+	if (generation == 0) {
+		for (size_t i = 0; i < tile_states.size(); ++i) {
+			tile_states[i].generation = 0;
+		}
+		generation = 1;
 	}
 }
 
-AStarContainer::~AStarContainer() {
-	for(unsigned int i=0; i<size; i++)
-		delete nodes[i];
-	nodes.clear();
+int AStarContainer::tileIndex(int x, int y) const {
+	return y * static_cast<int>(map_width) + x;
 }
 
-int AStarContainer::getSize() {
-	return size;
+void AStarContainer::setHeapNode(unsigned int index, int tile) {
+	open_heap[index] = tile;
+	tile_states[tile].heap_index = static_cast<int>(index);
 }
 
-void AStarContainer::add(AStarNode* node) {
-	if (size >= node_limit) return;
+int AStarContainer::getOpenSize() {
+	return open_size;
+}
+
+int AStarContainer::getCloseSize() {
+	return close_size;
+}
+
+bool AStarContainer::isOpenEmpty() {
+	return open_size == 0;
+}
+
+void AStarContainer::addOpen(const Point& pos, const Point& parent_pos, float g, float h) {
+	if (open_size >= node_limit) return;
+
+	int tile = tileIndex(pos.x, pos.y);
+	nodes[tile] = AStarNode(pos);
+	nodes[tile].setParent(parent_pos);
+	nodes[tile].setActualCost(g);
+	nodes[tile].setEstimatedCost(h);
+	tile_states[tile].generation = generation;
+	tile_states[tile].state = STATE_OPEN;
 
 	//add the new node at the end and update its index
-	nodes[size] = node;
-	map_pos[node->getX()][node->getY()] = static_cast<short>(size);
+	setHeapNode(open_size, tile);
 
 	//reorder the heap based on f ordering, staring with thenewly added node and working up the tree from there
-	int m = size;
-
-	AStarNode* temp = NULL;
+	unsigned int m = open_size;
 	while(m != 0) {
 		//if the current nodes f value is shorter than its parent, they need to be swapped
-		if(nodes[m]->getFinalCost() <= nodes[m/2]->getFinalCost()) {
-			temp = nodes[m/2];
-			nodes[m/2] = nodes[m];
-			map_pos[nodes[m/2]->getX()][nodes[m/2]->getY()] = static_cast<short>(m/2);
-			nodes[m] = temp;
-			map_pos[nodes[m]->getX()][nodes[m]->getY()] = static_cast<short>(m);
+		if(nodes[open_heap[m]].getFinalCost() <= nodes[open_heap[m/2]].getFinalCost()) {
+			int temp = open_heap[m/2];
+			setHeapNode(m/2, open_heap[m]);
+			setHeapNode(m, temp);
 			m=m/2;
 		}
 		else
 			break;
 	}
-	size++;
+	open_size++;
 }
 
-AStarNode* AStarContainer::get_shortest_f() {
-	return nodes[0];
+AStarNode* AStarContainer::getShortestF() {
+	return &nodes[open_heap[0]];
 }
 
-void AStarContainer::remove(AStarNode* node) {
+void AStarContainer::close(AStarNode* node) {
+	int tile = tileIndex(node->getX(), node->getY());
 
-	unsigned int heap_indexv = map_pos[node->getX()][node->getY()] + 1;
+	if (close_size < node_limit) {
+		close_list[close_size] = tile;
+		close_size++;
+	}
 
+	removeHeapNode(tile_states[tile].heap_index + 1);
+
+	tile_states[tile].heap_index = -1;
+	tile_states[tile].state = STATE_CLOSED;
+}
+
+void AStarContainer::removeHeapNode(unsigned int heap_indexv) {
 	//swap the last node in the list with the node being deleted
-	nodes[heap_indexv-1] = nodes[size-1];
-	map_pos[nodes[heap_indexv-1]->getX()][nodes[heap_indexv-1]->getY()] = static_cast<short>(heap_indexv-1);
+	setHeapNode(heap_indexv-1, open_heap[open_size-1]);
 
-	size--;
+	open_size--;
 
-	if(size == 0) {
-		map_pos[node->getX()][node->getY()] = -1;
+	if(open_size == 0)
 		return;
-	}
 
 	// reorder the heap to maintain the f ordering, starting at the node which replaced the deleted node, and working down the tree
 
 	while(true) {
 		//start at the node which dropped down the tree on the previous iteration
 		unsigned int heap_indexu = heap_indexv;
-		if(2*heap_indexu+1 <= size) { //if both children exist
+		if(2*heap_indexu+1 <= open_size) { //if both children exist
 			//Select the lowest of the two children.
-			if(nodes[heap_indexu-1]->getFinalCost() >= nodes[2*heap_indexu-1]->getFinalCost()) heap_indexv = 2*heap_indexu;
-			if(nodes[heap_indexv-1]->getFinalCost() >= nodes[2*heap_indexu]->getFinalCost()) heap_indexv = 2*heap_indexu+1;
+			if(nodes[open_heap[heap_indexu-1]].getFinalCost() >= nodes[open_heap[2*heap_indexu-1]].getFinalCost()) heap_indexv = 2*heap_indexu;
+			if(nodes[open_heap[heap_indexv-1]].getFinalCost() >= nodes[open_heap[2*heap_indexu]].getFinalCost()) heap_indexv = 2*heap_indexu+1;
 		}
-		else if (2*heap_indexu <= size) { //if only child #1 exists
+		else if (2*heap_indexu <= open_size) { //if only child #1 exists
 			//Check if the F cost is greater than the child
-			if(nodes[heap_indexu-1]->getFinalCost() >= nodes[2*heap_indexu-1]->getFinalCost()) heap_indexv = 2*heap_indexu;
+			if(nodes[open_heap[heap_indexu-1]].getFinalCost() >= nodes[open_heap[2*heap_indexu-1]].getFinalCost()) heap_indexv = 2*heap_indexu;
 		}
 
 		if(heap_indexu != heap_indexv) { //If parent's F > one or both of its children, swap them
-			AStarNode* temp = nodes[heap_indexu-1];
-			nodes[heap_indexu-1] = nodes[heap_indexv-1];
-			map_pos[nodes[heap_indexu-1]->getX()][nodes[heap_indexu-1]->getY()] = static_cast<short>(heap_indexu-1);
-			nodes[heap_indexv-1] = temp;
-			map_pos[nodes[heap_indexv-1]->getX()][nodes[heap_indexv-1]->getY()] = static_cast<short>(heap_indexv-1);
+			int temp = open_heap[heap_indexu-1];
+			setHeapNode(heap_indexu-1, open_heap[heap_indexv-1]);
+			setHeapNode(heap_indexv-1, temp);
 		}
 		else {
 			break;//if item <= both children, exit loop
 		}
 	}//Repeat forever
-
-	//remove the node from the map pos index
-	map_pos[node->getX()][node->getY()] = -1;
-}
-
-bool AStarContainer::exists(const Point& pos) {
-	return map_pos[pos.x][pos.y] != -1;
-}
-
-AStarNode* AStarContainer::get(int x, int y) {
-	return nodes[map_pos[x][y]];
-}
-
-bool AStarContainer::isEmpty() {
-	return size == 0;
 }
 
 void AStarContainer::updateParent(const Point& pos, const Point& parent_pos, float score) {
-	get(pos.x, pos.y)->setParent(parent_pos);
-	get(pos.x, pos.y)->setActualCost(score);
+	int tile = tileIndex(pos.x, pos.y);
+	nodes[tile].setParent(parent_pos);
+	nodes[tile].setActualCost(score);
 
 	//reorder the heap based on the new f value of this node. starting at the updated node and working up the tree
-	int m = map_pos[pos.x][pos.y];
-	AStarNode* temp = NULL;
+	unsigned int m = tile_states[tile].heap_index;
 	while(m != 0) {
 		//if the current node has a lower f value than its parent in the heap, swap them
-		if(nodes[m]->getFinalCost() <= nodes[m/2]->getFinalCost()) {
-			temp = nodes[m/2];
-			nodes[m/2] = nodes[m];
-			map_pos[nodes[m/2]->getX()][nodes[m/2]->getY()] = static_cast<short>(m/2);
-			nodes[m] = temp;
-			map_pos[nodes[m]->getX()][nodes[m]->getY()] = static_cast<short>(m);
+		if(nodes[open_heap[m]].getFinalCost() <= nodes[open_heap[m/2]].getFinalCost()) {
+			int temp = open_heap[m/2];
+			setHeapNode(m/2, open_heap[m]);
+			setHeapNode(m, temp);
 			m=m/2;
 		}
 		else
@@ -156,54 +185,27 @@ void AStarContainer::updateParent(const Point& pos, const Point& parent_pos, flo
 	}
 }
 
-AStarCloseContainer::AStarCloseContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit)
-	: size(0)
-	, node_limit(_node_limit)
-	, map_width(_map_width)
-	, map_height(_map_height)
-{
-	nodes.resize(node_limit, NULL);
-
-	//initialise the map array. A -1 value will mean there is no node at that position
-	map_pos.resize(map_width);
-	for (unsigned i=0; i<map_width; ++i) {
-		map_pos[i].resize(map_height, -1);
-	}
-}
-
-AStarCloseContainer::~AStarCloseContainer() {
-	for(unsigned int i=0; i<size; i++)
-		delete nodes[i];
-	nodes.clear();
-}
-
-int AStarCloseContainer::getSize() {
-	return size;
+bool AStarContainer::isOpen(const Point& pos) {
+	const TileState& ts = tile_states[tileIndex(pos.x, pos.y)];
+	return ts.generation == generation && ts.state == STATE_OPEN;
 }
 
-void AStarCloseContainer::add(AStarNode* node) {
-	if (size >= node_limit) return;
-
-	nodes[size] = node;
-	map_pos[node->getX()][node->getY()] = static_cast<short>(size);
-	size++;
+bool AStarContainer::isClosed(const Point& pos) {
+	const TileState& ts = tile_states[tileIndex(pos.x, pos.y)];
+	return ts.generation == generation && ts.state == STATE_CLOSED;
 }
 
-bool AStarCloseContainer::exists(const Point& pos) {
-	return map_pos[pos.x][pos.y] != -1;
-}
-
-AStarNode* AStarCloseContainer::get(int x, int y) {
-	return nodes[map_pos[x][y]];
+AStarNode* AStarContainer::get(int x, int y) {
+	return &nodes[tileIndex(x, y)];
 }
 
-AStarNode* AStarCloseContainer::get_shortest_h() {
+AStarNode* AStarContainer::getShortestH() {
 	AStarNode *current = NULL;
 	float lowest_score = FLT_MAX;
-	for(unsigned int i = 0; i < size; i++) {
-		if(nodes[i]->getH() < lowest_score) {
-			lowest_score = nodes[i]->getH();
-			current = nodes[i];
+	for(unsigned int i = 0; i < close_size; i++) {
+		if(nodes[close_list[i]].getH() < lowest_score) {
+			lowest_score = nodes[close_list[i]].getH();
+			current = &nodes[close_list[i]];
 		}
 	}
 	return current;
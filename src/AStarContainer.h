@@ -22,40 +22,73 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "AStarNode.h"
 
-typedef std::vector< std::vector<short> > AStar_Grid;
-
-/* Designed to be used for the Open nodes.
-*  Unsuitable for Closed nodes but a close node conatiner is declared below
+/* Holds both the open and the closed node lists used by MapCollision::computePath.
+*  A single instance is owned by MapCollision and reused for every search, so no memory is allocated per path.
+*
+*  Nodes are stored in a flat array with one slot per map tile (index = y * map_width + x).
+*  Each slot carries a generation stamp; a slot only counts as part of the current search if its stamp matches the
+*  current generation. Starting a new search is therefore just a matter of incrementing the generation.
 *
 *  All code in the class assumes that the nodes and points provided are within the bounds of the map limits
 */
 class AStarContainer {
 public:
-	AStarContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit);
-	AStarContainer(const AStarContainer&); // copy constructor not yet implemented
-
+	AStarContainer();
 	~AStarContainer();
-	int getSize();
-	//assumes that the node is not already in the collection
-	void add(AStarNode* node);
-	//assumes that there is at least 1 node in the collection
-	AStarNode* get_shortest_f();
-	//assumes that the node exists in the collection
-	void remove(AStarNode* node);
-	bool exists(const Point& pos);
-	//assumes that the node exists in the collection
-	AStarNode* get(int x, int y);
-	bool isEmpty();
+
+	// prepares the container for a new search. Buffers are only reallocated when the map or node limit grows
+	void reset(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit);
+
+	int getOpenSize();
+	int getCloseSize();
+	bool isOpenEmpty();
+
+	//assumes that the position is not already in the open or closed list
+	void addOpen(const Point& pos, const Point& parent_pos, float g, float h);
+	//assumes that there is at least 1 node in the open list
+	AStarNode* getShortestF();
+	//assumes that the node exists in the open list. The node is moved to the closed list
+	void close(AStarNode* node);
+	//assumes that the node exists in the open list
 	void updateParent(const Point& pos, const Point& parent_pos, float score);
 
+	bool isOpen(const Point& pos);
+	bool isClosed(const Point& pos);
+
+	//assumes that the node exists in either the open or the closed list
+	AStarNode* get(int x, int y);
+	AStarNode* getShortestH();
+
 private:
-	unsigned int size;
+	enum {
+		STATE_OPEN = 0,
+		STATE_CLOSED = 1
+	};
+
+	class TileState {
+	public:
+		unsigned int generation;
+		int heap_index;
+		int state;
+		TileState() : generation(0), heap_index(-1), state(STATE_OPEN) {}
+	};
+
+	int tileIndex(int x, int y) const;
+	void setHeapNode(unsigned int index, int tile);
+	void removeHeapNode(unsigned int heap_indexv);
+
+	unsigned int open_size;
+	unsigned int close_size;
 	unsigned int node_limit;
 	unsigned int map_width;
 	unsigned int map_height;
+	unsigned int generation;
 
-	/* This is an array of AStarNode pointers. This is the main data for this collection.
-	*  The size of the array is based on the node limit.
+	// per-tile node data and bookkeeping. Valid only when tile_states[i].generation == generation
+	std::vector<AStarNode> nodes;
+	std::vector<TileState> tile_states;
+
+	/* This is an array of tile indices forming the open list. The size of the array is based on the node limit.
 	*
 	*  The nodes in this array are ordered based on their f value and the node with the lowest f value is always at position 0.
 	*  The ordering is not linear, so after positon 0, we cannot assume that position 1 has the second shortest f value.
@@ -72,41 +105,10 @@ private:
 	*  Also note that the code within the article is based on arrays with starting position 1, whereas we use 0 based arrays.
 	*  http://www.policyalmanac.org/games/binaryHeaps.htm
 	*/
-	std::vector<AStarNode*> nodes;
-
-	/* This is a 2d array of shorts ([map_width][map_height]) which acts as an index for the main node array.
-	*  Elements can be accessed using cartesian coordinates e.g. map_pos[x][y]
-	*  To access an AStarNode based on map position use: nodes[map_pos[x][y]]
-	*
-	*  The data in this array is initialised as -1, which indicates hat there is no corresponding node for that position
-	*  This must be maintained when nodes are added, removed and re-ordered in the node array
-	*/
-	AStar_Grid map_pos;
-};
-
-/* This class is used to store the closed list of a* nodes
-*  The nodes within this class have no ordering but stil have a map position index
-*/
-class AStarCloseContainer {
-public:
-	AStarCloseContainer(unsigned int _map_width, unsigned int _map_height, unsigned int _node_limit);
-	AStarCloseContainer(const AStarCloseContainer&); // copy constructor not yet implemented
-	~AStarCloseContainer();
-
-	int getSize();
-	void add(AStarNode* node);
-	bool exists(const Point& pos);
-	AStarNode* get(int x, int y);
-	AStarNode* get_shortest_h();
-
-private:
-	unsigned int size;
-	unsigned int node_limit;
-	unsigned int map_width;
-	unsigned int map_height;
-	std::vector<AStarNode*> nodes;
-	AStar_Grid map_pos;
+	std::vector<int> open_heap;
 
+	// tile indices of closed nodes, in the order they were closed
+	std::vector<int> close_list;
 };
 
 #endif // ASTARCONTAINER_H
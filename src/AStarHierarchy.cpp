@@ -0,0 +1,458 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "AStarHierarchy.h"
+#include "AStarNode.h"
+#include "MapCollision.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <functional>
+
+AStarHierarchy::AStarHierarchy(const MapCollision* _collider)
+	: collider(_collider)
+	, map_w(0)
+	, map_h(0)
+	, clusters_w(0)
+	, clusters_h(0)
+	, dirty(false)
+	, generation(0)
+{
+}
+
+AStarHierarchy::~AStarHierarchy() {
+}
+
+void AStarHierarchy::build() {
+	map_w = collider->map_size.x;
+	map_h = collider->map_size.y;
+	clusters_w = (map_w + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+	clusters_h = (map_h + CLUSTER_SIZE - 1) / CLUSTER_SIZE;
+
+	dirty = false;
+	dirty_clusters.assign(clusters_w * clusters_h, false);
+
+	if (!isEnabled()) {
+		for (int g = 0; g < GRAPH_COUNT; ++g) {
+			graphs[g].borders_h.clear();
+			graphs[g].borders_v.clear();
+			graphs[g].clusters.clear();
+		}
+		search_generation.clear();
+		search_g.clear();
+		search_parent.clear();
+		search_closed.clear();
+		return;
+	}
+
+	local_dist.resize(CLUSTER_SIZE * CLUSTER_SIZE);
+
+	search_generation.assign(map_w * map_h, 0);
+	search_g.resize(map_w * map_h);
+	search_parent.resize(map_w * map_h);
+	search_closed.resize(map_w * map_h);
+	generation = 0;
+
+	for (int g = 0; g < GRAPH_COUNT; ++g) {
+		graphs[g].borders_h.assign(clusters_w * clusters_h, std::vector<Transition>());
+		graphs[g].borders_v.assign(clusters_w * clusters_h, std::vector<Transition>());
+		graphs[g].clusters.assign(clusters_w * clusters_h, Cluster());
+
+		for (int cy = 0; cy < clusters_h; ++cy) {
+			for (int cx = 0; cx < clusters_w; ++cx) {
+				buildBorder(g, cx, cy, true);
+				buildBorder(g, cx, cy, false);
+			}
+		}
+
+		for (int cy = 0; cy < clusters_h; ++cy) {
+			for (int cx = 0; cx < clusters_w; ++cx) {
+				buildCluster(g, cx, cy);
+			}
+		}
+	}
+}
+
+void AStarHierarchy::invalidate(int tile_x, int tile_y) {
+	if (!isEnabled() || tile_x < 0 || tile_y < 0 || tile_x >= map_w || tile_y >= map_h)
+		return;
+
+	dirty_clusters[clusterIndex(tile_x, tile_y)] = true;
+	dirty = true;
+}
+
+bool AStarHierarchy::isEnabled() const {
+	return clusters_w * clusters_h > 1;
+}
+
+Rect AStarHierarchy::getClusterRect(const Point& tile) const {
+	Rect r;
+	r.x = (tile.x / CLUSTER_SIZE) * CLUSTER_SIZE;
+	r.y = (tile.y / CLUSTER_SIZE) * CLUSTER_SIZE;
+	r.w = std::min(CLUSTER_SIZE, map_w - r.x);
+	r.h = std::min(CLUSTER_SIZE, map_h - r.y);
+	return r;
+}
+
+int AStarHierarchy::graphIndex(int movement_type) const {
+	if (movement_type == MapCollision::MOVE_NORMAL)
+		return 0;
+	else if (movement_type == MapCollision::MOVE_FLYING)
+		return 1;
+
+	return -1;
+}
+
+int AStarHierarchy::clusterIndex(int tile_x, int tile_y) const {
+	return (tile_y / CLUSTER_SIZE) * clusters_w + (tile_x / CLUSTER_SIZE);
+}
+
+int AStarHierarchy::tileIndex(int tile_x, int tile_y) const {
+	return tile_y * map_w + tile_x;
+}
+
+Point AStarHierarchy::tilePoint(int tile_index) const {
+	return Point(tile_index % map_w, tile_index / map_w);
+}
+
+bool AStarHierarchy::isPassable(int tile_x, int tile_y, int graph) const {
+	return collider->isValidTileStatic(tile_x, tile_y, graph == 1 ? MapCollision::MOVE_FLYING : MapCollision::MOVE_NORMAL);
+}
+
+/**
+ * Places transitions on the border between cluster (cx, cy) and its right (horizontal == true) or bottom neighbour
+ */
+void AStarHierarchy::buildBorder(int graph, int cx, int cy, bool horizontal) {
+	std::vector<Transition>& border = horizontal ? graphs[graph].borders_h[cy * clusters_w + cx] : graphs[graph].borders_v[cy * clusters_w + cx];
+	border.clear();
+
+	if ((horizontal && cx + 1 >= clusters_w) || (!horizontal && cy + 1 >= clusters_h))
+		return;
+
+	// the line of tiles on this side of the border, and the step to the other side
+	Point first, step, other;
+	int length;
+	if (horizontal) {
+		first = Point((cx + 1) * CLUSTER_SIZE - 1, cy * CLUSTER_SIZE);
+		step = Point(0, 1);
+		other = Point(1, 0);
+		length = std::min(CLUSTER_SIZE, map_h - first.y);
+	}
+	else {
+		first = Point(cx * CLUSTER_SIZE, (cy + 1) * CLUSTER_SIZE - 1);
+		step = Point(1, 0);
+		other = Point(0, 1);
+		length = std::min(CLUSTER_SIZE, map_w - first.x);
+	}
+
+	int segment_start = -1;
+	for (int i = 0; i <= length; ++i) {
+		bool open = false;
+		if (i < length) {
+			Point a(first.x + step.x * i, first.y + step.y * i);
+			open = isPassable(a.x, a.y, graph) && isPassable(a.x + other.x, a.y + other.y, graph);
+		}
+
+		if (open && segment_start == -1) {
+			segment_start = i;
+		}
+		else if (!open && segment_start != -1) {
+			int segment_end = i - 1;
+			if (segment_end - segment_start + 1 < MAX_SINGLE_TRANSITION_LENGTH) {
+				int mid = (segment_start + segment_end) / 2;
+				Point a(first.x + step.x * mid, first.y + step.y * mid);
+				border.push_back(Transition(a, Point(a.x + other.x, a.y + other.y)));
+			}
+			else {
+				Point a(first.x + step.x * segment_start, first.y + step.y * segment_start);
+				border.push_back(Transition(a, Point(a.x + other.x, a.y + other.y)));
+				a = Point(first.x + step.x * segment_end, first.y + step.y * segment_end);
+				border.push_back(Transition(a, Point(a.x + other.x, a.y + other.y)));
+			}
+			segment_start = -1;
+		}
+	}
+}
+
+/**
+ * Collects the transition nodes of a cluster from its four borders and computes the distances between them
+ */
+void AStarHierarchy::buildCluster(int graph, int cx, int cy) {
+	Graph& gr = graphs[graph];
+	Cluster& cluster = gr.clusters[cy * clusters_w + cx];
+	cluster.nodes.clear();
+	cluster.dist.clear();
+	cluster.links.clear();
+
+	// gather (own tile, other tile) pairs from all four borders
+	std::vector< std::pair<Point, Point> > pairs;
+	const std::vector<Transition>& right = gr.borders_h[cy * clusters_w + cx];
+	for (size_t i = 0; i < right.size(); ++i)
+		pairs.push_back(std::pair<Point, Point>(right[i].a, right[i].b));
+	const std::vector<Transition>& bottom = gr.borders_v[cy * clusters_w + cx];
+	for (size_t i = 0; i < bottom.size(); ++i)
+		pairs.push_back(std::pair<Point, Point>(bottom[i].a, bottom[i].b));
+	if (cx > 0) {
+		const std::vector<Transition>& left = gr.borders_h[cy * clusters_w + cx - 1];
+		for (size_t i = 0; i < left.size(); ++i)
+			pairs.push_back(std::pair<Point, Point>(left[i].b, left[i].a));
+	}
+	if (cy > 0) {
+		const std::vector<Transition>& top = gr.borders_v[(cy - 1) * clusters_w + cx];
+		for (size_t i = 0; i < top.size(); ++i)
+			pairs.push_back(std::pair<Point, Point>(top[i].b, top[i].a));
+	}
+
+	for (size_t i = 0; i < pairs.size(); ++i) {
+		int tile = tileIndex(pairs[i].first.x, pairs[i].first.y);
+		std::vector<int>::iterator it = std::find(cluster.nodes.begin(), cluster.nodes.end(), tile);
+		int node_index = static_cast<int>(it - cluster.nodes.begin());
+		if (it == cluster.nodes.end())
+			cluster.nodes.push_back(tile);
+
+		cluster.links.push_back(std::pair<int, int>(node_index, tileIndex(pairs[i].second.x, pairs[i].second.y)));
+	}
+
+	size_t node_count = cluster.nodes.size();
+	cluster.dist.resize(node_count * node_count, -1);
+
+	Rect bounds(cx * CLUSTER_SIZE, cy * CLUSTER_SIZE, std::min(CLUSTER_SIZE, map_w - cx * CLUSTER_SIZE), std::min(CLUSTER_SIZE, map_h - cy * CLUSTER_SIZE));
+	for (size_t i = 0; i < node_count; ++i) {
+		computeClusterDistances(graph, tilePoint(cluster.nodes[i]), bounds);
+		for (size_t j = 0; j < node_count; ++j) {
+			cluster.dist[i * node_count + j] = getClusterDistance(tilePoint(cluster.nodes[j]), bounds);
+		}
+	}
+}
+
+/**
+ * Applies pending invalidate() calls
+ */
+void AStarHierarchy::rebuildDirty() {
+	if (!dirty)
+		return;
+
+	std::vector<bool> rebuild(clusters_w * clusters_h, false);
+
+	for (int cy = 0; cy < clusters_h; ++cy) {
+		for (int cx = 0; cx < clusters_w; ++cx) {
+			if (!dirty_clusters[cy * clusters_w + cx])
+				continue;
+
+			for (int g = 0; g < GRAPH_COUNT; ++g) {
+				buildBorder(g, cx, cy, true);
+				buildBorder(g, cx, cy, false);
+				if (cx > 0) buildBorder(g, cx - 1, cy, true);
+				if (cy > 0) buildBorder(g, cx, cy - 1, false);
+			}
+
+			// changing a border changes the nodes on both sides of it
+			rebuild[cy * clusters_w + cx] = true;
+			if (cx > 0) rebuild[cy * clusters_w + cx - 1] = true;
+			if (cy > 0) rebuild[(cy - 1) * clusters_w + cx] = true;
+			if (cx + 1 < clusters_w) rebuild[cy * clusters_w + cx + 1] = true;
+			if (cy + 1 < clusters_h) rebuild[(cy + 1) * clusters_w + cx] = true;
+
+			dirty_clusters[cy * clusters_w + cx] = false;
+		}
+	}
+
+	for (int cy = 0; cy < clusters_h; ++cy) {
+		for (int cx = 0; cx < clusters_w; ++cx) {
+			if (!rebuild[cy * clusters_w + cx])
+				continue;
+
+			for (int g = 0; g < GRAPH_COUNT; ++g) {
+				buildCluster(g, cx, cy);
+			}
+		}
+	}
+
+	dirty = false;
+}
+
+/**
+ * Dijkstra search from origin, restricted to the tiles within bounds
+ * Results are read with getClusterDistance()
+ */
+void AStarHierarchy::computeClusterDistances(int graph, const Point& origin, const Rect& bounds) {
+	std::fill(local_dist.begin(), local_dist.end(), FLT_MAX);
+	local_heap.clear();
+
+	Point neighbours[AStarNode::MAX_NEIGHBOURS];
+
+	local_dist[(origin.y - bounds.y) * CLUSTER_SIZE + (origin.x - bounds.x)] = 0;
+	local_heap.push_back(std::pair<float, int>(0, tileIndex(origin.x, origin.y)));
+
+	while (!local_heap.empty()) {
+		std::pop_heap(local_heap.begin(), local_heap.end(), std::greater< std::pair<float, int> >());
+		std::pair<float, int> top = local_heap.back();
+		local_heap.pop_back();
+
+		Point current = tilePoint(top.second);
+		if (top.first > local_dist[(current.y - bounds.y) * CLUSTER_SIZE + (current.x - bounds.x)])
+			continue;
+
+		int neighbour_count = AStarNode(current).getNeighbours(neighbours, map_w, map_h);
+		for (int i = 0; i < neighbour_count; ++i) {
+			const Point& n = neighbours[i];
+			if (n.x < bounds.x || n.y < bounds.y || n.x >= bounds.x + bounds.w || n.y >= bounds.y + bounds.h)
+				continue;
+			if (!isPassable(n.x, n.y, graph))
+				continue;
+
+			float d = top.first + Utils::calcDist(FPoint(current), FPoint(n));
+			float& nd = local_dist[(n.y - bounds.y) * CLUSTER_SIZE + (n.x - bounds.x)];
+			if (d < nd) {
+				nd = d;
+				local_heap.push_back(std::pair<float, int>(d, tileIndex(n.x, n.y)));
+				std::push_heap(local_heap.begin(), local_heap.end(), std::greater< std::pair<float, int> >());
+			}
+		}
+	}
+}
+
+float AStarHierarchy::getClusterDistance(const Point& tile, const Rect& bounds) const {
+	float d = local_dist[(tile.y - bounds.y) * CLUSTER_SIZE + (tile.x - bounds.x)];
+	return (d == FLT_MAX) ? -1 : d;
+}
+
+void AStarHierarchy::relax(int tile, int parent, float g, const Point& end) {
+	if (search_generation[tile] != generation) {
+		search_generation[tile] = generation;
+		search_g[tile] = FLT_MAX;
+		search_closed[tile] = false;
+	}
+
+	if (search_closed[tile] || g >= search_g[tile])
+		return;
+
+	search_g[tile] = g;
+	search_parent[tile] = parent;
+
+	float f = g + Utils::calcDist(FPoint(tilePoint(tile)), FPoint(end));
+	search_heap.push_back(std::pair<float, int>(f, tile));
+	std::push_heap(search_heap.begin(), search_heap.end(), std::greater< std::pair<float, int> >());
+}
+
+bool AStarHierarchy::findPath(const Point& start, const Point& end, int movement_type, unsigned int limit, std::vector<Point>& waypoints) {
+	waypoints.clear();
+
+	int graph = graphIndex(movement_type);
+	if (!isEnabled() || graph == -1)
+		return false;
+
+	rebuildDirty();
+
+	generation++;
+	if (generation == 0) {
+		std::fill(search_generation.begin(), search_generation.end(), 0);
+		generation = 1;
+	}
+	search_heap.clear();
+
+	const Graph& gr = graphs[graph];
+	const int start_tile = tileIndex(start.x, start.y);
+	const int end_tile = tileIndex(end.x, end.y);
+	const int start_cluster = clusterIndex(start.x, start.y);
+	const int end_cluster = clusterIndex(end.x, end.y);
+
+	// connect the start and end positions to the transition nodes of their clusters
+	Rect start_bounds = getClusterRect(start);
+	computeClusterDistances(graph, start, start_bounds);
+
+	const std::vector<int>& start_nodes = gr.clusters[start_cluster].nodes;
+	std::vector<float> start_dist(start_nodes.size());
+	for (size_t i = 0; i < start_nodes.size(); ++i)
+		start_dist[i] = getClusterDistance(tilePoint(start_nodes[i]), start_bounds);
+
+	float direct_dist = (start_cluster == end_cluster) ? getClusterDistance(end, start_bounds) : -1;
+
+	Rect end_bounds = getClusterRect(end);
+	computeClusterDistances(graph, end, end_bounds);
+
+	const std::vector<int>& end_nodes = gr.clusters[end_cluster].nodes;
+	std::vector<float> end_dist(end_nodes.size());
+	for (size_t i = 0; i < end_nodes.size(); ++i)
+		end_dist[i] = getClusterDistance(tilePoint(end_nodes[i]), end_bounds);
+
+	relax(start_tile, -1, 0, end);
+
+	bool found = false;
+	unsigned int expanded = 0;
+
+	while (!search_heap.empty() && expanded < limit) {
+		std::pop_heap(search_heap.begin(), search_heap.end(), std::greater< std::pair<float, int> >());
+		int tile = search_heap.back().second;
+		search_heap.pop_back();
+
+		if (search_closed[tile])
+			continue;
+		search_closed[tile] = true;
+		expanded++;
+
+		if (tile == end_tile) {
+			found = true;
+			break;
+		}
+
+		float g = search_g[tile];
+
+		if (tile == start_tile) {
+			for (size_t i = 0; i < start_nodes.size(); ++i) {
+				if (start_dist[i] >= 0)
+					relax(start_nodes[i], tile, start_dist[i], end);
+			}
+			if (direct_dist >= 0)
+				relax(end_tile, tile, direct_dist, end);
+		}
+
+		Point pos = tilePoint(tile);
+		int cluster_index = clusterIndex(pos.x, pos.y);
+		const Cluster& cluster = gr.clusters[cluster_index];
+
+		std::vector<int>::const_iterator it = std::find(cluster.nodes.begin(), cluster.nodes.end(), tile);
+		if (it == cluster.nodes.end())
+			continue;
+
+		size_t node_index = it - cluster.nodes.begin();
+		size_t node_count = cluster.nodes.size();
+
+		for (size_t j = 0; j < node_count; ++j) {
+			float d = cluster.dist[node_index * node_count + j];
+			if (j != node_index && d >= 0)
+				relax(cluster.nodes[j], tile, g + d, end);
+		}
+
+		// transitions to the neighbouring clusters are always between orthogonally adjacent tiles
+		for (size_t j = 0; j < cluster.links.size(); ++j) {
+			if (cluster.links[j].first == static_cast<int>(node_index))
+				relax(cluster.links[j].second, tile, g + 1, end);
+		}
+
+		if (cluster_index == end_cluster && end_dist[node_index] >= 0)
+			relax(end_tile, tile, g + end_dist[node_index], end);
+	}
+
+	if (!found)
+		return false;
+
+	for (int tile = end_tile; tile != -1; tile = search_parent[tile]) {
+		waypoints.push_back(tilePoint(tile));
+	}
+	std::reverse(waypoints.begin(), waypoints.end());
+
+	return true;
+}
@@ -0,0 +1,134 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class AStarHierarchy
+ *
+ * Abstract cluster graph over the collision map, used by MapCollision::computePath to plan long routes (HPA*).
+ *
+ * The map is split into square clusters. Wherever two neighbouring clusters share walkable border tiles, one or two
+ * "transition" nodes are placed on each side of the border. Within a cluster, the walking distance between each pair
+ * of its transition nodes is precomputed. Searching this graph yields a list of waypoints, and only the short segments
+ * between consecutive waypoints need a regular tile-level search.
+ *
+ * Only static collision is considered. Tiles blocked by entities (see MapCollision::block()) are treated as walkable.
+ */
+
+#ifndef ASTARHIERARCHY_H
+#define ASTARHIERARCHY_H
+
+#include <vector>
+
+#include "Utils.h"
+
+class MapCollision;
+
+class AStarHierarchy {
+public:
+	// width and height of a cluster, in tiles
+	static const int CLUSTER_SIZE = 16;
+
+	explicit AStarHierarchy(const MapCollision* _collider);
+	~AStarHierarchy();
+
+	// (re)build the whole graph from the collider's map
+	void build();
+
+	// marks the cluster containing the tile as needing a rebuild
+	void invalidate(int tile_x, int tile_y);
+
+	// returns true if the map is large enough for the graph to be useful
+	bool isEnabled() const;
+
+	// gets the cluster boundaries, in tiles, for the cluster that contains the given tile
+	Rect getClusterRect(const Point& tile) const;
+
+	// finds a list of waypoints from start to end, both included. Consecutive waypoints are either adjacent tiles or
+	// within the same cluster. Returns false if the end can't be reached
+	bool findPath(const Point& start, const Point& end, int movement_type, unsigned int limit, std::vector<Point>& waypoints);
+
+private:
+	// there are separate graphs for MOVE_NORMAL and MOVE_FLYING. MOVE_INTANGIBLE doesn't need pathfinding
+	static const int GRAPH_COUNT = 2;
+
+	// if a walkable stretch of border is at least this long, place a transition at each end of it
+	static const int MAX_SINGLE_TRANSITION_LENGTH = 6;
+
+	class Transition {
+	public:
+		Point a; // tile in the left/top cluster
+		Point b; // tile in the right/bottom cluster
+		Transition(const Point& _a, const Point& _b) : a(_a), b(_b) {}
+	};
+
+	class Cluster {
+	public:
+		// transition tiles of this cluster, stored as tile indices
+		std::vector<int> nodes;
+		// nodes.size() * nodes.size() walking distances between nodes. Negative if unreachable
+		std::vector<float> dist;
+		// pairs of (index in nodes, tile index in the neighbouring cluster)
+		std::vector< std::pair<int, int> > links;
+	};
+
+	class Graph {
+	public:
+		// borders between (cx, cy) and (cx+1, cy)
+		std::vector< std::vector<Transition> > borders_h;
+		// borders between (cx, cy) and (cx, cy+1)
+		std::vector< std::vector<Transition> > borders_v;
+		std::vector<Cluster> clusters;
+	};
+
+	int graphIndex(int movement_type) const;
+	int clusterIndex(int tile_x, int tile_y) const;
+	int tileIndex(int tile_x, int tile_y) const;
+	Point tilePoint(int tile_index) const;
+
+	bool isPassable(int tile_x, int tile_y, int graph) const;
+	void buildBorder(int graph, int cx, int cy, bool horizontal);
+	void buildCluster(int graph, int cx, int cy);
+	void rebuildDirty();
+	void computeClusterDistances(int graph, const Point& origin, const Rect& bounds);
+	float getClusterDistance(const Point& tile, const Rect& bounds) const;
+
+	// abstract search helpers
+	void relax(int tile, int parent, float g, const Point& end);
+
+	const MapCollision* collider;
+
+	int map_w;
+	int map_h;
+	int clusters_w;
+	int clusters_h;
+
+	Graph graphs[GRAPH_COUNT];
+	std::vector<bool> dirty_clusters;
+	bool dirty;
+
+	// scratch space for cluster-local Dijkstra searches
+	std::vector<float> local_dist;
+	std::vector< std::pair<float, int> > local_heap;
+
+	// scratch space for the abstract search, valid where search_generation[i] == generation
+	std::vector<unsigned int> search_generation;
+	std::vector<float> search_g;
+	std::vector<int> search_parent;
+	std::vector<bool> search_closed;
+	std::vector< std::pair<float, int> > search_heap;
+	unsigned int generation;
+};
+
+#endif // ASTARHIERARCHY_H
@@ -27,7 +27,6 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef ASTARNODE_H
 #define ASTARNODE_H
 
-#include <list>
 #include "Utils.h"
 
 const int node_stride = 1; // minimal stride between nodes
@@ -46,6 +45,8 @@ protected:
 	Point parent;
 
 public:
+	static const int MAX_NEIGHBOURS = 8;
+
 	AStarNode();
 	explicit AStarNode(const Point &p);
 
@@ -56,8 +57,9 @@ public:
 	Point getParent() const;
 	void setParent(const Point& p);
 
-	// return a list of coordinates of all neighbours
-	std::list<Point> getNeighbours(int limitX=0, int limitY=0) const;
+	// store the coordinates of all neighbours in the given array (which must hold at least MAX_NEIGHBOURS points)
+	// returns the number of neighbours found
+	int getNeighbours(Point* neighbours, int limitX=0, int limitY=0) const;
 
 	float getActualCost() const;
 	void setActualCost(const float G);
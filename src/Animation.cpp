@@ -59,6 +59,7 @@ Animation::Animation(const std::string &_name, const std::string &_type, Animati
 	, active_frames()
 	, sub_frames()
 	, name(_name)
+	, id(StringTable::get(_name))
 	, default_active_frames(true)
 {
 	if (type == ANIMTYPE_NONE)
@@ -400,10 +401,6 @@ int Animation::getTimesPlayed() {
 	return times_played;
 }
 
-std::string Animation::getName() {
-	return name;
-}
-
 int Animation::getDuration() {
 	return static_cast<int>(static_cast<float>(sub_frames.size()) / speed);
 }
@@ -34,6 +34,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CommonIncludes.h"
 #include "Utils.h"
 #include "AnimationMedia.h"
+#include "StringTable.h"
 
 class Animation {
 protected:
@@ -95,6 +96,7 @@ protected:
 	std::vector<unsigned short> sub_frames_last;
 
 	const std::string name;
+	const StringID id; // interned name
 
 	unsigned short getFirstSubFrame(const short &frame); // given a frame, gets the last sub frame that points to it
 	unsigned short getLastSubFrame(const short &frame); // given a frame, gets the last sub frame that points to it
@@ -142,7 +144,8 @@ public:
 	// resets to beginning of the animation
 	void reset();
 
-	std::string getName();
+	const std::string& getName() const { return name; }
+	StringID getID() const { return id; }
 	int getDuration();
 
 	// a vector of indexes of gfx passed into.
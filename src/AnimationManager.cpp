@@ -28,15 +28,21 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <vector>
 
 AnimationSet *AnimationManager::getAnimationSet(const std::string& filename) {
-	std::vector<std::string>::iterator found = find(names.begin(), names.end(), filename);
-	if (found != names.end()) {
-		size_t index = static_cast<size_t>(distance(names.begin(), found));
-		if (sets[index] == 0) {
-			sets[index] = new AnimationSet(filename);
+	return getAnimationSet(StringTable::get(filename));
+}
+
+AnimationSet *AnimationManager::getAnimationSet(StringID name_id) {
+	std::map<StringID, Entry>::iterator found = sets.find(name_id);
+	if (found != sets.end()) {
+		if (found->second.set == NULL) {
+			// copied, since loading the set interns its animation names
+			const std::string filename = StringTable::getString(name_id);
+			found->second.set = new AnimationSet(filename);
 		}
-		return sets[index];
+		return found->second.set;
 	}
 	else {
+		const std::string& filename = StringTable::getString(name_id);
 		Utils::logError("AnimationManager::getAnimationSet(): %s not found", filename.c_str());
 		Utils::logErrorDialog("AnimationManager::getAnimationSet(): %s not found", filename.c_str());
 		mods->resetModConfig();
@@ -54,37 +60,36 @@ AnimationManager::~AnimationManager() {
 	cleanUp();
 // NDEBUG is used by posix to disable assertions, so use the same MACRO.
 #ifndef NDEBUG
-	if (!names.empty()) {
+	if (!sets.empty()) {
 		Utils::logError("AnimationManager: Still holding these animations:");
-		for (size_t i = 0; i < names.size(); i++) {
-			Utils::logError("%s %d", names[i].c_str(), counts[i]);
+		for (std::map<StringID, Entry>::iterator it = sets.begin(); it != sets.end(); ++it) {
+			Utils::logError("%s %d", StringTable::getString(it->first).c_str(), it->second.count);
 		}
 	}
-	assert(names.size() == 0);
+	assert(sets.size() == 0);
 #endif
 }
 
 void AnimationManager::increaseCount(const std::string &name) {
-	std::vector<std::string>::iterator found = find(names.begin(), names.end(), name);
-	if (found != names.end()) {
-		size_t index = static_cast<size_t>(distance(names.begin(), found));
-		counts[index]++;
-	}
-	else {
-		sets.push_back(0);
-		names.push_back(name);
-		counts.push_back(1);
-	}
+	increaseCount(StringTable::get(name));
+}
+
+void AnimationManager::increaseCount(StringID name_id) {
+	// adds the entry if needed
+	sets[name_id].count++;
 }
 
 void AnimationManager::decreaseCount(const std::string &name) {
+	decreaseCount(StringTable::get(name));
+}
 
-	std::vector<std::string>::iterator found = find(names.begin(), names.end(), name);
-	if (found != names.end()) {
-		size_t index = static_cast<size_t>(distance(names.begin(), found));
-		counts[index]--;
+void AnimationManager::decreaseCount(StringID name_id) {
+	std::map<StringID, Entry>::iterator found = sets.find(name_id);
+	if (found != sets.end()) {
+		found->second.count--;
 	}
 	else {
+		const std::string& name = StringTable::getString(name_id);
 		Utils::logError("AnimationManager::decreaseCount(): %s not found", name.c_str());
 		Utils::logErrorDialog("AnimationManager::decreaseCount(): %s not found", name.c_str());
 		Utils::Exit(1);
@@ -92,22 +97,25 @@ void AnimationManager::decreaseCount(const std::string &name) {
 }
 
 void AnimationManager::cleanUp() {
-	int i = static_cast<int>(sets.size()) - 1;
-	while (i >= 0) {
-		if (counts[i] <= 0) {
-			delete sets[i];
-			counts.erase(counts.begin()+i);
-			sets.erase(sets.begin()+i);
-			names.erase(names.begin()+i);
+	std::map<StringID, Entry>::iterator it = sets.begin();
+	while (it != sets.end()) {
+		if (it->second.count <= 0) {
+			delete it->second.set;
+			sets.erase(it++);
+		}
+		else {
+			++it;
 		}
-		--i;
 	}
 }
 
 void AnimationManager::checkAnimationsInit() {
-	for (size_t i = 0; i < sets.size(); ++i) {
-		for (size_t j = 0; j < sets[i]->animations.size(); ++j) {
-			sets[i]->animations[j]->checkInit();
+	for (std::map<StringID, Entry>::iterator it = sets.begin(); it != sets.end(); ++it) {
+		if (!it->second.set)
+			continue;
+
+		for (size_t j = 0; j < it->second.set->animations.size(); ++j) {
+			it->second.set->animations[j]->checkInit();
 		}
 	}
 }
@@ -20,14 +20,21 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define ANIMATION_MANAGER_H
 
 #include "CommonIncludes.h"
+#include "StringTable.h"
 
 class AnimationSet;
 
 class AnimationManager {
 private:
-	std::vector<AnimationSet*> sets;
-	std::vector<std::string> names;
-	std::vector<int> counts;
+	class Entry {
+	public:
+		AnimationSet* set; // loaded on first use
+		int count;
+		Entry() : set(NULL), count(0) {}
+	};
+
+	// keyed by the interned filename
+	std::map<StringID, Entry> sets;
 
 public:
 	AnimationManager();
@@ -37,9 +44,12 @@ public:
 	 * @param name: the filename of what to load starting below the animations folder.
 	 */
 	AnimationSet *getAnimationSet(const std::string &name);
+	AnimationSet *getAnimationSet(StringID name_id);
 
 	void decreaseCount(const std::string &name);
+	void decreaseCount(StringID name_id);
 	void increaseCount(const std::string &name);
+	void increaseCount(StringID name_id);
 	void cleanUp();
 
 	void checkAnimationsInit();
@@ -31,12 +31,19 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <cassert>
 
 Animation *AnimationSet::getAnimation(const std::string &_name) {
+	return getAnimation(StringTable::get(_name));
+}
+
+/**
+ * A set only has a few animations, so comparing the IDs one by one is quicker than a map lookup
+ */
+Animation *AnimationSet::getAnimation(StringID id) {
 	if (!loaded)
 		load();
 
-	if (!_name.empty()) {
+	if (id != StringTable::EMPTY) {
 		for (size_t i = 0; i < animations.size(); i++) {
-			if (animations[i]->getName() == _name)
+			if (animations[i]->getID() == id)
 				return new Animation(*animations[i]);
 		}
 	}
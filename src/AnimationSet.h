@@ -22,6 +22,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "CommonIncludes.h"
 #include "AnimationMedia.h"
+#include "StringTable.h"
 
 class Animation;
 
@@ -58,6 +59,7 @@ public:
 	 * a default animation is returned.
 	 */
 	Animation *getAnimation(const std::string &name);
+	Animation *getAnimation(StringID id);
 
 	const std::string &getName() {
 		return name;
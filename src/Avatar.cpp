@@ -71,6 +71,7 @@ Avatar::Avatar()
 	, path_found_fail_timer()
 	, mm_target(-1, -1)
 	, mm_target_desired(-1, -1)
+	, attack_anim_id(StringTable::EMPTY)
 	, hero_stats(NULL)
 	, charmed_stats(NULL)
 	, act_target()
@@ -646,6 +647,7 @@ void Avatar::logic() {
 					current_power_original = action.power;
 					act_target = action.target;
 					attack_anim = power->attack_anim;
+					attack_anim_id = power->attack_anim_id;
 
 					stats.cur_state = StatBlock::ENTITY_BLOCK;
 					beginPower(replaced_id, &act_target);
@@ -659,6 +661,7 @@ void Avatar::logic() {
 				current_power_original = action.power;
 				act_target = action.target;
 				attack_anim = power->attack_anim;
+				attack_anim_id = power->attack_anim_id;
 				resetActiveAnimation();
 
 				if (power->new_state == Power::STATE_ATTACK) {
@@ -678,7 +681,7 @@ void Avatar::logic() {
 		switch(stats.cur_state) {
 			case StatBlock::ENTITY_STANCE:
 
-				setAnimation("stance");
+				setAnimation(StringTable::ANIM_STANCE);
 
 				// allowed to move or use powers?
 				if (settings->mouse_move) {
@@ -718,7 +721,7 @@ void Avatar::logic() {
 
 			case StatBlock::ENTITY_MOVE:
 
-				setAnimation("run");
+				setAnimation(StringTable::ANIM_RUN);
 
 				if (!sound_steps.empty()) {
 					int stepfx = rand() % static_cast<int>(sound_steps.size());
@@ -754,14 +757,14 @@ void Avatar::logic() {
 					drag_walking = true;
 				}
 
-				if (activeAnimation->getName() != "run")
+				if (activeAnimation->getID() != StringTable::ANIM_RUN)
 					stats.cur_state = StatBlock::ENTITY_STANCE;
 
 				break;
 
 			case StatBlock::ENTITY_POWER:
 
-				setAnimation(attack_anim);
+				setAnimation(attack_anim_id);
 
 				if (powers->isValid(current_power)) {
 					Power* power = powers->powers[current_power];
@@ -813,7 +816,7 @@ void Avatar::logic() {
 				}
 
 				// animation is done, switch back to normal stance
-				if ((activeAnimation->isLastFrame() && stats.state_timer.isEnd()) || activeAnimation->getName() != attack_anim) {
+				if ((activeAnimation->isLastFrame() && stats.state_timer.isEnd()) || activeAnimation->getID() != attack_anim_id) {
 					stats.cur_state = StatBlock::ENTITY_STANCE;
 					stats.cooldown.reset(Timer::BEGIN);
 					stats.prevent_interrupt = false;
@@ -823,13 +826,13 @@ void Avatar::logic() {
 
 			case StatBlock::ENTITY_BLOCK:
 
-				setAnimation("block");
+				setAnimation(StringTable::ANIM_BLOCK);
 
 				break;
 
 			case StatBlock::ENTITY_HIT:
 
-				setAnimation("hit");
+				setAnimation(StringTable::ANIM_HIT);
 
 				if (activeAnimation->isFirstFrame()) {
 					stats.effects.triggered_hit = true;
@@ -840,7 +843,7 @@ void Avatar::logic() {
 					}
 				}
 
-				if (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getName() != "hit") {
+				if (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getID() != StringTable::ANIM_HIT) {
 					stats.cur_state = StatBlock::ENTITY_STANCE;
 				}
 
@@ -854,7 +857,7 @@ void Avatar::logic() {
 					untransform();
 				}
 
-				setAnimation("die");
+				setAnimation(StringTable::ANIM_DIE);
 
 				if (!stats.corpse && activeAnimation->isFirstFrame() && activeAnimation->getTimesPlayed() < 1) {
 					stats.effects.clearEffects();
@@ -893,7 +896,7 @@ void Avatar::logic() {
 						inpt->lock[Input::MAIN1] = true;
 				}
 
-				if (!stats.corpse && (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getName() != "die")) {
+				if (!stats.corpse && (activeAnimation->getTimesPlayed() >= 1 || activeAnimation->getID() != StringTable::ANIM_DIE)) {
 					stats.corpse = true;
 					menu->game_over->visible = true;
 				}
@@ -1100,7 +1103,7 @@ void Avatar::untransform() {
 
 	// This is a bit of a hack.
 	// In order to switch to the stance animation, we can't already be in a stance animation
-	setAnimation("run");
+	setAnimation(StringTable::ANIM_RUN);
 
 	for (int i=0; i<Stats::COUNT; ++i) {
 		stats.starting[i] = hero_stats->starting[i];
@@ -143,6 +143,7 @@ public:
 	std::queue<std::pair<std::string, int> > log_msg;
 
 	std::string attack_anim;
+	StringID attack_anim_id;
 	bool setPowers;
 	bool revertPowers;
 	PowerID untransform_power;
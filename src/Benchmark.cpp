@@ -0,0 +1,353 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "Avatar.h"
+#include "Benchmark.h"
+#include "EntityManager.h"
+#include "EventManager.h"
+#include "FileParser.h"
+#include "GameSwitcher.h"
+#include "InputState.h"
+#include "MapRenderer.h"
+#include "Profiler.h"
+#include "RenderDevice.h"
+#include "SaveLoad.h"
+#include "Settings.h"
+#include "SharedGameResources.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsParsing.h"
+
+static bool comparePrio(const Renderable& r1, const Renderable& r2) {
+	return r1.prio < r2.prio;
+}
+
+Benchmark::Benchmark(const std::string& _scenario)
+	: scenario(_scenario)
+	, loaded(false)
+	, slot("")
+	, replay("")
+	, map("")
+	, script("")
+	, seed(1)
+	, warmup_ticks(60)
+	, ticks(1800)
+	, render(true)
+	, spawn_radius(10)
+	, sort_benchmark(false)
+{
+}
+
+Benchmark::~Benchmark() {
+}
+
+void Benchmark::setupHeadless() {
+	SDL_setenv("SDL_VIDEODRIVER", "dummy", 1);
+	SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+
+	// no sounds or music are loaded
+	settings->audio = false;
+}
+
+bool Benchmark::loadScenario() {
+	FileParser infile;
+	// @CLASS Benchmark|Description of benchmarks/
+	if (!infile.open("benchmarks/" + scenario + ".txt", FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
+		return false;
+
+	while (infile.next()) {
+		// @ATTR slot|int|The save slot to load, starting at 1.
+		if (infile.key == "slot")
+			slot = infile.val;
+		// @ATTR replay|string|Play back this input recording (a path on disk) instead of loading a save slot.
+		else if (infile.key == "replay")
+			replay = infile.val;
+		// @ATTR map|filename, int, int : Map file, X, Y|Go to this map after loading the save. X/Y (optional) are the hero's position.
+		else if (infile.key == "map")
+			map = infile.val;
+		// @ATTR script|filename|An event script to run when the save is loaded.
+		else if (infile.key == "script")
+			script = infile.val;
+		// @ATTR seed|int|Seed for the random number generator. The default is 1.
+		else if (infile.key == "seed")
+			seed = static_cast<unsigned>(Parse::toInt(infile.val));
+		// @ATTR warmup|int|Number of ticks to run before measuring. The default is 60.
+		else if (infile.key == "warmup")
+			warmup_ticks = std::max(Parse::toInt(infile.val), 0);
+		// @ATTR ticks|int|Number of ticks to measure. The default is 1800.
+		else if (infile.key == "ticks")
+			ticks = std::max(Parse::toInt(infile.val), 1);
+		// @ATTR render|bool|Render every tick (to the dummy video driver). The default is true.
+		else if (infile.key == "render")
+			render = Parse::toBool(infile.val);
+		// @ATTR spawn_radius|int|Enemies are spawned up to this many tiles away from the hero. The default is 10.
+		else if (infile.key == "spawn_radius")
+			spawn_radius = std::max(Parse::toInt(infile.val), 1);
+		// @ATTR sort_benchmark|bool|After the ticks, compare the radix sort of renderables to std::stable_sort(). The default is false.
+		else if (infile.key == "sort_benchmark")
+			sort_benchmark = Parse::toBool(infile.val);
+		// @ATTR spawn|repeatable(predefined_string, int) : Enemy category, Count|Spawn this many enemies of the category around the hero.
+		else if (infile.key == "spawn") {
+			Spawn spawn;
+			spawn.category = Parse::popFirstString(infile.val);
+			spawn.count = Parse::popFirstInt(infile.val);
+			if (!spawn.category.empty() && spawn.count > 0)
+				spawns.push_back(spawn);
+		}
+		else {
+			infile.error("Benchmark: '%s' is not a valid key.", infile.key.c_str());
+		}
+	}
+	infile.close();
+
+	if (!replay.empty()) {
+		if (!input_replay.startPlayback(replay))
+			return false;
+
+		// the recorded session started with this seed, before the title screen was created
+		srand(input_replay.getSeed());
+		loaded = true;
+		return true;
+	}
+
+	if (slot.empty()) {
+		Utils::logError("Benchmark: Scenario '%s' sets neither a save slot nor a replay.", scenario.c_str());
+		return false;
+	}
+
+	// the title screen and the first map load pick these up
+	settings->load_slot = slot;
+	settings->load_script = script;
+
+	loaded = true;
+	return true;
+}
+
+bool Benchmark::run(GameSwitcher* gswitch) {
+	if (!loaded)
+		return false;
+
+	if (input_replay.isPlaying())
+		return runReplay(gswitch);
+
+	srand(seed);
+
+	Utils::logInfo("Benchmark: Loading save slot %s for scenario '%s'...", slot.c_str(), scenario.c_str());
+	if (!waitForMap(gswitch))
+		return false;
+
+	// keep the save slot exactly as it was, so every run starts from the same state
+	save_load->setGameSlot(0);
+
+	if (!map.empty()) {
+		Event evnt;
+		std::string key = "intermap";
+		std::string val = map;
+		eventm->loadEventComponentString(key, val, &evnt, NULL);
+		eventm->executeEvent(evnt);
+
+		if (!waitForMap(gswitch))
+			return false;
+	}
+
+	// loading times vary, so the seed is applied again once the map is ready
+	srand(seed);
+	spawnEnemies();
+
+	for (int i = 0; i < warmup_ticks; ++i) {
+		if (!tick(gswitch))
+			return false;
+	}
+
+	Utils::logInfo("Benchmark: Running %d ticks on '%s'...", ticks, mapr->getFilename().c_str());
+
+	profiler->startRecording();
+	uint64_t start_ticks = SDL_GetPerformanceCounter();
+
+	for (int i = 0; i < ticks; ++i) {
+		if (!tick(gswitch)) {
+			profiler->stopRecording(settings->path_user + "benchmark.csv", settings->path_user + "benchmark_trace.json");
+			return false;
+		}
+	}
+
+	uint64_t end_ticks = SDL_GetPerformanceCounter();
+	float seconds = static_cast<float>(end_ticks - start_ticks) / static_cast<float>(SDL_GetPerformanceFrequency());
+
+	Utils::logInfo("Benchmark: %d ticks in %.3f seconds (%.1f ticks per second), %u entities on the map.", ticks, seconds, (seconds > 0 ? static_cast<float>(ticks) / seconds : 0), static_cast<unsigned>(entitym->entities.size()));
+	profiler->logSummary();
+	profiler->stopRecording(settings->path_user + "benchmark.csv", settings->path_user + "benchmark_trace.json");
+
+	if (sort_benchmark)
+		benchmarkSort();
+
+	return true;
+}
+
+bool Benchmark::runReplay(GameSwitcher* gswitch) {
+	Utils::logInfo("Benchmark: Playing back '%s'...", replay.c_str());
+
+	profiler->startRecording();
+	uint64_t start_ticks = SDL_GetPerformanceCounter();
+
+	while (!input_replay.isFinished()) {
+		if (!tick(gswitch)) {
+			profiler->stopRecording(settings->path_user + "benchmark.csv", settings->path_user + "benchmark_trace.json");
+			return false;
+		}
+	}
+
+	uint64_t end_ticks = SDL_GetPerformanceCounter();
+	float seconds = static_cast<float>(end_ticks - start_ticks) / static_cast<float>(SDL_GetPerformanceFrequency());
+
+	Utils::logInfo("Benchmark: %u ticks in %.3f seconds (%.1f ticks per second).", input_replay.getTickCount(), seconds, (seconds > 0 ? static_cast<float>(input_replay.getTickCount()) / seconds : 0));
+	profiler->logSummary();
+	profiler->stopRecording(settings->path_user + "benchmark.csv", settings->path_user + "benchmark_trace.json");
+
+	return input_replay.getDesyncCount() == 0;
+}
+
+/**
+ * The same steps as one pass of the main loop, without waiting for the next frame
+ */
+bool Benchmark::tick(GameSwitcher* gswitch) {
+	// like the main loop, input is not read on loading frames
+	if (!gswitch->isLoadingFrame()) {
+		SDL_PumpEvents();
+		inpt->handle();
+
+		input_replay.beforeLogic();
+		{
+			PROFILE_SCOPE("GameSwitcher::logic");
+			gswitch->logic();
+		}
+		input_replay.afterLogic();
+		inpt->resetScroll();
+	}
+
+	if (render) {
+		render_device->blankScreen();
+		{
+			PROFILE_SCOPE("GameSwitcher::render");
+			gswitch->render();
+		}
+		{
+			PROFILE_SCOPE("RenderDevice::commitFrame");
+			render_device->commitFrame();
+		}
+	}
+
+	profiler->endFrame();
+
+	if (gswitch->done || inpt->done) {
+		Utils::logError("Benchmark: The game exited before the scenario finished.");
+		return false;
+	}
+	return true;
+}
+
+bool Benchmark::waitForMap(GameSwitcher* gswitch) {
+	const int max_ticks = LOAD_TIMEOUT * settings->max_frames_per_sec;
+
+	for (int i = 0; i < max_ticks; ++i) {
+		if (!tick(gswitch))
+			return false;
+		if (isMapReady())
+			return true;
+	}
+
+	Utils::logError("Benchmark: Scenario '%s' did not finish loading a map within %d seconds.", scenario.c_str(), LOAD_TIMEOUT);
+	return false;
+}
+
+/**
+ * True once gameplay has started on a map, and no teleport or load script is still pending
+ */
+bool Benchmark::isMapReady() {
+	if (!mapr || !pc)
+		return false;
+
+	return !mapr->getFilename().empty() && !mapr->is_spawn_map && !mapr->teleportation && settings->load_script.empty();
+}
+
+void Benchmark::spawnEnemies() {
+	const Point center(pc->stats.pos);
+	const int diameter = spawn_radius * 2 + 1;
+
+	for (size_t i = 0; i < spawns.size(); ++i) {
+		int placed = 0;
+		for (int attempt = 0; attempt < spawns[i].count * MAX_SPAWN_ATTEMPTS && placed < spawns[i].count; ++attempt) {
+			Point target(center.x + (rand() % diameter) - spawn_radius, center.y + (rand() % diameter) - spawn_radius);
+			if (!mapr->collider.isValidPosition(static_cast<float>(target.x) + 0.5f, static_cast<float>(target.y) + 0.5f, MapCollision::MOVE_NORMAL, MapCollision::COLLIDE_TYPE_NONE))
+				continue;
+
+			entitym->spawn(spawns[i].category, target, NULL);
+			placed++;
+		}
+
+		if (placed < spawns[i].count)
+			Utils::logError("Benchmark: Only found room for %d of %d enemies from '%s'.", placed, spawns[i].count, spawns[i].category.c_str());
+	}
+}
+
+/**
+ * Sorts the same lists of renderables with MapRenderer::sortRenderables() and with std::stable_sort(), and logs the
+ * average time of each. The prios are calculated by the map renderer, so the keys look like the ones from real frames
+ */
+void Benchmark::benchmarkSort() {
+	static const size_t COUNTS[] = {500, 1000, 2000, 5000};
+	static const size_t COUNT_SIZE = sizeof(COUNTS) / sizeof(COUNTS[0]);
+
+	const float ms_per_tick = 1000.0f / static_cast<float>(SDL_GetPerformanceFrequency());
+
+	for (size_t c = 0; c < COUNT_SIZE; ++c) {
+		std::vector<Renderable> source(COUNTS[c]);
+		for (size_t i = 0; i < source.size(); ++i) {
+			source[i].map_pos.x = static_cast<float>(rand() % (std::max<int>(mapr->w, 1) * 100)) / 100.0f;
+			source[i].map_pos.y = static_cast<float>(rand() % (std::max<int>(mapr->h, 1) * 100)) / 100.0f;
+			// entities use a few layers each (see Entity::addRenders())
+			source[i].prio = static_cast<uint64_t>(rand() % 4);
+		}
+		mapr->calculatePrios(source);
+
+		std::vector<Renderable> radix_sorted;
+		std::vector<Renderable> stable_sorted;
+		uint64_t radix_ticks = 0;
+		uint64_t stable_ticks = 0;
+
+		for (int i = 0; i < SORT_ITERATIONS; ++i) {
+			radix_sorted = source;
+			uint64_t start_ticks = SDL_GetPerformanceCounter();
+			mapr->sortRenderables(radix_sorted);
+			radix_ticks += SDL_GetPerformanceCounter() - start_ticks;
+
+			stable_sorted = source;
+			start_ticks = SDL_GetPerformanceCounter();
+			std::stable_sort(stable_sorted.begin(), stable_sorted.end(), comparePrio);
+			stable_ticks += SDL_GetPerformanceCounter() - start_ticks;
+		}
+
+		for (size_t i = 0; i < source.size(); ++i) {
+			if (radix_sorted[i].prio != stable_sorted[i].prio || radix_sorted[i].map_pos.x != stable_sorted[i].map_pos.x || radix_sorted[i].map_pos.y != stable_sorted[i].map_pos.y) {
+				Utils::logError("Benchmark: The radix sort and std::stable_sort() disagree at index %u of %u renderables.", static_cast<unsigned>(i), static_cast<unsigned>(source.size()));
+				break;
+			}
+		}
+
+		const float radix_ms = static_cast<float>(radix_ticks) * ms_per_tick / static_cast<float>(SORT_ITERATIONS);
+		const float stable_ms = static_cast<float>(stable_ticks) * ms_per_tick / static_cast<float>(SORT_ITERATIONS);
+		Utils::logInfo("Benchmark: Sorting %u renderables: radix %.4f ms, std::stable_sort %.4f ms (%.2fx).", static_cast<unsigned>(source.size()), radix_ms, stable_ms, (radix_ms > 0 ? stable_ms / radix_ms : 0));
+	}
+}
@@ -0,0 +1,97 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Benchmark
+ *
+ * Runs the game without a display for --benchmark=<scenario>. The scenario is read from benchmarks/<scenario>.txt.
+ * It names a save slot to load, and optionally a map to go to, a script to run and enemies to spawn around the hero.
+ *
+ * Video and audio use SDL's dummy drivers, so nothing is shown or played. rand() is seeded from the scenario. Once
+ * the map is loaded, a fixed number of ticks run as fast as possible while the hero stands still, and the time
+ * spent in each profiler section is logged. The save slot is never written to.
+ *
+ * If sort_benchmark is set, MapRenderer::sortRenderables() is then timed against std::stable_sort() on lists of
+ * renderables scattered over the map.
+ *
+ * Instead of a save slot, a scenario can name a recording made with --record-input. The whole recorded session is
+ * then played back as fast as possible, using the seed from the recording.
+ */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include "CommonIncludes.h"
+#include "InputReplay.h"
+
+class GameSwitcher;
+
+class Benchmark {
+public:
+	explicit Benchmark(const std::string& _scenario);
+	~Benchmark();
+
+	// selects the dummy video and audio drivers. Must be called before SDL_Init()
+	void setupHeadless();
+
+	// reads the scenario file. Must be called after the mods are loaded, but before the title screen is created
+	bool loadScenario();
+
+	// returns false if the scenario couldn't be loaded or didn't reach gameplay
+	bool run(GameSwitcher* gswitch);
+
+private:
+	// give up if loading the save or a map takes longer than this (in seconds of game time)
+	static const int LOAD_TIMEOUT = 60;
+
+	// tries per enemy to find an open tile within spawn_radius
+	static const int MAX_SPAWN_ATTEMPTS = 10;
+
+	// times each list is sorted by each method in benchmarkSort()
+	static const int SORT_ITERATIONS = 200;
+
+	class Spawn {
+	public:
+		std::string category;
+		int count;
+		Spawn() : count(0) {}
+	};
+
+	bool runReplay(GameSwitcher* gswitch);
+	bool tick(GameSwitcher* gswitch);
+	bool waitForMap(GameSwitcher* gswitch);
+	bool isMapReady();
+	void spawnEnemies();
+	void benchmarkSort();
+
+	std::string scenario;
+	bool loaded;
+
+	std::string slot;
+	std::string replay;
+	std::string map;
+	std::string script;
+	unsigned seed;
+	int warmup_ticks;
+	int ticks;
+	bool render;
+	int spawn_radius;
+	bool sort_benchmark;
+	std::vector<Spawn> spawns;
+
+	InputReplay input_replay;
+};
+
+#endif // BENCHMARK_H
@@ -42,7 +42,15 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 CampaignManager::CampaignManager()
 	: bonus_xp(0.0)
-	, random_status(0) {
+	, random_status(0)
+	, last_level(0)
+	, last_class("")
+	, last_currency(0)
+	, last_items_hash(0) {
+	// start at 1, so that 0 can mean "never checked"
+	for (int i = 0; i < CHANGE_COUNT; ++i) {
+		generation[i] = 1;
+	}
 }
 
 StatusID CampaignManager::registerStatus(const std::string& s) {
@@ -110,7 +118,7 @@ void CampaignManager::setStatus(const StatusID s) {
 	if (checkStatus(s)) return;
 
 	status[s].first = true;
-	pc->stats.check_title = true;
+	notifyChange(CHANGE_STATUS);
 }
 
 void CampaignManager::unsetStatus(const StatusID s) {
@@ -118,7 +126,7 @@ void CampaignManager::unsetStatus(const StatusID s) {
 	if (!checkStatus(s)) return;
 
 	status[s].first = false;
-	pc->stats.check_title = true;
+	notifyChange(CHANGE_STATUS);
 }
 
 void CampaignManager::resetAllStatuses() {
@@ -126,6 +134,7 @@ void CampaignManager::resetAllStatuses() {
 	for (it = status.begin(); it != status.end(); ++it) {
 		it->second.first = false;
 	}
+	notifyChange(CHANGE_STATUS);
 }
 
 void CampaignManager::getSetStatusStrings(std::vector<std::string>& status_strings) {
@@ -152,6 +161,7 @@ void CampaignManager::removeCurrency(int quantity) {
 
 	if (max_amount > 0) {
 		menu->inv->removeCurrency(max_amount);
+		notifyChange(CHANGE_CURRENCY);
 		pc->logMsg(msg->getv("%d %s removed.", max_amount, eset->loot.currency.c_str()), Avatar::MSG_UNIQUE);
 		items->playSound(eset->misc.currency_id);
 	}
@@ -170,6 +180,7 @@ void CampaignManager::removeItem(ItemStack istack) {
 	int max_amount = std::min(item_count, istack.quantity);
 
 	if (menu->inv->remove(istack.item, max_amount)) {
+		notifyChange(CHANGE_ITEMS);
 		if (max_amount > 1)
 			pc->logMsg(msg->getv("%s x%d removed.", items->getItemName(istack.item).c_str(), max_amount), Avatar::MSG_UNIQUE);
 		else if (max_amount == 1)
@@ -185,6 +196,7 @@ void CampaignManager::rewardItem(ItemStack istack) {
 		return;
 
 	menu->inv->add(istack, MenuInventory::CARRIED, ItemStorage::NO_SLOT, MenuInventory::ADD_PLAY_SOUND, MenuInventory::ADD_AUTO_EQUIP);
+	notifyChange(istack.item == eset->misc.currency_id ? CHANGE_CURRENCY : CHANGE_ITEMS);
 
 	if (istack.item == eset->misc.currency_id) {
 		pc->logMsg(msg->getv("You receive %d %s.", istack.quantity, eset->loot.currency.c_str()), Avatar::MSG_UNIQUE);
@@ -339,6 +351,65 @@ bool CampaignManager::checkRequirementsInVector(const std::vector<EventComponent
 	return true;
 }
 
+/**
+ * The generations only ever grow, so their sum changes whenever one of them does
+ */
+unsigned CampaignManager::getGeneration(int changes) {
+	unsigned sum = 0;
+	for (int i = 0; i < CHANGE_COUNT; ++i) {
+		if (changes & (1 << i))
+			sum += generation[i];
+	}
+	return sum;
+}
+
+void CampaignManager::notifyChange(int changes) {
+	for (int i = 0; i < CHANGE_COUNT; ++i) {
+		if (changes & (1 << i))
+			generation[i]++;
+	}
+}
+
+/**
+ * The hero's items, level and class are changed by many different menus and systems
+ * Rather than calling notifyChange() in each of those places, they are compared to the previous call here
+ */
+void CampaignManager::checkHeroChanges() {
+	if (!pc || !menu || !menu->inv)
+		return;
+
+	// FNV-1a over the carried and equipped items
+	uint32_t items_hash = 2166136261u;
+	for (int i = MenuInventory::EQUIPMENT; i <= MenuInventory::CARRIED; ++i) {
+		ItemStorage& storage = menu->inv->inventory[i];
+		for (int j = 0; j < storage.getSlotNumber(); ++j) {
+			items_hash = (items_hash ^ static_cast<uint32_t>(storage[j].item)) * 16777619u;
+			items_hash = (items_hash ^ static_cast<uint32_t>(storage[j].quantity)) * 16777619u;
+		}
+	}
+
+	int changes = 0;
+	if (items_hash != last_items_hash) {
+		last_items_hash = items_hash;
+		changes |= CHANGE_ITEMS;
+	}
+	if (menu->inv->currency != last_currency) {
+		last_currency = menu->inv->currency;
+		changes |= CHANGE_CURRENCY;
+	}
+	if (pc->stats.level != last_level) {
+		last_level = pc->stats.level;
+		changes |= CHANGE_LEVEL;
+	}
+	if (pc->stats.character_class != last_class) {
+		last_class = pc->stats.character_class;
+		changes |= CHANGE_CLASS;
+	}
+
+	if (changes)
+		notifyChange(changes);
+}
+
 void CampaignManager::randomStatusAppend(const StatusID s) {
 	if (std::find(random_status_pool.begin(), random_status_pool.end(), s) == random_status_pool.end()) {
 		if (random_status_pool.empty())
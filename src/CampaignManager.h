@@ -20,6 +20,10 @@ FLARE.  If not, see http://www.gnu.org/licenses/
  * class CampaignManager
  *
  * Contains data for story mode
+ *
+ * Every kind of change to the campaign state has a generation counter. Systems that depend on the campaign state
+ * (events, the quest log, titles, the power tree) remember getGeneration() for the kinds of changes they care about,
+ * and only check their requirements again when it differs.
  */
 
 
@@ -37,6 +41,18 @@ class CampaignManager {
 public:
 	typedef std::map<StatusID, std::pair<bool, std::string> > StatusMap;
 
+	enum {
+		CHANGE_STATUS = 1 << 0,
+		CHANGE_CURRENCY = 1 << 1,
+		CHANGE_ITEMS = 1 << 2,
+		CHANGE_LEVEL = 1 << 3,
+		CHANGE_CLASS = 1 << 4,
+		CHANGE_TILES = 1 << 5,
+		// everything that an EventComponent requirement can check
+		CHANGE_REQUIREMENTS = (1 << 6) - 1
+	};
+	static const int CHANGE_COUNT = 6;
+
 	CampaignManager();
 	~CampaignManager();
 
@@ -59,6 +75,11 @@ public:
 	bool checkAllRequirements(const EventComponent& ec);
 	bool checkRequirementsInVector(const std::vector<EventComponent>& ec_vec);
 
+	// changes whenever one of the given kinds of change (CHANGE_* flags) happens
+	unsigned getGeneration(int changes);
+	void notifyChange(int changes);
+	void checkHeroChanges();
+
 	void randomStatusAppend(const StatusID s);
 	void randomStatusClear();
 	void randomStatusRoll();
@@ -76,6 +97,14 @@ private:
 
 	std::vector<StatusID> random_status_pool;
 	StatusID random_status;
+
+	unsigned generation[CHANGE_COUNT];
+
+	// the hero's state when checkHeroChanges() was last called
+	int last_level;
+	std::string last_class;
+	int last_currency;
+	uint32_t last_items_hash;
 };
 
 
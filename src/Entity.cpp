@@ -329,6 +329,10 @@ bool Entity::takeHit(Hazard &h) {
 			return false;
 	}
 
+	// far away entities might not be fully updated, see EntityBehavior::getUpdateTier()
+	if (behavior)
+		behavior->wake();
+
 	// check if this entity allows attacks from this power id
 	if (!stats.power_filter.empty() && std::find(stats.power_filter.begin(), stats.power_filter.end(), h.power_index) == stats.power_filter.end()) {
 		return false;
@@ -378,7 +382,7 @@ bool Entity::takeHit(Hazard &h) {
 		// reset the hazard ticks
 		h.lifespan = h.power->lifespan;
 
-		if (activeAnimation->getName() == "block") {
+		if (activeAnimation->getID() == StringTable::ANIM_BLOCK) {
 			playSound(Entity::SOUND_BLOCK);
 		}
 
@@ -473,7 +477,7 @@ bool Entity::takeHit(Hazard &h) {
 				else if (!stats.effects.triggered_block && eset->combat.max_absorb < 100)
 					dmg = 1;
 
-				if (activeAnimation->getName() == "block") {
+				if (activeAnimation->getID() == StringTable::ANIM_BLOCK) {
 					playSound(Entity::SOUND_BLOCK);
 					resetActiveAnimation();
 				}
@@ -738,24 +742,31 @@ void Entity::resetActiveAnimation() {
  * Set the entity's current animation by name
  */
 void Entity::setAnimation(const std::string& animationName) {
+	setAnimation(StringTable::get(animationName));
+}
+
+/**
+ * This is called every frame, so the common case of keeping the current animation only compares IDs
+ */
+void Entity::setAnimation(StringID animation_id) {
 
 	// if the animation is already the requested one do nothing
-	if (activeAnimation != NULL && activeAnimation->getName() == animationName)
+	if (activeAnimation != NULL && activeAnimation->getID() == animation_id)
 		return;
 
 	if (!animationSet)
 		return;
 
 	delete activeAnimation;
-	activeAnimation = animationSet->getAnimation(animationName);
+	activeAnimation = animationSet->getAnimation(animation_id);
 
 	if (!activeAnimation)
-		Utils::logError("Entity::setAnimation(%s): not found", animationName.c_str());
+		Utils::logError("Entity::setAnimation(%s): not found", StringTable::getString(animation_id).c_str());
 
 	for (size_t i = 0; i < animsets.size(); ++i) {
 		delete anims[i];
 		if (animsets[i])
-			anims[i] = animsets[i]->getAnimation(animationName);
+			anims[i] = animsets[i]->getAnimation(animation_id);
 		else
 			anims[i] = NULL;
 	}
@@ -975,8 +986,8 @@ void Entity::loadAnimations() {
 			anim->increaseCount(name);
 			animsets.push_back(anim->getAnimationSet(name));
 			animsets.back()->setParent(animationSet);
-			anims.push_back(animsets.back()->getAnimation(activeAnimation->getName()));
-			setAnimation("stance");
+			anims.push_back(animsets.back()->getAnimation(activeAnimation->getID()));
+			setAnimation(StringTable::ANIM_STANCE);
 			if(!anims.back()->syncTo(activeAnimation)) {
 				Utils::logError("Entity: Error syncing animation in '%s' to parent animation.", animsets.back()->getName().c_str());
 			}
@@ -990,9 +1001,9 @@ void Entity::loadAnimations() {
 
 	stats.critdie_enabled = false;
 	if (animationSet) {
-		Animation* critdie_anim = animationSet->getAnimation("critdie");
+		Animation* critdie_anim = animationSet->getAnimation(StringTable::ANIM_CRITDIE);
 		if (critdie_anim) {
-			stats.critdie_enabled = (critdie_anim->getName() == "critdie");
+			stats.critdie_enabled = (critdie_anim->getID() == StringTable::ANIM_CRITDIE);
 			delete critdie_anim;
 		}
 	}
@@ -1000,7 +1011,7 @@ void Entity::loadAnimations() {
 	if (stats.hero) {
 		// set cooldown_hit to duration of hit animation if undefined
 		if (!stats.cooldown_hit_enabled) {
-			Animation *hit_anim = animationSet->getAnimation("hit");
+			Animation *hit_anim = animationSet->getAnimation(StringTable::ANIM_HIT);
 			if (hit_anim) {
 				stats.cooldown_hit.setDuration(hit_anim->getDuration());
 				delete hit_anim;
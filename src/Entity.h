@@ -29,6 +29,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "CommonIncludes.h"
 #include "StatBlock.h"
+#include "StringTable.h"
 #include "Utils.h"
 
 class Animation;
@@ -81,6 +82,7 @@ public:
 
 	void resetActiveAnimation();
 	void setAnimation(const std::string& animation);
+	void setAnimation(StringID animation_id);
 	Animation *activeAnimation;
 	AnimationSet *animationSet;
 	std::vector<AnimationSet*> animsets; // hold the animations for all equipped items in the right order of drawing.
@@ -50,6 +50,9 @@ const float EntityBehavior::ALLY_FLEE_DISTANCE = 2;
 const float EntityBehavior::ALLY_FOLLOW_DISTANCE_WALK = 5.5;
 const float EntityBehavior::ALLY_FOLLOW_DISTANCE_STOP = 5;
 const float EntityBehavior::ALLY_TELEPORT_DISTANCE = 40;
+const float EntityBehavior::DORMANT_MARGIN = 5;
+
+unsigned EntityBehavior::next_think_frame = 0;
 
 EntityBehavior::EntityBehavior(Entity *_e)
 	: e(_e)
@@ -70,10 +73,16 @@ EntityBehavior::EntityBehavior(Entity *_e)
 	, turn_timer()
 	, instant_power(false)
 	, replaced_power_id(0)
+	, think_frame(next_think_frame++)
+	, wake_timer()
+	, decision()
 {
 	// wait when PATH_FOUND_FAIL_THRESHOLD is exceeded
 	path_found_fail_timer.setDuration(settings->max_frames_per_sec * PATH_FOUND_FAIL_WAIT_SECONDS);
 	path_found_fail_timer.reset(Timer::END);
+
+	wake_timer.setDuration(settings->max_frames_per_sec);
+	wake_timer.reset(Timer::END);
 }
 
 /**
@@ -97,13 +106,52 @@ void EntityBehavior::logic() {
 	}
 
 	doUpkeep();
-	findTarget();
-	checkPower();
+
+	wake_timer.tick();
+	const int tier = getUpdateTier();
+	if (tier == TIER_DORMANT)
+		return;
+
+	// targets and powers are checked less often when reduced, but movement and animation still happen every frame
+	think_frame++;
+	if (tier == TIER_FULL || think_frame % REDUCED_INTERVAL == 0) {
+		fleeing = false;
+		findTarget();
+		checkPower();
+	}
 	checkMove();
 	updateState();
+}
 
-	fleeing = false;
+/**
+ * Entities that are far away from the hero and not on screen don't need to make decisions every frame.
+ * - TIER_FULL: within threat range, visible, fighting, dying, or an ally
+ * - TIER_REDUCED: up to DORMANT_MARGIN tiles beyond threat range. Looks for targets every REDUCED_INTERVAL frames
+ * - TIER_DORMANT: further away. Only timers and effects are updated
+ *
+ * Getting hit by a hazard calls wake(), and joining combat sets join_combat, so a dormant entity reacts right away
+ */
+int EntityBehavior::getUpdateTier() {
+	if (e->stats.hero_ally || e->stats.in_combat || e->stats.join_combat || e->stats.hp <= 0 || !wake_timer.isEnd())
+		return TIER_FULL;
 
+	const float dist = Utils::calcDist(e->stats.pos, pc->stats.pos);
+	if (dist <= e->stats.threat_range)
+		return TIER_FULL;
+
+	const int margin = eset->tileset.tile_w;
+	Point p = Utils::mapToScreen(e->stats.pos.x, e->stats.pos.y, mapr->cam.shake.x, mapr->cam.shake.y);
+	if (p.x >= -margin && p.y >= -margin && p.x < settings->view_w + margin && p.y < settings->view_h + margin)
+		return TIER_FULL;
+
+	if (dist <= e->stats.threat_range + DORMANT_MARGIN)
+		return TIER_REDUCED;
+
+	return TIER_DORMANT;
+}
+
+void EntityBehavior::wake() {
+	wake_timer.reset(Timer::BEGIN);
 }
 
 /**
@@ -130,6 +178,102 @@ void EntityBehavior::doUpkeep() {
 	}
 }
 
+/**
+ * Looks for a target ahead of findTarget(). Nothing is changed except this behavior's decision, so EntityManager
+ * runs this for all entities at once on the thread pool, before any of them moves. Since every decision is based
+ * on the state at the start of the frame, the results don't depend on which thread handled which entity
+ */
+void EntityBehavior::decide() {
+	decision.valid = false;
+
+	if (e->stats.corpse || e->stats.effects.stun)
+		return;
+	if (e->stats.cur_state == StatBlock::ENTITY_DEAD || e->stats.cur_state == StatBlock::ENTITY_CRITDEAD)
+		return;
+	if (!e->stats.hero_ally && !e->stats.encountered)
+		return;
+
+	// logic() won't call findTarget() on this frame
+	const int tier = getUpdateTier();
+	if (tier == TIER_DORMANT || (tier == TIER_REDUCED && (think_frame + 1) % REDUCED_INTERVAL != 0))
+		return;
+
+	StatBlock* target_stats = NULL;
+	float dist = 0;
+	if (pc->stats.alive) {
+		dist = Utils::calcDist(e->stats.pos, pc->stats.pos);
+		target_stats = &pc->stats;
+	}
+
+	chooseTarget(target_stats, dist, READ_ONLY, decision);
+}
+
+/**
+ * Starting from the default target (the hero), looks for a closer hostile entity and checks line of sight to
+ * whichever target is chosen. When read_only is set, the line of sight cache isn't updated
+ */
+void EntityBehavior::chooseTarget(StatBlock* target_stats, float target_distance, bool read_only, Decision& result) {
+	result.valid = true;
+	result.pos = e->stats.pos;
+	result.join_any_target = false;
+
+	// AI can target other AI
+	// allies, and enemies without a target, take the closest available target no matter how far it is
+	// otherwise, only targets closer than the current one are considered
+	bool take_any_target = !target_stats || e->stats.hero_ally;
+	float search_radius = take_any_target ? static_cast<float>(EntityGrid::CELL_SIZE) : target_distance;
+
+	while (true) {
+		entitym->entity_grid.getInRadius(e->stats.pos, search_radius, nearby_entities, grid_scratch);
+
+		Entity* nearest = NULL;
+		float nearest_dist = 0;
+		for (size_t i = 0; i < nearby_entities.size(); ++i) {
+			Entity* entity = nearby_entities[i];
+			if (!entity->stats.alive)
+				continue;
+
+			if ((!e->stats.hero_ally && entity->stats.hero_ally) || (e->stats.hero_ally && !entity->stats.hero_ally && entity->stats.in_combat)) {
+				float entity_dist = Utils::calcDist(e->stats.pos, entity->stats.pos);
+				if (!nearest || entity_dist < nearest_dist) {
+					nearest = entity;
+					nearest_dist = entity_dist;
+				}
+			}
+		}
+
+		if (nearest) {
+			if (take_any_target) {
+				target_stats = &nearest->stats;
+				target_distance = nearest_dist;
+				result.join_any_target = true;
+			}
+			else if (nearest_dist < target_distance) {
+				// pick a new target if it's closer
+				target_stats = &nearest->stats;
+				target_distance = nearest_dist;
+			}
+			break;
+		}
+
+		if (!take_any_target || entitym->entity_grid.isCovered(e->stats.pos, search_radius))
+			break;
+
+		search_radius *= 2;
+	}
+
+	result.target_stats = target_stats;
+	result.target_dist = target_distance;
+
+	// check line-of-sight
+	if (!target_stats || target_distance >= e->stats.threat_range || !pc->stats.alive)
+		result.los = false;
+	else if (read_only)
+		result.los = mapr->collider.lineOfSightReadOnly(e->stats.pos.x, e->stats.pos.y, target_stats->pos.x, target_stats->pos.y);
+	else
+		result.los = mapr->collider.lineOfSight(e->stats.pos.x, e->stats.pos.y, target_stats->pos.x, target_stats->pos.y);
+}
+
 /**
  * Locate the player and set various targeting info
  */
@@ -174,33 +318,16 @@ void EntityBehavior::findTarget() {
 		warp_to_hero = false;
 	}
 
-	// AI can target other AI
-	for (size_t i = 0; i < entitym->entities.size(); ++i) {
-		Entity* entity = entitym->entities[i];
-		if (!entity->stats.alive)
-			continue;
-
-		if ((!e->stats.hero_ally && entity->stats.hero_ally) || (e->stats.hero_ally && !entity->stats.hero_ally && entity->stats.in_combat)) {
-			float entity_dist = Utils::calcDist(e->stats.pos, entity->stats.pos);
-			if (!target_stats || (e->stats.hero_ally && target_stats->hero)) {
-				// pick the first available target if none is already selected
-				target_stats = &entitym->entities[i]->stats;
-				target_dist = entity_dist;
-				e->stats.in_combat = true;
-			}
-			else if (entity_dist < target_dist) {
-				// pick a new target if it's closer
-				target_stats = &entitym->entities[i]->stats;
-				target_dist = entity_dist;
-			}
-		}
-	}
+	// the closest target was usually chosen already by decide(), unless the entity moved since then
+	if (!decision.valid || !(decision.pos == e->stats.pos))
+		chooseTarget(target_stats, target_dist, !READ_ONLY, decision);
+	decision.valid = false;
 
-	// check line-of-sight
-	if (target_stats && target_dist < e->stats.threat_range && pc->stats.alive)
-		los = mapr->collider.lineOfSight(e->stats.pos.x, e->stats.pos.y, target_stats->pos.x, target_stats->pos.y);
-	else
-		los = false;
+	target_stats = decision.target_stats;
+	target_dist = decision.target_dist;
+	los = decision.los;
+	if (decision.join_any_target)
+		e->stats.in_combat = true;
 
 	if (los)
 		e->stats.cooldown_los.reset(Timer::BEGIN);
@@ -483,74 +610,84 @@ void EntityBehavior::checkMove() {
 			// if blocked, face in pathfinder direction instead
 			if (!mapr->collider.lineOfMovement(e->stats.pos.x, e->stats.pos.y, pursue_pos.x, pursue_pos.y, e->stats.movement_type)) {
 
-				// if a path is returned, target first waypoint
+				// when chasing the hero, follow the shared flow field if possible
+				// collisions (usually with other entities) fall back to a regular path
+				FPoint flow_step;
+				if (!fleeing && !collided && pursue_pos == pc->stats.pos && entitym->hero_flow_field.getNextStep(e->stats.pos, e->stats.movement_type, flow_step)) {
+					path.clear();
+					path_found = true;
+					pursue_pos = flow_step;
+				}
+				else {
+					// if a path is returned, target first waypoint
 
-				bool recalculate_path = false;
+					bool recalculate_path = false;
 
-				// add a 5% chance to recalculate on every frame. This prevents reclaulating lots of entities in the same frame
-				chance_calc_path += 5;
+					// add a 5% chance to recalculate on every frame. This prevents reclaulating lots of entities in the same frame
+					chance_calc_path += 5;
 
-				bool calc_path_success = Math::percentChance(chance_calc_path);
-				if (calc_path_success)
-					recalculate_path = true;
+					bool calc_path_success = Math::percentChance(chance_calc_path);
+					if (calc_path_success)
+						recalculate_path = true;
 
-				// if a collision ocurred then recalculate
-				if (collided)
-					recalculate_path = true;
+					// if a collision ocurred then recalculate
+					if (collided)
+						recalculate_path = true;
 
-				// if theres no path, it needs to be calculated
-				if (!recalculate_path && path.empty())
-					recalculate_path = true;
+					// if theres no path, it needs to be calculated
+					if (!recalculate_path && path.empty())
+						recalculate_path = true;
 
-				// if the target moved more than 1 tile away, recalculate
-				if (!recalculate_path && Utils::calcDist(FPoint(Point(prev_target)), FPoint(Point(pursue_pos))) > 1.f)
-					recalculate_path = true;
+					// if the target moved more than 1 tile away, recalculate
+					if (!recalculate_path && Utils::calcDist(FPoint(Point(prev_target)), FPoint(Point(pursue_pos))) > 1.f)
+						recalculate_path = true;
 
-				// dont recalculate if we were blocked and no path was found last time
-				// this makes sure that pathfinding calculation is not spammed when the target is unreachable and the entity is as close as its going to get
-				if (!path_found && collided && !calc_path_success) {
-					recalculate_path = false;
-				}
-				else {
-					// reset the collision flag only if we dont want the cooldown in place
-					collided = false;
-				}
+					// dont recalculate if we were blocked and no path was found last time
+					// this makes sure that pathfinding calculation is not spammed when the target is unreachable and the entity is as close as its going to get
+					if (!path_found && collided && !calc_path_success) {
+						recalculate_path = false;
+					}
+					else {
+						// reset the collision flag only if we dont want the cooldown in place
+						collided = false;
+					}
 
-				if (!path_found_fail_timer.isEnd()) {
-					recalculate_path = false;
-					chance_calc_path = -100;
-				}
+					if (!path_found_fail_timer.isEnd()) {
+						recalculate_path = false;
+						chance_calc_path = -100;
+					}
 
-				prev_target = pursue_pos;
+					prev_target = pursue_pos;
 
-				// target first waypoint
-				if (recalculate_path) {
-					chance_calc_path = -100;
-					path.clear();
-					path_found = mapr->collider.computePath(e->stats.pos, pursue_pos, path, e->stats.movement_type, MapCollision::DEFAULT_PATH_LIMIT);
+					// target first waypoint
+					if (recalculate_path) {
+						chance_calc_path = -100;
+						path.clear();
+						path_found = mapr->collider.computePath(e->stats.pos, pursue_pos, path, e->stats.movement_type, MapCollision::DEFAULT_PATH_LIMIT);
 
-					if (!path_found) {
-						path_found_fails++;
-						if (path_found_fails >= PATH_FOUND_FAIL_THRESHOLD) {
-							// could not find a path after several tries, so wait a little before the next attempt
-							path_found_fail_timer.reset(Timer::BEGIN);
+						if (!path_found) {
+							path_found_fails++;
+							if (path_found_fails >= PATH_FOUND_FAIL_THRESHOLD) {
+								// could not find a path after several tries, so wait a little before the next attempt
+								path_found_fail_timer.reset(Timer::BEGIN);
+							}
+						}
+						else {
+							path_found_fails = 0;
+							path_found_fail_timer.reset(Timer::END);
 						}
 					}
-					else {
-						path_found_fails = 0;
-						path_found_fail_timer.reset(Timer::END);
-					}
-				}
 
-				if (!path.empty()) {
-					pursue_pos = path.back();
+					if (!path.empty()) {
+						pursue_pos = path.back();
 
-					// if distance to node is lower than a tile size, the node is going to be passed and can be removed
-					if (Utils::calcDist(e->stats.pos, pursue_pos) <= 1.f)
-						path.pop_back();
-				}
-				else if (e->stats.hero_ally && pursue_pos == pc->stats.pos) {
-					warp_to_hero = true;
+						// if distance to node is lower than a tile size, the node is going to be passed and can be removed
+						if (Utils::calcDist(e->stats.pos, pursue_pos) <= 1.f)
+							path.pop_back();
+					}
+					else if (e->stats.hero_ally && pursue_pos == pc->stats.pos) {
+						warp_to_hero = true;
+					}
 				}
 			}
 			else {
@@ -761,12 +898,12 @@ void EntityBehavior::updateState() {
 
 		case StatBlock::ENTITY_STANCE:
 
-			e->setAnimation("stance");
+			e->setAnimation(StringTable::ANIM_STANCE);
 			break;
 
 		case StatBlock::ENTITY_MOVE:
 
-			e->setAnimation("run");
+			e->setAnimation(StringTable::ANIM_RUN);
 			break;
 
 		case StatBlock::ENTITY_POWER:
@@ -792,7 +929,7 @@ void EntityBehavior::updateState() {
 			if (power_state == Power::STATE_INSTANT)
 				instant_power = true;
 			else if (power_state == Power::STATE_ATTACK)
-				e->setAnimation(epower->attack_anim);
+				e->setAnimation(epower->attack_anim_id);
 
 			// sound effect based on power type
 			if (e->activeAnimation->isFirstFrame()) {
@@ -846,7 +983,7 @@ void EntityBehavior::updateState() {
 			}
 
 			// animation is finished
-			if ((e->activeAnimation->isLastFrame() && e->stats.state_timer.isEnd()) || (power_state == Power::STATE_ATTACK && e->activeAnimation->getName() != epower->attack_anim) || instant_power) {
+			if ((e->activeAnimation->isLastFrame() && e->stats.state_timer.isEnd()) || (power_state == Power::STATE_ATTACK && e->activeAnimation->getID() != epower->attack_anim_id) || instant_power) {
 				if (!instant_power)
 					e->stats.cooldown.reset(Timer::BEGIN);
 				else
@@ -862,32 +999,32 @@ void EntityBehavior::updateState() {
 
 		case StatBlock::ENTITY_SPAWN:
 
-			e->setAnimation("spawn");
+			e->setAnimation(StringTable::ANIM_SPAWN);
 			//the second check is needed in case the entity does not have a spawn animation
-			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getName() != "spawn") {
+			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getID() != StringTable::ANIM_SPAWN) {
 				e->stats.cur_state = StatBlock::ENTITY_STANCE;
 			}
 			break;
 
 		case StatBlock::ENTITY_BLOCK:
 
-			e->setAnimation("block");
+			e->setAnimation(StringTable::ANIM_BLOCK);
 			break;
 
 		case StatBlock::ENTITY_HIT:
 
-			e->setAnimation("hit");
+			e->setAnimation(StringTable::ANIM_HIT);
 			if (e->activeAnimation->isFirstFrame()) {
 				e->stats.effects.triggered_hit = true;
 			}
-			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getName() != "hit")
+			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getID() != StringTable::ANIM_HIT)
 				e->stats.cur_state = StatBlock::ENTITY_STANCE;
 			break;
 
 		case StatBlock::ENTITY_DEAD:
 			if (e->stats.effects.triggered_death) break;
 
-			e->setAnimation("die");
+			e->setAnimation(StringTable::ANIM_DIE);
 			if (e->activeAnimation->isFirstFrame()) {
 				e->playSound(Entity::SOUND_DIE);
 				e->stats.corpse_timer.setDuration(eset->misc.corpse_timeout);
@@ -899,7 +1036,7 @@ void EntityBehavior::updateState() {
 
 				e->stats.effects.clearEffects();
 			}
-			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getName() != "die") {
+			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getID() != StringTable::ANIM_DIE) {
 				// puts renderable under object layer
 				e->stats.corpse = true;
 
@@ -922,7 +1059,7 @@ void EntityBehavior::updateState() {
 		case StatBlock::ENTITY_CRITDEAD:
 			if (e->stats.effects.triggered_death) break;
 
-			e->setAnimation("critdie");
+			e->setAnimation(StringTable::ANIM_CRITDIE);
 			if (e->activeAnimation->isFirstFrame()) {
 				e->playSound(Entity::SOUND_CRITDIE);
 				e->stats.corpse_timer.setDuration(eset->misc.corpse_timeout);
@@ -934,7 +1071,7 @@ void EntityBehavior::updateState() {
 
 				e->stats.effects.clearEffects();
 			}
-			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getName() != "critdie") {
+			if (e->activeAnimation->isLastFrame() || e->activeAnimation->getID() != StringTable::ANIM_CRITDIE) {
 				// puts renderable under object layer
 				e->stats.corpse = true;
 
@@ -30,6 +30,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef ENTITY_BEHAVIOR_H
 #define ENTITY_BEHAVIOR_H
 
+#include "EntityGrid.h"
 #include "StatBlock.h"
 #include <queue>
 
@@ -42,6 +43,33 @@ private:
 	static const float ALLY_FOLLOW_DISTANCE_STOP;
 	static const float ALLY_TELEPORT_DISTANCE;
 
+	// simulation level of detail, see getUpdateTier()
+	enum {
+		TIER_FULL = 0,
+		TIER_REDUCED = 1,
+		TIER_DORMANT = 2
+	};
+	static const float DORMANT_MARGIN;
+	static const unsigned REDUCED_INTERVAL = 4;
+	static unsigned next_think_frame;
+
+	int getUpdateTier();
+
+	// the target search done by decide(), used by findTarget() on the same frame
+	class Decision {
+	public:
+		bool valid;
+		FPoint pos; // where the entity was when the decision was made
+		StatBlock* target_stats;
+		float target_dist;
+		bool join_any_target; // an entity that accepts any target found one, so it joins combat
+		bool los;
+		Decision() : valid(false), pos(), target_stats(NULL), target_dist(0), join_any_target(false), los(false) {}
+	};
+
+	static const bool READ_ONLY = true;
+	void chooseTarget(StatBlock* target_stats, float target_distance, bool read_only, Decision& result);
+
 	// logic steps
 	void doUpkeep();
 	void findTarget();
@@ -71,6 +99,9 @@ protected:
 
 	float target_dist;
 	float hero_dist;
+
+	// scratch space for finding nearby entities
+	std::vector<Entity*> nearby_entities;
 	FPoint pursue_pos;
 	// targeting vars
 	bool los;
@@ -82,11 +113,26 @@ protected:
 	bool instant_power;
 	PowerID replaced_power_id;
 
+	// counts frames for TIER_REDUCED. Starts at a different value for each entity, so they don't all think on the same frame
+	unsigned think_frame;
+
+	// keeps the entity at TIER_FULL for a moment after it was hit
+	Timer wake_timer;
+
+	Decision decision;
+	std::vector<EntityGrid::Item> grid_scratch;
+
 public:
 	explicit EntityBehavior(Entity *_e);
 	~EntityBehavior();
 	void logic();
 
+	// the part of the AI that only reads the world. Safe to run for several entities at once, see EntityManager::decideTargets()
+	void decide();
+
+	// makes sure the entity is fully updated for the next second, no matter how far away it is
+	void wake();
+
 	std::vector<FPoint>& getPath() { return path; }
 	FPoint& getPursuePos() { return pursue_pos; };
 };
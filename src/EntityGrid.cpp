@@ -0,0 +1,144 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "Entity.h"
+#include "EntityGrid.h"
+
+#include <cmath>
+
+EntityGrid::EntityGrid()
+	: cells_w(0)
+	, cells_h(0)
+{
+}
+
+EntityGrid::~EntityGrid() {
+}
+
+/**
+ * Positions outside the map are put in the nearest border cell
+ */
+int EntityGrid::getCellX(float x) const {
+	float cx = floorf(x / static_cast<float>(CELL_SIZE));
+	if (!(cx > 0))
+		return 0;
+	if (cx >= static_cast<float>(cells_w - 1))
+		return cells_w - 1;
+	return static_cast<int>(cx);
+}
+
+int EntityGrid::getCellY(float y) const {
+	float cy = floorf(y / static_cast<float>(CELL_SIZE));
+	if (!(cy > 0))
+		return 0;
+	if (cy >= static_cast<float>(cells_h - 1))
+		return cells_h - 1;
+	return static_cast<int>(cy);
+}
+
+void EntityGrid::build(const std::vector<Entity*>& entities, int map_w, int map_h) {
+	int new_w = std::max(1, (map_w + CELL_SIZE - 1) / CELL_SIZE);
+	int new_h = std::max(1, (map_h + CELL_SIZE - 1) / CELL_SIZE);
+
+	if (new_w != cells_w || new_h != cells_h) {
+		cells_w = new_w;
+		cells_h = new_h;
+		cells.clear();
+		cells.resize(cells_w * cells_h);
+	}
+	else {
+		for (size_t i = 0; i < cells.size(); ++i) {
+			cells[i].clear();
+		}
+	}
+
+	for (size_t i = 0; i < entities.size(); ++i) {
+		const FPoint& pos = entities[i]->stats.pos;
+		cells[getCellY(pos.y) * cells_w + getCellX(pos.x)].push_back(Item(entities[i], static_cast<unsigned>(i)));
+	}
+}
+
+void EntityGrid::update(Entity* e, const FPoint& old_pos) {
+	if (cells.empty())
+		return;
+
+	int old_cell = getCellY(old_pos.y) * cells_w + getCellX(old_pos.x);
+	int new_cell = getCellY(e->stats.pos.y) * cells_w + getCellX(e->stats.pos.x);
+	if (old_cell == new_cell)
+		return;
+
+	std::vector<Item>& items = cells[old_cell];
+	for (size_t i = 0; i < items.size(); ++i) {
+		if (items[i].entity == e) {
+			cells[new_cell].push_back(items[i]);
+			items[i] = items.back();
+			items.pop_back();
+			return;
+		}
+	}
+}
+
+/**
+ * Gathers the items of all cells in the range, sorted back into entity list order
+ */
+void EntityGrid::collect(int cx_min, int cy_min, int cx_max, int cy_max, std::vector<Item>& items) const {
+	items.clear();
+	for (int cy = cy_min; cy <= cy_max; ++cy) {
+		for (int cx = cx_min; cx <= cx_max; ++cx) {
+			const std::vector<Item>& cell = cells[cy * cells_w + cx];
+			items.insert(items.end(), cell.begin(), cell.end());
+		}
+	}
+	std::sort(items.begin(), items.end());
+}
+
+void EntityGrid::getInRadius(const FPoint& pos, float radius, std::vector<Entity*>& result) {
+	getInRadius(pos, radius, result, found);
+}
+
+void EntityGrid::getInRadius(const FPoint& pos, float radius, std::vector<Entity*>& result, std::vector<Item>& scratch) const {
+	result.clear();
+	if (cells.empty())
+		return;
+
+	collect(getCellX(pos.x - radius), getCellY(pos.y - radius), getCellX(pos.x + radius), getCellY(pos.y + radius), scratch);
+
+	for (size_t i = 0; i < scratch.size(); ++i) {
+		if (Utils::calcDist(pos, scratch[i].entity->stats.pos) <= radius)
+			result.push_back(scratch[i].entity);
+	}
+}
+
+void EntityGrid::getInRect(const FPoint& top_left, const FPoint& bottom_right, std::vector<Entity*>& result) {
+	result.clear();
+	if (cells.empty())
+		return;
+
+	collect(getCellX(top_left.x), getCellY(top_left.y), getCellX(bottom_right.x), getCellY(bottom_right.y), found);
+
+	for (size_t i = 0; i < found.size(); ++i) {
+		const FPoint& pos = found[i].entity->stats.pos;
+		if (pos.x >= top_left.x && pos.y >= top_left.y && pos.x <= bottom_right.x && pos.y <= bottom_right.y)
+			result.push_back(found[i].entity);
+	}
+}
+
+bool EntityGrid::isCovered(const FPoint& pos, float radius) const {
+	if (cells.empty())
+		return true;
+
+	return getCellX(pos.x - radius) == 0 && getCellY(pos.y - radius) == 0 &&
+	       getCellX(pos.x + radius) == cells_w - 1 && getCellY(pos.y + radius) == cells_h - 1;
+}
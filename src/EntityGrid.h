@@ -0,0 +1,82 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class EntityGrid
+ *
+ * Uniform grid of square cells over the map, each holding the entities whose position is inside it.
+ * Used to find entities near a point without looking at every entity on the map.
+ *
+ * Query results are returned in the same order as the entity list the grid was built from, so callers that pick
+ * the "first" matching entity behave the same as a linear scan would.
+ */
+
+#ifndef ENTITY_GRID_H
+#define ENTITY_GRID_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class Entity;
+
+class EntityGrid {
+public:
+	class Item {
+	public:
+		Entity* entity;
+		unsigned order; // position in the entity list the grid was built from
+		Item(Entity* _entity, unsigned _order) : entity(_entity), order(_order) {}
+		bool operator<(const Item& other) const { return order < other.order; }
+	};
+
+	// width and height of a cell, in tiles
+	static const int CELL_SIZE = 4;
+
+	EntityGrid();
+	~EntityGrid();
+
+	// (re)builds the grid for a map of the given size, in tiles
+	void build(const std::vector<Entity*>& entities, int map_w, int map_h);
+
+	// moves an entity to the right cell after its position changed. Entities not in the grid are ignored
+	void update(Entity* e, const FPoint& old_pos);
+
+	// gets entities within radius of pos
+	void getInRadius(const FPoint& pos, float radius, std::vector<Entity*>& result);
+
+	// same as above, but uses the caller's scratch space instead of the grid's, so several threads can query at once
+	// as long as the grid isn't changed in the meantime
+	void getInRadius(const FPoint& pos, float radius, std::vector<Entity*>& result, std::vector<Item>& scratch) const;
+
+	// gets entities inside the given area. Positions are in tiles
+	void getInRect(const FPoint& top_left, const FPoint& bottom_right, std::vector<Entity*>& result);
+
+	// returns true if a radius query from pos would check every cell of the grid
+	bool isCovered(const FPoint& pos, float radius) const;
+
+private:
+	int getCellX(float x) const;
+	int getCellY(float y) const;
+	void collect(int cx_min, int cy_min, int cx_max, int cy_max, std::vector<Item>& items) const;
+
+	int cells_w;
+	int cells_h;
+	std::vector< std::vector<Item> > cells;
+
+	// scratch space for queries
+	std::vector<Item> found;
+};
+
+#endif // ENTITY_GRID_H
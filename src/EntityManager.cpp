@@ -36,10 +36,12 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "MapRenderer.h"
 #include "MenuActionBar.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
+#include "ThreadPool.h"
 #include "Utils.h"
 
 #include <limits>
@@ -48,7 +50,9 @@ EntityManager::EntityManager()
 	: entities()
 	, hero_stealth(0)
 	, player_blocked(false)
-	, player_blocked_timer(settings->max_frames_per_sec / 6) {
+	, player_blocked_timer(settings->max_frames_per_sec / 6)
+	, hero_flow_field()
+	, entity_grid() {
 	handleNewMap();
 }
 
@@ -77,7 +81,7 @@ size_t EntityManager::loadEntityPrototype(const std::string& type_id) {
 
 	// set cooldown_hit to duration of hit animation if undefined
 	if (!e.stats.cooldown_hit_enabled && e.animationSet) {
-		Animation *hit_anim = e.animationSet->getAnimation("hit");
+		Animation *hit_anim = e.animationSet->getAnimation(StringTable::ANIM_HIT);
 		if (hit_anim) {
 			e.stats.cooldown_hit.setDuration(hit_anim->getDuration());
 			delete hit_anim;
@@ -115,6 +119,9 @@ void EntityManager::handleNewMap () {
 	Map_Enemy me;
 	std::queue<Entity *> allies;
 
+	hero_flow_field.clear();
+	max_render_bounds = Rect();
+
 	// delete existing entities
 	for (unsigned int i=0; i < entities.size(); i++) {
 		if (entities[i]->stats.npc)
@@ -190,6 +197,8 @@ void EntityManager::handleNewMap () {
 		mapr->collider.block(e->stats.pos.x, e->stats.pos.y, MapCollision::IS_ALLY);
 	}
 
+	entity_grid.build(entities, mapr->w, mapr->h);
+
 	// load entities that can be spawn by avatar's powers
 	for (size_t i = 0; i < pc->stats.powers_list.size(); i++) {
 		PowerID power_index = pc->stats.powers_list[i];
@@ -348,6 +357,7 @@ bool EntityManager::checkPartyMembers() {
  * perform logic() for all entities
  */
 void EntityManager::logic() {
+	PROFILE_SCOPE("EntityManager::logic");
 
 	if (player_blocked) {
 		player_blocked_timer.tick();
@@ -357,14 +367,29 @@ void EntityManager::logic() {
 
 	handleSpawn();
 
+	// positions may have been changed outside of logic() (spawning, teleporting allies, etc)
+	entity_grid.build(entities, mapr->w, mapr->h);
+
+	if (pc->stats.alive)
+		hero_flow_field.setRoot(pc->stats.pos);
+	else
+		hero_flow_field.clear();
+
 	bool pc_in_combat = false;
 
+	{
+		PROFILE_SCOPE("EntityManager::decideTargets");
+		decideTargets();
+	}
+
 	std::vector<Entity*>::iterator it;
 	for (it = entities.begin(); it != entities.end(); ++it) {
 		// new actions this round
 		(*it)->stats.hero_stealth = hero_stealth;
 		if (!(*it)->stats.npc) {
+			FPoint old_pos = (*it)->stats.pos;
 			(*it)->logic();
+			entity_grid.update(*it, old_pos);
 
 			if (!pc_in_combat && (*it)->stats.alive && !(*it)->stats.hero_ally && (*it)->stats.in_combat)
 				pc_in_combat = true;
@@ -383,6 +408,37 @@ void EntityManager::logic() {
 	}
 }
 
+/**
+ * The read-only part of the AI runs for every entity before any of them acts (see EntityBehavior::decide()).
+ * Everything that changes the world still happens one entity at a time in logic(), in the order of the entity list.
+ */
+void EntityManager::decideTargets() {
+	decide_batches.clear();
+	for (size_t i = 0; i < entities.size(); i += DECIDE_BATCH_SIZE) {
+		decide_batches.push_back(DecideBatch(&entities, i, std::min(i + DECIDE_BATCH_SIZE, entities.size())));
+	}
+
+	// not worth waking up the workers for a single batch
+	if (decide_batches.size() == 1) {
+		decideBatch(&decide_batches[0]);
+		return;
+	}
+
+	for (size_t i = 0; i < decide_batches.size(); ++i) {
+		thread_pool->submit(decideBatch, &decide_batches[i]);
+	}
+	thread_pool->wait();
+}
+
+void EntityManager::decideBatch(void* data) {
+	DecideBatch* batch = static_cast<DecideBatch*>(data);
+	for (size_t i = batch->begin; i < batch->end; ++i) {
+		Entity* e = (*batch->entities)[i];
+		if (!e->stats.npc && e->behavior)
+			e->behavior->decide();
+	}
+}
+
 Entity* EntityManager::entityFocus(const Point& mouse, const FPoint& cam, bool alive_only) {
 	Point p;
 	Rect r;
@@ -392,22 +448,55 @@ Entity* EntityManager::entityFocus(const Point& mouse, const FPoint& cam, bool a
 	FPoint mousef = FPoint(mouse);
 	FPoint render_bounds_center;
 
-	for(unsigned int i = 0; i < entities.size(); i++) {
-		if (entities[i]->stats.cur_state == StatBlock::ENTITY_DEAD || entities[i]->stats.cur_state == StatBlock::ENTITY_CRITDEAD) {
+	// only entities drawn close enough to the mouse can be under it
+	// the screen area is converted to a map area that contains it, with an extra tile of padding for rounding
+	const std::vector<Entity*>* candidates = &entities;
+	if (max_render_bounds.w > 0 && max_render_bounds.h > 0) {
+		int left = mouse.x - max_render_bounds.x - max_render_bounds.w;
+		int right = mouse.x - max_render_bounds.x;
+		int top = mouse.y - max_render_bounds.y - max_render_bounds.h;
+		int bottom = mouse.y - max_render_bounds.y;
+
+		FPoint corners[4];
+		corners[0] = Utils::screenToMap(left, top, cam.x, cam.y);
+		corners[1] = Utils::screenToMap(right, top, cam.x, cam.y);
+		corners[2] = Utils::screenToMap(left, bottom, cam.x, cam.y);
+		corners[3] = Utils::screenToMap(right, bottom, cam.x, cam.y);
+
+		FPoint top_left = corners[0];
+		FPoint bottom_right = corners[0];
+		for (int i = 1; i < 4; ++i) {
+			top_left.x = std::min(top_left.x, corners[i].x);
+			top_left.y = std::min(top_left.y, corners[i].y);
+			bottom_right.x = std::max(bottom_right.x, corners[i].x);
+			bottom_right.y = std::max(bottom_right.y, corners[i].y);
+		}
+		top_left.x -= 1;
+		top_left.y -= 1;
+		bottom_right.x += 1;
+		bottom_right.y += 1;
+
+		entity_grid.getInRect(top_left, bottom_right, nearby_entities);
+		candidates = &nearby_entities;
+	}
+
+	for(unsigned int i = 0; i < candidates->size(); i++) {
+		Entity* e = (*candidates)[i];
+		if (e->stats.cur_state == StatBlock::ENTITY_DEAD || e->stats.cur_state == StatBlock::ENTITY_CRITDEAD) {
 			if (alive_only)
 				continue;
-			else if (entities[i]->stats.corpse && entities[i]->stats.corpse_timer.isEnd() && entities[i]->stats.corpse_has_timeout)
+			else if (e->stats.corpse && e->stats.corpse_timer.isEnd() && e->stats.corpse_has_timeout)
 				continue;
 		}
 
-		Rect render_bounds = entities[i]->getRenderBounds(cam);
+		Rect render_bounds = e->getRenderBounds(cam);
 		if (Utils::isWithinRect(render_bounds, mouse)) {
 			render_bounds_center.x = static_cast<float>(render_bounds.x) + (static_cast<float>(render_bounds.w)/2);
 			render_bounds_center.y = static_cast<float>(render_bounds.y) + (static_cast<float>(render_bounds.h)/2);
 			float distance = Utils::calcDist(mousef, render_bounds_center);
 			if (distance < best_distance) {
 				best_distance = distance;
-				nearest = entities[i];
+				nearest = e;
 			}
 		}
 	}
@@ -418,19 +507,33 @@ Entity* EntityManager::getNearestEntity(const FPoint& pos, bool get_corpse, floa
 	Entity* nearest = NULL;
 	float best_distance = std::numeric_limits<float>::max();
 
-	for (unsigned i=0; i<entities.size(); i++) {
-		if(!get_corpse && (entities[i]->stats.cur_state == StatBlock::ENTITY_DEAD || entities[i]->stats.cur_state == StatBlock::ENTITY_CRITDEAD)) {
-			continue;
-		}
-		if (get_corpse && !entities[i]->stats.corpse) {
-			continue;
-		}
+	// without saved_distance, nothing beyond max_range is returned, so that's as far as we need to look
+	// otherwise, widen the search until something is found
+	float search_radius = saved_distance ? static_cast<float>(EntityGrid::CELL_SIZE) : max_range;
+
+	while (true) {
+		entity_grid.getInRadius(pos, search_radius, nearby_entities);
+
+		for (unsigned i=0; i<nearby_entities.size(); i++) {
+			Entity* e = nearby_entities[i];
+			if(!get_corpse && (e->stats.cur_state == StatBlock::ENTITY_DEAD || e->stats.cur_state == StatBlock::ENTITY_CRITDEAD)) {
+				continue;
+			}
+			if (get_corpse && !e->stats.corpse) {
+				continue;
+			}
 
-		float distance = Utils::calcDist(pos, entities[i]->stats.pos);
-		if (distance < best_distance) {
-			best_distance = distance;
-			nearest = entities[i];
+			float distance = Utils::calcDist(pos, e->stats.pos);
+			if (distance < best_distance) {
+				best_distance = distance;
+				nearest = e;
+			}
 		}
+
+		if (nearest || !saved_distance || entity_grid.isCovered(pos, search_radius))
+			break;
+
+		search_radius *= 2;
 	}
 
 	if (nearest && saved_distance)
@@ -495,10 +598,24 @@ void EntityManager::addRenders(std::vector<Renderable> &r, std::vector<Renderabl
 
 		bool dead = (*it)->stats.corpse;
 		if (!dead || !(*it)->stats.corpse_timer.isEnd() || !(*it)->stats.corpse_has_timeout) {
-			if (dead && (*it)->stats.corpse_render_below)
-				(*it)->addRenders(r_dead);
-			else
-				(*it)->addRenders(r);
+			std::vector<Renderable>& dest = (dead && (*it)->stats.corpse_render_below) ? r_dead : r;
+			size_t first = dest.size();
+			(*it)->addRenders(dest);
+
+			// keep track of how far entity sprites reach, for entityFocus()
+			for (size_t i = first; i < dest.size(); ++i) {
+				Rect bounds(-dest[i].offset.x, -dest[i].offset.y, dest[i].src.w, dest[i].src.h);
+				if (max_render_bounds.w == 0 || max_render_bounds.h == 0) {
+					max_render_bounds = bounds;
+					continue;
+				}
+				int x2 = std::max(max_render_bounds.x + max_render_bounds.w, bounds.x + bounds.w);
+				int y2 = std::max(max_render_bounds.y + max_render_bounds.h, bounds.y + bounds.h);
+				max_render_bounds.x = std::min(max_render_bounds.x, bounds.x);
+				max_render_bounds.y = std::min(max_render_bounds.y, bounds.y);
+				max_render_bounds.w = x2 - max_render_bounds.x;
+				max_render_bounds.h = y2 - max_render_bounds.y;
+			}
 		}
 	}
 }
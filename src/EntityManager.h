@@ -27,6 +27,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define ENTITY_MANAGER_H
 
 #include "CommonIncludes.h"
+#include "EntityGrid.h"
+#include "FlowField.h"
 #include "Utils.h"
 
 class Animation;
@@ -41,6 +43,26 @@ protected:
 
 	std::vector<Entity> prototypes;
 
+	// largest sprite area drawn for any entity on this map, relative to the entity's position on screen
+	Rect max_render_bounds;
+
+	// scratch space for grid queries
+	std::vector<Entity*> nearby_entities;
+
+	// a range of entities that EntityBehavior::decide() is run for by one job on the thread pool
+	class DecideBatch {
+	public:
+		std::vector<Entity*>* entities;
+		size_t begin;
+		size_t end;
+		DecideBatch(std::vector<Entity*>* _entities, size_t _begin, size_t _end) : entities(_entities), begin(_begin), end(_end) {}
+	};
+	static const size_t DECIDE_BATCH_SIZE = 32;
+	std::vector<DecideBatch> decide_batches;
+
+	void decideTargets();
+	static void decideBatch(void* data);
+
 public:
 	EntityManager();
 	~EntityManager();
@@ -65,6 +87,12 @@ public:
 	bool player_blocked;
 	Timer player_blocked_timer;
 
+	// shared by all entities that are chasing the hero
+	FlowField hero_flow_field;
+
+	// entities by position. Rebuilt every frame and kept up to date as entities move during logic()
+	EntityGrid entity_grid;
+
 	static const bool GET_CORPSE = true;
 	static const bool IS_ALIVE = true;
 };
@@ -69,7 +69,10 @@ Event::Event()
 	, delay()
 	, keep_after_trigger(true)
 	, center(FPoint(-1, -1))
-	, reachable_from(Rect()) {
+	, reachable_from(Rect())
+	, requirements_generation(0)
+	, requirements_met(false)
+	, removed(false) {
 }
 
 Event::~Event() {
@@ -1029,7 +1032,7 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 
 			if (ec->s == "collision") {
 				if (tile_x >= 0 && tile_x < mapr->w && tile_y >= 0 && tile_y < mapr->h) {
-					mapr->collider.colmap[tile_x][tile_y] = tile_id;
+					mapr->collider.setTile(tile_x, tile_y, tile_id);
 					mapr->map_change = true;
 				}
 				else
@@ -1041,8 +1044,9 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 					Utils::logError("EventManager: Mapmod at position (%d, %d) contains invalid tile id (%d).", tile_x, tile_y, tile_id);
 				else if (index >= mapr->layers.size())
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is on an invalid layer.", tile_x, tile_y);
-				else if (tile_x >= 0 && tile_x < mapr->w && tile_y >= 0 && tile_y < mapr->h)
-					mapr->layers[index][tile_x][tile_y] = tile_id;
+				else if (tile_x >= 0 && tile_x < mapr->w && tile_y >= 0 && tile_y < mapr->h) {
+					mapr->setLayerTile(index, tile_x, tile_y, tile_id);
+				}
 				else
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is out of bounds 0-255.", tile_x, tile_y);
 			}
@@ -1055,13 +1059,13 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 
 			if (ec->s == "collision") {
 				if (tile_x >= 0 && tile_x < mapr->w && tile_y >= 0 && tile_y < mapr->h) {
-					unsigned short &map_tile = mapr->collider.colmap[tile_x][tile_y];
+					unsigned short map_tile = mapr->collider.colmap[tile_x][tile_y];
 					if (map_tile == tile_a) {
-						map_tile = tile_b;
+						mapr->collider.setTile(tile_x, tile_y, tile_b);
 						mapr->map_change = true;
 					}
 					else if (map_tile == tile_b) {
-						map_tile = tile_a;
+						mapr->collider.setTile(tile_x, tile_y, tile_a);
 						mapr->map_change = true;
 					}
 				}
@@ -1077,12 +1081,12 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 				else if (index >= mapr->layers.size())
 					Utils::logError("EventManager: Mapmod at position (%d, %d) is on an invalid layer.", tile_x, tile_y);
 				else if (tile_x >= 0 && tile_x < mapr->w && tile_y >= 0 && tile_y < mapr->h) {
-					unsigned short &map_tile = mapr->layers[index][tile_x][tile_y];
+					const unsigned short map_tile = mapr->layers[index][tile_x][tile_y];
 					if (map_tile == tile_a) {
-						map_tile = tile_b;
+						mapr->setLayerTile(index, tile_x, tile_y, tile_b);
 					}
 					else if (map_tile == tile_b) {
-						map_tile = tile_a;
+						mapr->setLayerTile(index, tile_x, tile_y, tile_a);
 					}
 				}
 				else
@@ -1324,8 +1328,13 @@ bool EventManager::executeEventInternal(Event &ev, bool skip_delay) {
 }
 
 
-bool EventManager::isActive(const Event &e) {
-	return camp->checkRequirementsInVector(e.components);
+bool EventManager::isActive(Event &e) {
+	const unsigned requirements_generation = camp->getGeneration(CampaignManager::CHANGE_REQUIREMENTS);
+	if (e.requirements_generation != requirements_generation) {
+		e.requirements_met = camp->checkRequirementsInVector(e.components);
+		e.requirements_generation = requirements_generation;
+	}
+	return e.requirements_met;
 }
 
 void EventManager::executeScript(const std::string& filename, float x, float y) {
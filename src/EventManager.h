@@ -155,6 +155,13 @@ public:
 	FPoint center;
 	Rect reachable_from;
 
+	// result of the last requirement check, valid while CampaignManager::getGeneration(CHANGE_REQUIREMENTS) is the same
+	unsigned requirements_generation;
+	bool requirements_met;
+
+	// set by MapRenderer when the event shouldn't be triggered again. Removed events are erased after the current check
+	bool removed;
+
 	Event();
 	~Event();
 
@@ -172,7 +179,7 @@ public:
 
 	bool executeEvent(Event &e);
 	bool executeDelayedEvent(Event &e);
-	bool isActive(const Event &e);
+	bool isActive(Event &e);
 	void executeScript(const std::string& filename, float x, float y);
 
 	std::string getIntermapIDString(size_t index);
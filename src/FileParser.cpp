@@ -32,6 +32,9 @@ FileParser::FileParser()
 	, line("")
 	, line_number(0)
 	, include_fp(NULL)
+	, recorded_entries(NULL)
+	, replay_entries(NULL)
+	, replay_index(0)
 	, new_section(false)
 	, section("")
 	, key("")
@@ -50,6 +53,8 @@ bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _erro
 	else {
 		filenames.push_back(Filesystem::convertSlashes(_filename));
 	}
+	source_files = filenames;
+	replay_entries = NULL;
 	current_index = 0;
 	line_number = 0;
 
@@ -104,6 +109,28 @@ bool FileParser::open(const std::string& _filename, bool _is_mod_file, int _erro
 	return ret;
 }
 
+void FileParser::openEntries(const std::string& filename, const std::vector<Entry>* entries) {
+	close();
+
+	requested_filename = filename;
+	filenames.clear();
+	filenames.push_back(filename);
+	source_files.clear();
+	current_index = 0;
+	line_number = 0;
+
+	replay_entries = entries;
+	replay_index = 0;
+}
+
+void FileParser::record(std::vector<Entry>* entries) {
+	recorded_entries = entries;
+}
+
+const std::vector<std::string>& FileParser::getSourceFiles() const {
+	return source_files;
+}
+
 void FileParser::close() {
 	if (include_fp) {
 		include_fp->close();
@@ -123,6 +150,35 @@ void FileParser::close() {
  * @return false if EOF, otherwise true
  */
 bool FileParser::next() {
+	if (replay_entries) {
+		if (replay_index >= replay_entries->size())
+			return false;
+
+		const Entry& entry = (*replay_entries)[replay_index++];
+		new_section = entry.new_section;
+		line_number = entry.line_number;
+		section = entry.section;
+		key = entry.key;
+		val = entry.val;
+		return true;
+	}
+
+	if (!nextLine())
+		return false;
+
+	if (recorded_entries) {
+		recorded_entries->push_back(Entry());
+		Entry& entry = recorded_entries->back();
+		entry.new_section = new_section;
+		entry.line_number = line_number;
+		entry.section = section;
+		entry.key = key;
+		entry.val = val;
+	}
+	return true;
+}
+
+bool FileParser::nextLine() {
 
 	std::string starts_with;
 	new_section = false;
@@ -138,6 +194,7 @@ bool FileParser::next() {
 					return true;
 				}
 				else {
+					source_files.insert(source_files.end(), include_fp->source_files.begin(), include_fp->source_files.end());
 					include_fp->close();
 					delete include_fp;
 					include_fp = NULL;
@@ -44,6 +44,28 @@ private:
 
 	FileParser* include_fp;
 
+public:
+	/**
+	 * A key pair as it was returned by next(), so that a file can be parsed once and replayed later
+	 */
+	class Entry {
+	public:
+		bool new_section;
+		unsigned line_number;
+		std::string section;
+		std::string key;
+		std::string val;
+		Entry() : new_section(false), line_number(0) {}
+	};
+
+private:
+	bool nextLine();
+
+	std::vector<std::string> source_files;
+	std::vector<Entry>* recorded_entries;
+	const std::vector<Entry>* replay_entries;
+	size_t replay_index;
+
 public:
 	enum {
 		ERROR_NONE = 0,
@@ -71,6 +93,20 @@ public:
 	 */
 	bool open(const std::string& filename, bool _is_mod_file, int _error_mode);
 
+	/**
+	 * @brief openEntries
+	 * Reads key pairs from a list that was recorded earlier instead of a file.
+	 * The filename is only used for error messages. getRawLine() always returns
+	 * an empty string in this mode.
+	 */
+	void openEntries(const std::string& filename, const std::vector<Entry>* entries);
+
+	// every key pair returned by next() will also be added to this list
+	void record(std::vector<Entry>* entries);
+
+	// full paths of all files that have been read, including INCLUDE files
+	const std::vector<std::string>& getSourceFiles() const;
+
 	void close();
 	bool next();
 	std::string getRawLine();
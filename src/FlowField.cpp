@@ -0,0 +1,169 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "AStarNode.h"
+#include "FlowField.h"
+#include "MapCollision.h"
+#include "MapRenderer.h"
+#include "SharedGameResources.h"
+
+#include <cfloat>
+#include <functional>
+
+FlowField::FlowField()
+	: root()
+	, has_root(false)
+{
+}
+
+FlowField::~FlowField() {
+}
+
+void FlowField::clear() {
+	has_root = false;
+	for (int i = 0; i < FIELD_COUNT; ++i) {
+		fields[i].valid = false;
+	}
+}
+
+/**
+ * Moving the root to a different tile invalidates all the fields
+ */
+void FlowField::setRoot(const FPoint& pos) {
+	Point tile(pos);
+	if (has_root && tile.x == root.x && tile.y == root.y)
+		return;
+
+	root = tile;
+	has_root = true;
+	for (int i = 0; i < FIELD_COUNT; ++i) {
+		fields[i].valid = false;
+	}
+}
+
+float FlowField::getDistance(const Field& field, int tile_x, int tile_y) const {
+	const MapCollision& collider = mapr->collider;
+	if (tile_x < 0 || tile_y < 0 || tile_x >= collider.map_size.x || tile_y >= collider.map_size.y)
+		return -1;
+
+	int index = tile_y * collider.map_size.x + tile_x;
+	if (field.dist_generation[index] != field.generation)
+		return -1;
+
+	return field.dist[index];
+}
+
+/**
+ * Dijkstra search outwards from the root, up to MAX_DISTANCE
+ */
+void FlowField::build(Field& field, int movement_type) {
+	const MapCollision& collider = mapr->collider;
+	const int map_w = collider.map_size.x;
+	const int map_h = collider.map_size.y;
+
+	if (field.dist.size() != static_cast<size_t>(map_w * map_h)) {
+		field.dist.resize(map_w * map_h);
+		field.dist_generation.assign(map_w * map_h, 0);
+		field.generation = 0;
+	}
+
+	field.generation++;
+	if (field.generation == 0) {
+		std::fill(field.dist_generation.begin(), field.dist_generation.end(), 0);
+		field.generation = 1;
+	}
+
+	field.valid = true;
+	field.tile_version = collider.getTileVersion();
+
+	if (root.x < 0 || root.y < 0 || root.x >= map_w || root.y >= map_h)
+		return;
+
+	Point neighbours[AStarNode::MAX_NEIGHBOURS];
+	const float max_distance = static_cast<float>(MAX_DISTANCE);
+
+	heap.clear();
+
+	int root_index = root.y * map_w + root.x;
+	field.dist[root_index] = 0;
+	field.dist_generation[root_index] = field.generation;
+	heap.push_back(std::pair<float, int>(0, root_index));
+
+	while (!heap.empty()) {
+		std::pop_heap(heap.begin(), heap.end(), std::greater< std::pair<float, int> >());
+		std::pair<float, int> top = heap.back();
+		heap.pop_back();
+
+		if (top.first > field.dist[top.second])
+			continue;
+
+		Point current(top.second % map_w, top.second / map_w);
+		int neighbour_count = AStarNode(current).getNeighbours(neighbours, map_w, map_h);
+
+		for (int i = 0; i < neighbour_count; ++i) {
+			const Point& n = neighbours[i];
+			if (!collider.isValidTileStatic(n.x, n.y, movement_type))
+				continue;
+
+			float d = top.first + Utils::calcDist(FPoint(current), FPoint(n));
+			if (d > max_distance)
+				continue;
+
+			int index = n.y * map_w + n.x;
+			if (field.dist_generation[index] != field.generation || d < field.dist[index]) {
+				field.dist[index] = d;
+				field.dist_generation[index] = field.generation;
+				heap.push_back(std::pair<float, int>(d, index));
+				std::push_heap(heap.begin(), heap.end(), std::greater< std::pair<float, int> >());
+			}
+		}
+	}
+}
+
+bool FlowField::getNextStep(const FPoint& pos, int movement_type, FPoint& next) {
+	if (!has_root || movement_type < 0 || movement_type >= FIELD_COUNT)
+		return false;
+
+	Field& field = fields[movement_type];
+	if (!field.valid || field.tile_version != mapr->collider.getTileVersion())
+		build(field, movement_type);
+
+	Point tile(pos);
+	float best = getDistance(field, tile.x, tile.y);
+	if (best < 0)
+		return false;
+
+	// step downhill, avoiding tiles that are currently occupied by other entities
+	Point neighbours[AStarNode::MAX_NEIGHBOURS];
+	int neighbour_count = AStarNode(tile).getNeighbours(neighbours, mapr->collider.map_size.x, mapr->collider.map_size.y);
+	bool found = false;
+
+	for (int i = 0; i < neighbour_count; ++i) {
+		const Point& n = neighbours[i];
+		float d = getDistance(field, n.x, n.y);
+		if (d < 0 || d >= best)
+			continue;
+
+		if (!mapr->collider.isValidPosition(static_cast<float>(n.x) + 0.5f, static_cast<float>(n.y) + 0.5f, movement_type, MapCollision::COLLIDE_TYPE_ALL_ENTITIES) && !(n.x == root.x && n.y == root.y))
+			continue;
+
+		best = d;
+		next.x = static_cast<float>(n.x) + 0.5f;
+		next.y = static_cast<float>(n.y) + 0.5f;
+		found = true;
+	}
+
+	return found;
+}
@@ -0,0 +1,68 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class FlowField
+ *
+ * Walking distances from every tile near a root tile (usually the hero's position) to that root.
+ * Entities that chase the root sample the field to find their next step, instead of each running their own path search.
+ *
+ * There is one field per movement type. Each field is only built when it is first sampled after the root or the
+ * collision map changed. Like AStarHierarchy, tiles blocked by entities count as walkable when building the field.
+ */
+
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class FlowField {
+public:
+	// tiles further away from the root than this (in walking distance) are not part of the field
+	static const int MAX_DISTANCE = 64;
+
+	FlowField();
+	~FlowField();
+
+	void clear();
+	void setRoot(const FPoint& pos);
+
+	// finds the neighbouring tile that gets closest to the root. Returns false if pos isn't covered by the field
+	bool getNextStep(const FPoint& pos, int movement_type, FPoint& next);
+
+private:
+	static const int FIELD_COUNT = 3;
+
+	class Field {
+	public:
+		bool valid;
+		unsigned int tile_version;
+		std::vector<float> dist;
+		std::vector<unsigned int> dist_generation;
+		unsigned int generation;
+		Field() : valid(false), tile_version(0), generation(0) {}
+	};
+
+	void build(Field& field, int movement_type);
+	float getDistance(const Field& field, int tile_x, int tile_y) const;
+
+	Point root;
+	bool has_root;
+	Field fields[FIELD_COUNT];
+	std::vector< std::pair<float, int> > heap;
+};
+
+#endif // FLOW_FIELD_H
@@ -50,6 +50,7 @@ FogOfWar::FogOfWar()
 	, bits_per_tile(0)
 	, def_mask(NULL)
 	, bounds(0,0,0,0)
+	, minimap_bounds(0,0,0,0)
 	, color_sight(255,255,255)
 	, color_fog(128,128,128)
 	, color_dark(0,0,0)
@@ -184,8 +185,7 @@ void FogOfWar::logic() {
 
 	updateTiles();
 	if (update_minimap) {
-		calcMiniBoundaries();
-		menu->mini->update(&mapr->collider, &bounds);
+		menu->mini->update(&mapr->collider, &minimap_bounds);
 		update_minimap = false;
 	}
 }
@@ -218,18 +218,6 @@ void FogOfWar::calcBoundaries() {
 	bounds.h = static_cast<short>(pc->stats.pos.y)+mask_radius;
 }
 
-void FogOfWar::calcMiniBoundaries() {
-	bounds.x = static_cast<short>(pc->stats.pos.x)-mask_radius;
-	bounds.y = static_cast<short>(pc->stats.pos.y)-mask_radius;
-	bounds.w = static_cast<short>(pc->stats.pos.x)+mask_radius;
-	bounds.h = static_cast<short>(pc->stats.pos.y)+mask_radius;
-
-	if (bounds.x < 0) bounds.x = 0;
-	if (bounds.y < 0) bounds.y = 0;
-	if (bounds.w > mapr->w) bounds.w = mapr->w;
-	if (bounds.h > mapr->h) bounds.h = mapr->h;
-}
-
 void FogOfWar::updateTiles() {
 	if (!def_mask)
 		return;
@@ -237,21 +225,49 @@ void FogOfWar::updateTiles() {
 	calcBoundaries();
 	const unsigned short * mask = &def_mask[0];
 
+	// area where the fog changed, for MapRenderer
+	Point changed_min(mapr->w, mapr->h);
+	Point changed_max(-1, -1);
+
+	// area where tiles were revealed, for the minimap
+	Point revealed_min(mapr->w, mapr->h);
+	Point revealed_max(-1, -1);
+
 	for (int x = bounds.x; x <= bounds.w; x++) {
 		for (int y = bounds.y; y <= bounds.h; y++) {
 			if (x>=0 && y>=0 && x < mapr->w && y < mapr->h) {
 				unsigned short prev_dark_tile = mapr->layers[dark_layer_id][x][y];
+				unsigned short prev_fog_tile = mapr->layers[fog_layer_id][x][y];
 
 				mapr->layers[dark_layer_id][x][y] &= *mask;
 				mapr->layers[fog_layer_id][x][y] = *mask;
 
 				if (prev_dark_tile != mapr->layers[dark_layer_id][x][y]) {
-					update_minimap = true;
+					revealed_min.x = std::min(revealed_min.x, x);
+					revealed_min.y = std::min(revealed_min.y, y);
+					revealed_max.x = std::max(revealed_max.x, x);
+					revealed_max.y = std::max(revealed_max.y, y);
+				}
+
+				if (prev_dark_tile != mapr->layers[dark_layer_id][x][y] || prev_fog_tile != mapr->layers[fog_layer_id][x][y]) {
+					changed_min.x = std::min(changed_min.x, x);
+					changed_min.y = std::min(changed_min.y, y);
+					changed_max.x = std::max(changed_max.x, x);
+					changed_max.y = std::max(changed_max.y, y);
 				}
 			}
 			mask++;
 		}
 	}
+
+	if (revealed_max.x >= 0) {
+		minimap_bounds = Rect(revealed_min.x, revealed_min.y, revealed_max.x + 1, revealed_max.y + 1);
+		update_minimap = true;
+	}
+
+	if (changed_max.x >= 0) {
+		mapr->invalidateFogHiddenTiles(Rect(changed_min.x, changed_min.y, changed_max.x - changed_min.x + 1, changed_max.y - changed_min.y + 1));
+	}
 }
 
 void FogOfWar::loadHeader(FileParser &infile) {
@@ -73,6 +73,9 @@ private:
 
 	Rect bounds;
 
+	// tiles that were revealed since the minimap was last updated. w/h are the end of the area, like MenuMiniMap::update() expects
+	Rect minimap_bounds;
+
 	Color color_sight;
 	Color color_fog;
 	Color color_dark;
@@ -81,7 +84,6 @@ private:
 	bool loaded;
 
 	void calcBoundaries();
-	void calcMiniBoundaries();
 	void updateTiles();
 
 	FPoint prev_hero_pos;
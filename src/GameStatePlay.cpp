@@ -67,6 +67,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "QuestLog.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
@@ -84,6 +85,7 @@ GameStatePlay::GameStatePlay()
 	: GameState()
 	, enemy(NULL)
 	, npc_id(-1)
+	, title_generation(0)
 	, is_first_map_load(true)
 {
 	second_timer.setDuration(settings->max_frames_per_sec);
@@ -555,9 +557,16 @@ void GameStatePlay::loadTitles() {
 }
 
 void GameStatePlay::checkTitle() {
-	if (!pc->stats.check_title || titles.empty())
+	if (titles.empty())
 		return;
 
+	// titles depend on statuses and the hero's level, stats and powers. The latter two set check_title themselves
+	const unsigned generation = camp->getGeneration(CampaignManager::CHANGE_STATUS | CampaignManager::CHANGE_LEVEL);
+	if (!pc->stats.check_title && generation == title_generation)
+		return;
+
+	title_generation = generation;
+
 	int title_id = -1;
 
 	for (unsigned i=0; i<titles.size(); i++) {
@@ -851,6 +860,8 @@ void GameStatePlay::updateActionBar(unsigned index) {
  * This includes some message passing between child object
  */
 void GameStatePlay::logic() {
+	PROFILE_SCOPE("GameStatePlay::logic");
+
 	if (inpt->window_resized)
 		refreshWidgets();
 
@@ -861,6 +872,9 @@ void GameStatePlay::logic() {
 	// check menus first (top layer gets mouse click priority)
 	menu->logic();
 
+	// pick up item, currency and level changes made by the menus, so that requirements are checked again
+	camp->checkHeroChanges();
+
 	if (!isPaused()) {
 		if (!second_timer.isEnd())
 			second_timer.tick();
@@ -881,7 +895,10 @@ void GameStatePlay::logic() {
 		checkTitle();
 
 		menu->act->checkAction(pc->action_queue);
-		pc->logic();
+		{
+			PROFILE_SCOPE("Avatar::logic");
+			pc->logic();
+		}
 
 		// transfer hero data to enemies, for AI use
 		if (pc->stats.get(Stats::STEALTH) > 100) entitym->hero_stealth = 100;
@@ -889,8 +906,14 @@ void GameStatePlay::logic() {
 
 		entitym->logic();
 		hazards->logic();
-		loot->logic();
-		npcs->logic();
+		{
+			PROFILE_SCOPE("LootManager::logic");
+			loot->logic();
+		}
+		{
+			PROFILE_SCOPE("NPCManager::logic");
+			npcs->logic();
+		}
 
 		comb->logic(mapr->cam.pos);
 	}
@@ -914,7 +937,10 @@ void GameStatePlay::logic() {
 	checkNotifications();
 	checkCancel();
 
-	mapr->logic(isPaused());
+	{
+		PROFILE_SCOPE("MapRenderer::logic");
+		mapr->logic(isPaused());
+	}
 	mapr->enemies_cleared = entitym->isCleared();
 	quests->logic();
 
@@ -1018,6 +1044,8 @@ void GameStatePlay::logic() {
  * Render all graphics for a single frame
  */
 void GameStatePlay::render() {
+	PROFILE_SCOPE("GameStatePlay::render");
+
 	if (mapr->is_spawn_map)
 		return;
 
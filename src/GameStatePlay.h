@@ -90,6 +90,8 @@ private:
 	int npc_id;
 
 	std::vector<Title> titles;
+	// CampaignManager::getGeneration() when the title was last picked
+	unsigned title_generation;
 
 	Timer second_timer;
 
@@ -59,12 +59,13 @@ Hazard::Hazard(MapCollision *_collider)
 	, parent(NULL)
 	, collider(_collider)
 	, activeAnimation(NULL)
-	, animation_name("")
+	, animation_id(StringTable::EMPTY)
 {
 }
 
 Hazard::Hazard(const Hazard& other) {
 	activeAnimation = NULL;
+	animation_id = StringTable::EMPTY;
 	*this = other;
 }
 
@@ -102,9 +103,8 @@ Hazard& Hazard::operator=(const Hazard& other) {
 	parent = other.parent;
 	children = other.children;
 
-	if (!other.animation_name.empty()) {
-		animation_name = other.animation_name;
-		loadAnimation(animation_name);
+	if (other.animation_id != StringTable::EMPTY) {
+		loadAnimation(other.animation_id);
 	}
 
 	collider = other.collider;
@@ -138,8 +138,8 @@ Hazard::~Hazard() {
 		}
 	}
 
-	if (!animation_name.empty()) {
-		anim->decreaseCount(animation_name);
+	if (animation_id != StringTable::EMPTY) {
+		anim->decreaseCount(animation_id);
 	}
 
 	if (activeAnimation) {
@@ -224,19 +224,19 @@ void Hazard::reflect() {
 	direction = Utils::calcDirection(pos.x, pos.y, pos.x + speed.x, pos.y + speed.y);
 }
 
-void Hazard::loadAnimation(const std::string &s) {
-	if (!animation_name.empty()) {
-		anim->decreaseCount(animation_name);
+void Hazard::loadAnimation(StringID _animation_id) {
+	if (animation_id != StringTable::EMPTY) {
+		anim->decreaseCount(animation_id);
 	}
 	if (activeAnimation) {
 		delete activeAnimation;
 	}
 	activeAnimation = NULL;
-	animation_name = s;
-	if (animation_name != "") {
-		anim->increaseCount(animation_name);
-		AnimationSet *animationSet = anim->getAnimationSet(animation_name);
-		activeAnimation = animationSet->getAnimation("");
+	animation_id = _animation_id;
+	if (animation_id != StringTable::EMPTY) {
+		anim->increaseCount(animation_id);
+		AnimationSet *animationSet = anim->getAnimationSet(animation_id);
+		activeAnimation = animationSet->getAnimation(StringTable::EMPTY);
 	}
 
 	anim->cleanUp();
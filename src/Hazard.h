@@ -29,6 +29,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 class Entity;
 
 #include "CommonIncludes.h"
+#include "StringTable.h"
 #include "Utils.h"
 
 class Animation;
@@ -46,7 +47,7 @@ public:
 	void logic();
 	bool hasEntity(Entity*);
 	void addEntity(Entity*);
-	void loadAnimation(const std::string &s);
+	void loadAnimation(StringID _animation_id);
 	void setAngle(const float& _angle);
 	bool isDangerousNow();
 	void addRenderable(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
@@ -86,7 +87,7 @@ private:
 
 	const MapCollision *collider;
 	Animation *activeAnimation;
-	std::string animation_name;
+	StringID animation_id; // interned filename of the animation set, or StringTable::EMPTY
 
 	// Keeps track of entities already hit
 	std::vector<Entity*> entitiesCollided;
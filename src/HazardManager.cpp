@@ -32,6 +32,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "HazardManager.h"
 #include "MapRenderer.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -45,6 +46,7 @@ HazardManager::HazardManager()
 }
 
 void HazardManager::logic() {
+	PROFILE_SCOPE("HazardManager::logic");
 
 	// remove all hazards with lifespan 0.  Most hazards still display their last frame.
 	for (size_t i=h.size(); i>0; i--) {
@@ -107,8 +109,9 @@ void HazardManager::logic() {
 		if (hazard->isDangerousNow()) {
 
 			// process hazards that can hurt enemies & allies
-			for (size_t eindex = 0; eindex < entitym->entities.size(); eindex++) {
-				Entity *e = entitym->entities[eindex];
+			entitym->entity_grid.getInRadius(hazard->pos, hazard->power->radius, nearby_entities);
+			for (size_t eindex = 0; eindex < nearby_entities.size(); eindex++) {
+				Entity *e = nearby_entities[eindex];
 
 				// hero/ally powers can only hit allies if target_party is true
 				if ((hazard->source_type == Power::SOURCE_TYPE_HERO || hazard->source_type == Power::SOURCE_TYPE_ALLY) && e->stats.hero_ally && !hazard->power->target_party) {
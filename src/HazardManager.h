@@ -36,6 +36,9 @@ class HazardManager {
 private:
 	void hitEntity(size_t index, const bool hit);
 
+	// scratch space for finding entities in range of a hazard
+	std::vector<Entity*> nearby_entities;
+
 public:
 	HazardManager();
 	~HazardManager();
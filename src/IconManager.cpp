@@ -35,18 +35,16 @@ IconManager::IconManager()
 {
 	FileParser infile;
 
+	std::vector<int> first_ids;
+	std::vector<std::string> filenames;
+
 	// @CLASS IconManager|Description of engine/icons.txt
 	if (infile.open("engine/icons.txt", FileParser::MOD_FILE, FileParser::ERROR_NONE)) {
 		while (infile.next()) {
 			if (infile.key == "icon_set") {
 				// @ATTR icon_set|repeatable(icon_id, filename) : First ID, Image file|Defines an icon graphics file to load, as well as the index of the first icon.
-				int first_id = Parse::popFirstInt(infile.val);
-				std::string filename = Parse::popFirstString(infile.val);
-
-				icon_sets.resize(icon_sets.size()+1);
-				if (!loadIconSet(icon_sets.back(), filename, first_id)) {
-					icon_sets.pop_back();
-				}
+				first_ids.push_back(Parse::popFirstInt(infile.val));
+				filenames.push_back(Parse::popFirstString(infile.val));
 			}
 			else if (infile.key == "text_offset") {
 				// @ATTR text_offset|point|A pixel offset from the top-left to place item quantity text on icons.
@@ -56,6 +54,21 @@ IconManager::IconManager()
 		infile.close();
 	}
 
+	// loading the icon sets together lets the render device pack them into the same texture
+	if (render_device && filenames.size() > 1) {
+		for (size_t i = 0; i < filenames.size(); ++i) {
+			render_device->pushQueuedImage(filenames[i], RenderDevice::ERROR_NORMAL);
+		}
+		render_device->loadQueuedImages();
+	}
+
+	for (size_t i = 0; i < filenames.size(); ++i) {
+		icon_sets.resize(icon_sets.size()+1);
+		if (!loadIconSet(icon_sets.back(), filenames[i], first_ids[i])) {
+			icon_sets.pop_back();
+		}
+	}
+
 	if (icon_sets.empty()) {
 		// no icons.txt file, so load icons.png legacy-style
 		icon_sets.resize(1);
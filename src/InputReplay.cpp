@@ -0,0 +1,396 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "Avatar.h"
+#include "Entity.h"
+#include "EntityManager.h"
+#include "InputReplay.h"
+#include "Settings.h"
+#include "SharedGameResources.h"
+#include "SharedResources.h"
+#include "Utils.h"
+
+#include <cstring>
+
+/**
+ * Recordings are meant to be played back on the machine that made them, so values are stored in native byte order
+ */
+static const char MAGIC[8] = {'F','L','A','R','E','I','N','P'};
+
+template <typename T>
+static void writeValue(std::ofstream& outfile, T value) {
+	outfile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+static bool readValue(std::ifstream& infile, T& value) {
+	return static_cast<bool>(infile.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+/**
+ * Counts can't be larger than the file itself, so a damaged file can't make us allocate huge amounts of memory
+ */
+static bool readCount(std::ifstream& infile, uint64_t file_size, uint32_t& count) {
+	return readValue(infile, count) && count <= file_size;
+}
+
+/**
+ * FNV-1a
+ */
+static void hashInt(uint32_t& hash, int value) {
+	uint32_t bits = static_cast<uint32_t>(value);
+	for (int i = 0; i < 4; ++i) {
+		hash ^= (bits >> (i * 8)) & 0xff;
+		hash *= 16777619u;
+	}
+}
+
+/**
+ * Positions are rounded, so that small differences in floating point math between builds don't count as desyncs
+ */
+static void hashPos(uint32_t& hash, const FPoint& pos) {
+	hashInt(hash, static_cast<int>(pos.x * 1000));
+	hashInt(hash, static_cast<int>(pos.y * 1000));
+}
+
+InputReplay::Frame::Frame()
+	: pressing(0)
+	, lock(0)
+	, mouse()
+	, scroll_up(false)
+	, scroll_down(false)
+	, mode(InputState::MODE_KEYBOARD_AND_MOUSE)
+	, inkeys("")
+{
+}
+
+bool InputReplay::Frame::operator==(const Frame& other) const {
+	return pressing == other.pressing && lock == other.lock && mouse.x == other.mouse.x && mouse.y == other.mouse.y &&
+	       scroll_up == other.scroll_up && scroll_down == other.scroll_down && mode == other.mode && inkeys == other.inkeys;
+}
+
+InputReplay::InputReplay()
+	: mode(MODE_NONE)
+	, filename("")
+	, seed(0)
+	, view_w(0)
+	, view_h(0)
+	, tick(0)
+	, tick_count(0)
+	, run_index(0)
+	, run_position(0)
+	, checksum_index(0)
+	, desync_count(0)
+{
+}
+
+InputReplay::~InputReplay() {
+	stop();
+}
+
+void InputReplay::startRecording(const std::string& _filename, unsigned _seed) {
+	filename = _filename;
+	seed = _seed;
+	runs.clear();
+	checksums.clear();
+	tick = 0;
+	mode = MODE_RECORD;
+}
+
+bool InputReplay::startPlayback(const std::string& _filename) {
+	filename = _filename;
+	if (!read()) {
+		Utils::logError("InputReplay: Could not read the recording '%s'.", filename.c_str());
+		runs.clear();
+		checksums.clear();
+		return false;
+	}
+
+	tick = 0;
+	run_index = 0;
+	run_position = 0;
+	checksum_index = 0;
+	desync_count = 0;
+	mode = MODE_PLAYBACK;
+
+	Utils::logInfo("InputReplay: Playing back %u ticks from '%s'.", tick_count, filename.c_str());
+	return true;
+}
+
+bool InputReplay::stop() {
+	bool success = true;
+	if (mode == MODE_RECORD) {
+		tick_count = tick;
+		success = write();
+	}
+
+	mode = MODE_NONE;
+	return success;
+}
+
+void InputReplay::beforeLogic() {
+	if (mode == MODE_RECORD) {
+		// the view size is only known once the render device exists
+		if (tick == 0) {
+			view_w = settings->view_w;
+			view_h = settings->view_h;
+		}
+
+		Frame frame;
+		readInput(frame);
+		if (runs.empty() || runs.back().frame != frame) {
+			runs.push_back(Run());
+			runs.back().frame = frame;
+		}
+		runs.back().length++;
+	}
+	else if (mode == MODE_PLAYBACK) {
+		if (tick == 0 && (view_w != settings->view_w || view_h != settings->view_h)) {
+			Utils::logError("InputReplay: The recording was made at %dx%d, but the view is %dx%d. Mouse input will not match.", view_w, view_h, settings->view_w, settings->view_h);
+		}
+
+		if (isFinished())
+			return;
+
+		writeInput(runs[run_index].frame);
+
+		run_position++;
+		if (run_position >= runs[run_index].length) {
+			run_index++;
+			run_position = 0;
+		}
+	}
+}
+
+void InputReplay::afterLogic() {
+	if (mode == MODE_NONE || isFinished())
+		return;
+
+	tick++;
+
+	if (tick % CHECKSUM_INTERVAL == 0) {
+		uint32_t value = calcChecksum();
+
+		if (mode == MODE_RECORD) {
+			checksums.push_back(Checksum(tick, value));
+		}
+		else {
+			while (checksum_index < checksums.size() && checksums[checksum_index].tick < tick) {
+				checksum_index++;
+			}
+			if (checksum_index < checksums.size() && checksums[checksum_index].tick == tick && checksums[checksum_index].value != value) {
+				if (desync_count == 0)
+					Utils::logError("InputReplay: Desynced at tick %u. The game no longer matches the recording.", tick);
+				desync_count++;
+			}
+		}
+	}
+
+	if (isFinished()) {
+		Utils::logInfo("InputReplay: Finished playing back %u ticks. %u checksum(s) did not match.", tick_count, desync_count);
+	}
+}
+
+bool InputReplay::isRecording() const {
+	return mode == MODE_RECORD;
+}
+
+bool InputReplay::isPlaying() const {
+	return mode == MODE_PLAYBACK;
+}
+
+bool InputReplay::isFinished() const {
+	return mode == MODE_PLAYBACK && tick >= tick_count;
+}
+
+unsigned InputReplay::getSeed() const {
+	return seed;
+}
+
+unsigned InputReplay::getTickCount() const {
+	return tick_count;
+}
+
+unsigned InputReplay::getDesyncCount() const {
+	return desync_count;
+}
+
+void InputReplay::readInput(Frame& frame) {
+	frame.pressing = 0;
+	frame.lock = 0;
+	for (int i = 0; i < InputState::KEY_COUNT; ++i) {
+		if (inpt->pressing[i])
+			frame.pressing |= (static_cast<uint64_t>(1) << i);
+		if (inpt->lock[i])
+			frame.lock |= (static_cast<uint64_t>(1) << i);
+	}
+
+	frame.mouse = inpt->mouse;
+	frame.scroll_up = inpt->scroll_up;
+	frame.scroll_down = inpt->scroll_down;
+	frame.mode = inpt->mode;
+	frame.inkeys = inpt->inkeys;
+}
+
+void InputReplay::writeInput(const Frame& frame) {
+	for (int i = 0; i < InputState::KEY_COUNT; ++i) {
+		inpt->pressing[i] = (frame.pressing & (static_cast<uint64_t>(1) << i)) != 0;
+		inpt->lock[i] = (frame.lock & (static_cast<uint64_t>(1) << i)) != 0;
+	}
+
+	inpt->mouse = frame.mouse;
+	inpt->scroll_up = frame.scroll_up;
+	inpt->scroll_down = frame.scroll_down;
+	inpt->mode = frame.mode;
+	inpt->inkeys = frame.inkeys;
+}
+
+/**
+ * Covers the hero and every entity on the map. Outside of gameplay there is nothing to compare
+ */
+uint32_t InputReplay::calcChecksum() {
+	uint32_t hash = 2166136261u;
+	if (!pc || !entitym)
+		return hash;
+
+	hashPos(hash, pc->stats.pos);
+	hashInt(hash, static_cast<int>(pc->stats.hp));
+	hashInt(hash, static_cast<int>(pc->stats.mp));
+
+	hashInt(hash, static_cast<int>(entitym->entities.size()));
+	for (size_t i = 0; i < entitym->entities.size(); ++i) {
+		const StatBlock& stats = entitym->entities[i]->stats;
+		hashPos(hash, stats.pos);
+		hashInt(hash, static_cast<int>(stats.hp));
+	}
+
+	return hash;
+}
+
+bool InputReplay::write() {
+	std::ofstream outfile(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open()) {
+		Utils::logError("InputReplay: Could not write '%s'.", filename.c_str());
+		return false;
+	}
+
+	outfile.write(MAGIC, sizeof(MAGIC));
+	writeValue<uint32_t>(outfile, VERSION);
+	writeValue<uint32_t>(outfile, seed);
+	writeValue<int32_t>(outfile, view_w);
+	writeValue<int32_t>(outfile, view_h);
+	writeValue<uint32_t>(outfile, tick_count);
+
+	writeValue<uint32_t>(outfile, static_cast<uint32_t>(runs.size()));
+	for (size_t i = 0; i < runs.size(); ++i) {
+		const Frame& frame = runs[i].frame;
+		writeValue<uint32_t>(outfile, runs[i].length);
+		writeValue<uint64_t>(outfile, frame.pressing);
+		writeValue<uint64_t>(outfile, frame.lock);
+		writeValue<int32_t>(outfile, frame.mouse.x);
+		writeValue<int32_t>(outfile, frame.mouse.y);
+		writeValue<uint8_t>(outfile, static_cast<uint8_t>((frame.scroll_up ? 1 : 0) | (frame.scroll_down ? 2 : 0)));
+		writeValue<uint8_t>(outfile, static_cast<uint8_t>(frame.mode));
+		writeValue<uint32_t>(outfile, static_cast<uint32_t>(frame.inkeys.length()));
+		outfile.write(frame.inkeys.data(), frame.inkeys.length());
+	}
+
+	writeValue<uint32_t>(outfile, static_cast<uint32_t>(checksums.size()));
+	for (size_t i = 0; i < checksums.size(); ++i) {
+		writeValue<uint32_t>(outfile, checksums[i].tick);
+		writeValue<uint32_t>(outfile, checksums[i].value);
+	}
+
+	bool success = outfile.good();
+	outfile.close();
+
+	if (success)
+		Utils::logInfo("InputReplay: Recorded %u ticks to '%s'.", tick_count, filename.c_str());
+	else
+		Utils::logError("InputReplay: Could not write '%s'.", filename.c_str());
+	return success;
+}
+
+bool InputReplay::read() {
+	std::ifstream infile(filename.c_str(), std::ios::in | std::ios::binary);
+	if (!infile.is_open())
+		return false;
+
+	infile.seekg(0, std::ios::end);
+	const uint64_t file_size = static_cast<uint64_t>(infile.tellg());
+	infile.seekg(0, std::ios::beg);
+
+	char magic[sizeof(MAGIC)];
+	uint32_t version, value;
+	int32_t w, h;
+	if (!infile.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+		return false;
+	if (!readValue(infile, version) || version != VERSION)
+		return false;
+	if (!readValue(infile, value))
+		return false;
+	seed = value;
+	if (!readValue(infile, w) || !readValue(infile, h))
+		return false;
+	view_w = w;
+	view_h = h;
+	if (!readValue(infile, value))
+		return false;
+	tick_count = value;
+
+	uint32_t count;
+	if (!readCount(infile, file_size, count))
+		return false;
+	runs.resize(count);
+
+	uint64_t total_length = 0;
+	for (size_t i = 0; i < runs.size(); ++i) {
+		Frame& frame = runs[i].frame;
+		int32_t x, y;
+		uint8_t flags, input_mode;
+		uint32_t inkeys_length;
+
+		if (!readValue(infile, runs[i].length) || !readValue(infile, frame.pressing) || !readValue(infile, frame.lock))
+			return false;
+		if (!readValue(infile, x) || !readValue(infile, y) || !readValue(infile, flags) || !readValue(infile, input_mode))
+			return false;
+		if (!readCount(infile, file_size, inkeys_length))
+			return false;
+
+		frame.mouse = Point(x, y);
+		frame.scroll_up = (flags & 1) != 0;
+		frame.scroll_down = (flags & 2) != 0;
+		frame.mode = input_mode;
+		frame.inkeys.resize(inkeys_length);
+		if (inkeys_length > 0 && !infile.read(&frame.inkeys[0], inkeys_length))
+			return false;
+
+		total_length += runs[i].length;
+	}
+
+	// the runs must cover every tick exactly
+	if (total_length != tick_count)
+		return false;
+
+	if (!readCount(infile, file_size, count))
+		return false;
+	checksums.resize(count);
+	for (size_t i = 0; i < checksums.size(); ++i) {
+		if (!readValue(infile, checksums[i].tick) || !readValue(infile, checksums[i].value))
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,131 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class InputReplay
+ *
+ * Records the input state of every logic tick, so that a session can be played back exactly.
+ *
+ * Call beforeLogic() right after InputState::handle() and afterLogic() right after GameSwitcher::logic(). While
+ * recording, beforeLogic() stores what InputState read from SDL. During playback it replaces that with the stored
+ * state, so live input is ignored (except for closing the window).
+ *
+ * The file also holds the rand() seed of the session and a checksum of the hero and entities once per second. A
+ * playback that doesn't match these checksums has desynced, which means the game logic no longer runs the same way.
+ * Playback needs the same mods, save files, resolution and settings as the recording.
+ */
+
+#ifndef INPUT_REPLAY_H
+#define INPUT_REPLAY_H
+
+#include "CommonIncludes.h"
+#include "InputState.h"
+
+class InputReplay {
+public:
+	// increase this whenever the file format changes
+	static const unsigned VERSION = 1;
+
+	// number of ticks between checksums
+	static const unsigned CHECKSUM_INTERVAL = 60;
+
+	InputReplay();
+	~InputReplay();
+
+	// the file is written by stop(), or when this object is destroyed
+	void startRecording(const std::string& _filename, unsigned _seed);
+
+	// reads a recording. Use getSeed() to seed rand() before the game starts
+	bool startPlayback(const std::string& _filename);
+
+	// ends recording or playback. Returns false if a recording could not be written
+	bool stop();
+
+	void beforeLogic();
+	void afterLogic();
+
+	bool isRecording() const;
+	bool isPlaying() const;
+	// true once every recorded tick was played back
+	bool isFinished() const;
+
+	unsigned getSeed() const;
+	unsigned getTickCount() const;
+	unsigned getDesyncCount() const;
+
+private:
+	// pressing[] and lock[] are stored as bits
+	typedef char key_count_fits_in_bits[(InputState::KEY_COUNT <= 64) ? 1 : -1];
+
+	class Frame {
+	public:
+		uint64_t pressing;
+		uint64_t lock;
+		Point mouse;
+		bool scroll_up;
+		bool scroll_down;
+		unsigned mode;
+		std::string inkeys;
+
+		Frame();
+		bool operator==(const Frame& other) const;
+		bool operator!=(const Frame& other) const { return !(*this == other); }
+	};
+
+	// consecutive ticks with the same input are stored once
+	class Run {
+	public:
+		uint32_t length;
+		Frame frame;
+		Run() : length(0) {}
+	};
+
+	class Checksum {
+	public:
+		uint32_t tick;
+		uint32_t value;
+		Checksum(uint32_t _tick = 0, uint32_t _value = 0) : tick(_tick), value(_value) {}
+	};
+
+	enum {
+		MODE_NONE = 0,
+		MODE_RECORD = 1,
+		MODE_PLAYBACK = 2
+	};
+
+	void readInput(Frame& frame);
+	void writeInput(const Frame& frame);
+	uint32_t calcChecksum();
+	bool write();
+	bool read();
+
+	int mode;
+	std::string filename;
+	unsigned seed;
+	int view_w;
+	int view_h;
+
+	std::vector<Run> runs;
+	std::vector<Checksum> checksums;
+
+	unsigned tick;
+	unsigned tick_count;
+	size_t run_index;
+	uint32_t run_position;
+	size_t checksum_index;
+	unsigned desync_count;
+};
+
+#endif // INPUT_REPLAY_H
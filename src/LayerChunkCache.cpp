@@ -0,0 +1,416 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "EngineSettings.h"
+#include "LayerChunkCache.h"
+#include "MapLayer.h"
+#include "RenderDevice.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "TileSet.h"
+
+#include <cmath>
+
+/**
+ * Integer division that rounds towards negative infinity
+ */
+static int floorDiv(int a, int b) {
+	return (a >= 0) ? a / b : -((-a + b - 1) / b);
+}
+
+LayerChunkCache::LayerChunkCache()
+	: failed(false)
+	, frame(1)
+{
+}
+
+LayerChunkCache::~LayerChunkCache() {
+	clear();
+}
+
+void LayerChunkCache::clear() {
+	for (size_t i = 0; i < layers.size(); ++i) {
+		for (size_t j = 0; j < layers[i].chunks.size(); ++j) {
+			delete layers[i].chunks[j].sprite;
+		}
+	}
+	layers.clear();
+
+	for (size_t i = 0; i < free_sprites.size(); ++i) {
+		delete free_sprites[i];
+	}
+	free_sprites.clear();
+
+	failed = false;
+}
+
+/**
+ * The position renderIsoLayer() and renderOrthoLayer() draw a tile at, relative to where they would draw tile (0, 0)
+ * without the centering
+ */
+Point LayerChunkCache::getTilePos(int x, int y) const {
+	if (eset->tileset.orientation == eset->tileset.TILESET_ORTHOGONAL) {
+		return Point(x * eset->tileset.tile_w + eset->tileset.tile_w_half, y * eset->tileset.tile_h + eset->tileset.tile_h_half);
+	}
+	else {
+		return Point((x - y) * eset->tileset.tile_w_half, (x + y) * eset->tileset.tile_h_half + eset->tileset.tile_h_half);
+	}
+}
+
+/**
+ * Finds the tiles whose positions are inside the given area, which is in the same coordinates as getTilePos()
+ */
+void LayerChunkCache::getTileRange(const Rect& area, int map_w, int map_h, Point& range_min, Point& range_max) const {
+	const float tile_w = static_cast<float>(eset->tileset.tile_w);
+	const float tile_h = static_cast<float>(eset->tileset.tile_h);
+	const float tile_w_half = static_cast<float>(eset->tileset.tile_w_half);
+	const float tile_h_half = static_cast<float>(eset->tileset.tile_h_half);
+
+	float min_x = 0;
+	float min_y = 0;
+	float max_x = 0;
+	float max_y = 0;
+
+	for (int corner = 0; corner < 4; ++corner) {
+		float px = static_cast<float>((corner & 1) ? area.x + area.w : area.x);
+		float py = static_cast<float>((corner & 2) ? area.y + area.h : area.y);
+		float tx, ty;
+
+		if (eset->tileset.orientation == eset->tileset.TILESET_ORTHOGONAL) {
+			tx = (px - tile_w_half) / tile_w;
+			ty = (py - tile_h_half) / tile_h;
+		}
+		else {
+			float sx = px / tile_w_half;
+			float sy = (py - tile_h_half) / tile_h_half;
+			tx = (sx + sy) / 2;
+			ty = (sy - sx) / 2;
+		}
+
+		if (corner == 0 || tx < min_x) min_x = tx;
+		if (corner == 0 || ty < min_y) min_y = ty;
+		if (corner == 0 || tx > max_x) max_x = tx;
+		if (corner == 0 || ty > max_y) max_y = ty;
+	}
+
+	range_min.x = std::max(0, static_cast<int>(floorf(min_x)) - 1);
+	range_min.y = std::max(0, static_cast<int>(floorf(min_y)) - 1);
+	range_max.x = std::min(map_w - 1, static_cast<int>(ceilf(max_x)) + 1);
+	range_max.y = std::min(map_h - 1, static_cast<int>(ceilf(max_y)) + 1);
+}
+
+void LayerChunkCache::setupLayer(Layer& layer, const Map_Layer& layerdata, const TileSet& tile_set) {
+	const int map_w = layerdata.getWidth();
+	const int map_h = layerdata.getHeight();
+
+	layer.margin.x = (tile_set.max_size_x + 1) * eset->tileset.tile_w;
+	layer.margin.y = (tile_set.max_size_y + 1) * eset->tileset.tile_h;
+
+	Point corners[4] = { getTilePos(0, 0), getTilePos(map_w, 0), getTilePos(0, map_h), getTilePos(map_w, map_h) };
+	Point min_pos = corners[0];
+	Point max_pos = corners[0];
+	for (int i = 1; i < 4; ++i) {
+		min_pos.x = std::min(min_pos.x, corners[i].x);
+		min_pos.y = std::min(min_pos.y, corners[i].y);
+		max_pos.x = std::max(max_pos.x, corners[i].x);
+		max_pos.y = std::max(max_pos.y, corners[i].y);
+	}
+
+	layer.bounds.x = min_pos.x - layer.margin.x;
+	layer.bounds.y = min_pos.y - layer.margin.y;
+	layer.bounds.w = max_pos.x - min_pos.x + 2 * layer.margin.x;
+	layer.bounds.h = max_pos.y - min_pos.y + 2 * layer.margin.y;
+
+	layer.chunks_w = (layer.bounds.w + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	layer.chunks_h = (layer.bounds.h + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	layer.chunks.clear();
+	layer.chunks.resize(layer.chunks_w * layer.chunks_h);
+	layer.ready = true;
+}
+
+void LayerChunkCache::invalidate(size_t layer_index, int x, int y) {
+	if (layer_index >= layers.size() || !layers[layer_index].ready)
+		return;
+
+	Layer& layer = layers[layer_index];
+	const Point pos = getTilePos(x, y);
+
+	const int cx_min = std::max(0, floorDiv(pos.x - layer.margin.x - layer.bounds.x, CHUNK_SIZE));
+	const int cy_min = std::max(0, floorDiv(pos.y - layer.margin.y - layer.bounds.y, CHUNK_SIZE));
+	const int cx_max = std::min(layer.chunks_w - 1, floorDiv(pos.x + layer.margin.x - layer.bounds.x, CHUNK_SIZE));
+	const int cy_max = std::min(layer.chunks_h - 1, floorDiv(pos.y + layer.margin.y - layer.bounds.y, CHUNK_SIZE));
+
+	for (int cy = cy_min; cy <= cy_max; ++cy) {
+		for (int cx = cx_min; cx <= cx_max; ++cx) {
+			layer.chunks[cy * layer.chunks_w + cx].dirty = true;
+		}
+	}
+}
+
+/**
+ * The part of the chunk area that the image of the tile at (x, y) covers, in the same coordinates as getTilePos()
+ * Returns false if the tile is empty or doesn't reach into the area
+ */
+bool LayerChunkCache::getTileRect(int x, int y, const Map_Layer& layerdata, const TileSet& tile_set, const Rect& area, Rect& rect) {
+	const unsigned short tile_id = layerdata[x][y];
+	if (tile_id == 0)
+		return false;
+
+	const Tile_Def& tile = tile_set.tiles[tile_id];
+	if (!tile.tile)
+		return false;
+
+	const Rect& clip = tile.tile->getClip();
+	const Point pos = getTilePos(x, y);
+	const int x0 = std::max(pos.x - tile.offset.x, area.x);
+	const int y0 = std::max(pos.y - tile.offset.y, area.y);
+	const int x1 = std::min(pos.x - tile.offset.x + clip.w, area.x + area.w);
+	const int y1 = std::min(pos.y - tile.offset.y + clip.h, area.y + area.h);
+	if (x0 >= x1 || y0 >= y1)
+		return false;
+
+	rect = Rect(x0, y0, x1 - x0, y1 - y0);
+	return true;
+}
+
+/**
+ * Lists the tiles that reach into the chunk area, in the same order the layer renderers use
+ */
+void LayerChunkCache::findTiles(const Rect& area, const Point& margin, const Map_Layer& layerdata, const TileSet& tile_set, std::vector<Point>& tiles) {
+	Rect search(area.x - margin.x, area.y - margin.y, area.w + 2 * margin.x, area.h + 2 * margin.y);
+	Point range_min, range_max;
+	getTileRange(search, layerdata.getWidth(), layerdata.getHeight(), range_min, range_max);
+
+	Rect rect;
+
+	if (eset->tileset.orientation == eset->tileset.TILESET_ORTHOGONAL) {
+		for (int y = range_min.y; y <= range_max.y; ++y) {
+			for (int x = range_min.x; x <= range_max.x; ++x) {
+				if (getTileRect(x, y, layerdata, tile_set, area, rect))
+					tiles.push_back(Point(x, y));
+			}
+		}
+	}
+	else {
+		// back to front diagonals, left to right along each diagonal
+		for (int sum = range_min.x + range_min.y; sum <= range_max.x + range_max.y; ++sum) {
+			const int x_end = std::min(range_max.x, sum - range_min.y);
+			for (int x = std::max(range_min.x, sum - range_max.y); x <= x_end; ++x) {
+				if (getTileRect(x, sum - x, layerdata, tile_set, area, rect))
+					tiles.push_back(Point(x, sum - x));
+			}
+		}
+	}
+}
+
+/**
+ * Copies a single tile onto the chunk image, creating the image if this is the first tile on it.
+ * Returns false if the image couldn't be created
+ */
+bool LayerChunkCache::bakeTile(Chunk& chunk, const Rect& area, int x, int y, const Map_Layer& layerdata, const TileSet& tile_set) {
+	const Tile_Def& tile = tile_set.tiles[layerdata[x][y]];
+
+	Rect clip = tile.tile->getClip();
+	const Point pos = getTilePos(x, y);
+	Rect dest(pos.x - tile.offset.x - area.x, pos.y - tile.offset.y - area.y, clip.w, clip.h);
+
+	if (!chunk.sprite) {
+		if (!free_sprites.empty()) {
+			chunk.sprite = free_sprites.back();
+			free_sprites.pop_back();
+			chunk.sprite->getGraphics()->fillWithColor(Color(0,0,0,0));
+		}
+		else {
+			Image *graphics = render_device->createImage(CHUNK_SIZE, CHUNK_SIZE);
+			if (!graphics)
+				return false;
+			chunk.sprite = graphics->createSprite();
+			graphics->unref();
+		}
+	}
+
+	render_device->renderToImage(tile.tile->getGraphics(), clip, chunk.sprite->getGraphics(), dest);
+	return true;
+}
+
+void LayerChunkCache::releaseSprite(Chunk& chunk) {
+	if (chunk.sprite) {
+		free_sprites.push_back(chunk.sprite);
+		chunk.sprite = NULL;
+	}
+}
+
+/**
+ * Redraws the static tiles that overlap the chunk, and finds the tiles that are drawn one by one
+ */
+bool LayerChunkCache::bake(Chunk& chunk, const Rect& area, const Point& margin, const Map_Layer& layerdata, const TileSet& tile_set) {
+	chunk.dirty = false;
+	chunk.per_tile = false;
+	chunk.tiles.clear();
+
+	std::vector<Point> tiles;
+	findTiles(area, margin, layerdata, tile_set, tiles);
+
+	// a static tile drawn after an animated one must stay in front of it, which isn't possible if the animated tile
+	// is drawn on top of the chunk image
+	std::vector<Rect> anim_rects;
+	bool has_static = false;
+	for (size_t i = 0; i < tiles.size() && !chunk.per_tile; ++i) {
+		Rect rect;
+		getTileRect(tiles[i].x, tiles[i].y, layerdata, tile_set, area, rect);
+
+		if (tile_set.isAnimated(layerdata[tiles[i].x][tiles[i].y])) {
+			anim_rects.push_back(rect);
+			chunk.tiles.push_back(tiles[i]);
+			continue;
+		}
+
+		has_static = true;
+		for (size_t j = 0; j < anim_rects.size(); ++j) {
+			const Rect& anim_rect = anim_rects[j];
+			if (rect.x < anim_rect.x + anim_rect.w && anim_rect.x < rect.x + rect.w && rect.y < anim_rect.y + anim_rect.h && anim_rect.y < rect.y + rect.h) {
+				chunk.per_tile = true;
+				break;
+			}
+		}
+	}
+
+	if (chunk.per_tile) {
+		chunk.tiles = tiles;
+		releaseSprite(chunk);
+		return true;
+	}
+
+	if (!has_static) {
+		releaseSprite(chunk);
+		return true;
+	}
+
+	if (chunk.sprite)
+		chunk.sprite->getGraphics()->fillWithColor(Color(0,0,0,0));
+
+	for (size_t i = 0; i < tiles.size(); ++i) {
+		if (tile_set.isAnimated(layerdata[tiles[i].x][tiles[i].y]))
+			continue;
+		if (!bakeTile(chunk, area, tiles[i].x, tiles[i].y, layerdata, tile_set))
+			return false;
+	}
+
+	// blending the tiles onto the transparent image multiplied their colors by alpha, which must not happen twice when the chunk is drawn
+	if (chunk.sprite && !chunk.sprite->getGraphics()->usePremultipliedAlpha())
+		return false;
+
+	return true;
+}
+
+/**
+ * Draws the part of a tile that is inside the chunk area
+ */
+void LayerChunkCache::renderTile(int x, int y, const Map_Layer& layerdata, const TileSet& tile_set, const Rect& area, const Point& origin) {
+	Rect rect;
+	if (!getTileRect(x, y, layerdata, tile_set, area, rect))
+		return;
+
+	const Tile_Def& tile = tile_set.tiles[layerdata[x][y]];
+	const Rect clip = tile.tile->getClip();
+	const Point pos = getTilePos(x, y);
+
+	tile.tile->setClip(clip.x + rect.x - (pos.x - tile.offset.x), clip.y + rect.y - (pos.y - tile.offset.y), rect.w, rect.h);
+	tile.tile->setDest(rect.x + origin.x, rect.y + origin.y);
+	tile.tile->alpha_mod = 255;
+	render_device->render(tile.tile);
+
+	// the sprite is shared by every tile with this id
+	tile.tile->setClipFromRect(clip);
+}
+
+bool LayerChunkCache::render(size_t layer_index, const Map_Layer& layerdata, const TileSet& tile_set, const FPoint& cam) {
+	if (failed)
+		return false;
+
+	if (layer_index >= layers.size())
+		layers.resize(layer_index + 1);
+
+	Layer& layer = layers[layer_index];
+	if (!layer.ready)
+		setupLayer(layer, layerdata, tile_set);
+
+	// screen position of getTilePos(0, 0)
+	const Point origin = Utils::mapToScreen(0, 0, cam.x, cam.y);
+
+	const int view_x = -origin.x - layer.bounds.x;
+	const int view_y = -origin.y - layer.bounds.y;
+	const int cx_min = std::max(0, floorDiv(view_x, CHUNK_SIZE));
+	const int cy_min = std::max(0, floorDiv(view_y, CHUNK_SIZE));
+	const int cx_max = std::min(layer.chunks_w - 1, floorDiv(view_x + settings->view_w - 1, CHUNK_SIZE));
+	const int cy_max = std::min(layer.chunks_h - 1, floorDiv(view_y + settings->view_h - 1, CHUNK_SIZE));
+
+	for (int cy = cy_min; cy <= cy_max; ++cy) {
+		for (int cx = cx_min; cx <= cx_max; ++cx) {
+			Chunk& chunk = layer.chunks[cy * layer.chunks_w + cx];
+			const Rect area(layer.bounds.x + cx * CHUNK_SIZE, layer.bounds.y + cy * CHUNK_SIZE, CHUNK_SIZE, CHUNK_SIZE);
+
+			if (chunk.dirty && !bake(chunk, area, layer.margin, layerdata, tile_set)) {
+				Utils::logError("LayerChunkCache: Could not create chunk image. Layers will be drawn tile by tile.");
+				failed = true;
+				return false;
+			}
+
+			chunk.last_used = frame;
+			if (chunk.sprite) {
+				chunk.sprite->setDest(area.x + origin.x, area.y + origin.y);
+				render_device->render(chunk.sprite);
+			}
+
+			for (size_t i = 0; i < chunk.tiles.size(); ++i) {
+				renderTile(chunk.tiles[i].x, chunk.tiles[i].y, layerdata, tile_set, area, origin);
+			}
+		}
+	}
+	return true;
+}
+
+void LayerChunkCache::endFrame() {
+	const size_t max_chunks = static_cast<size_t>(TEXTURE_BUDGET) * 1024 * 1024 / (CHUNK_SIZE * CHUNK_SIZE * 4);
+
+	std::vector<Chunk*> unused;
+	size_t baked = 0;
+
+	for (size_t i = 0; i < layers.size(); ++i) {
+		for (size_t j = 0; j < layers[i].chunks.size(); ++j) {
+			Chunk& chunk = layers[i].chunks[j];
+			if (!chunk.sprite)
+				continue;
+
+			baked++;
+			if (chunk.last_used != frame)
+				unused.push_back(&chunk);
+		}
+	}
+
+	if (baked > max_chunks && !unused.empty()) {
+		// chunks on screen are always kept, even if they alone go over the budget
+		std::sort(unused.begin(), unused.end(), SortByLastUsed());
+		const size_t count = std::min(baked - max_chunks, unused.size());
+
+		for (size_t i = 0; i < count; ++i) {
+			free_sprites.push_back(unused[i]->sprite);
+			unused[i]->sprite = NULL;
+			unused[i]->dirty = true;
+		}
+	}
+
+	frame++;
+}
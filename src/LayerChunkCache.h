@@ -0,0 +1,117 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class LayerChunkCache
+ *
+ * Pre-renders map layers into large square images ("chunks"), so a layer can be drawn with a few big sprites
+ * instead of one sprite per tile.
+ *
+ * Chunks are laid out over the layer in pixel coordinates relative to the map origin, so they don't depend on
+ * the camera. A chunk is rendered the first time it's on screen, and again after one of its tiles was changed
+ * with invalidate(). Chunks that leave the view keep their image, so scrolling back doesn't render them again.
+ * Once the chunk images use more than TEXTURE_BUDGET, the ones that were drawn least recently give their image
+ * back to a pool to be reused by other chunks.
+ *
+ * Drawing order: the tiles of a layer must look as if they were drawn one by one in the order the layer renderers
+ * use (later tiles in front). Every chunk is drawn clipped to its own square, so chunks never cover each other.
+ * Within a chunk, animated tiles are left out of the image and drawn one by one on top of it. That only keeps the
+ * order if no static tile that comes after an animated tile overlaps it. Chunks where one does are not pre-rendered
+ * at all; all of their tiles are drawn one by one, in order and clipped to the chunk.
+ *
+ * Tiles are copied as they are, so only layers that never need per-tile color or alpha changes should be cached.
+ * Chunk images hold colors premultiplied by alpha, so semi-transparent tile edges look the same as when the tiles
+ * are drawn one by one. If the render device can't draw such images, the layers are drawn tile by tile.
+ */
+
+#ifndef LAYER_CHUNK_CACHE_H
+#define LAYER_CHUNK_CACHE_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class Map_Layer;
+class Sprite;
+class TileSet;
+
+class LayerChunkCache {
+public:
+	// width and height of a chunk, in pixels
+	static const int CHUNK_SIZE = 512;
+
+	// memory that chunk images may use before the least recently drawn ones are recycled, in megabytes
+	static const int TEXTURE_BUDGET = 64;
+
+	LayerChunkCache();
+	~LayerChunkCache();
+
+	// drops all chunks (e.g. when loading a map)
+	void clear();
+
+	// marks every chunk that the tile at (x, y) is drawn on as out of date
+	void invalidate(size_t layer_index, int x, int y);
+
+	// draws the visible part of a layer. Returns false if the chunks can't be created, so the layer must be drawn tile by tile
+	bool render(size_t layer_index, const Map_Layer& layerdata, const TileSet& tile_set, const FPoint& cam);
+
+	// recycles the images of the least recently drawn chunks if they use more than TEXTURE_BUDGET
+	void endFrame();
+
+private:
+	class Chunk {
+	public:
+		Sprite* sprite;
+		bool dirty;
+		unsigned last_used; // the frame the chunk was last drawn in
+		bool per_tile; // a static tile covers part of an animated one, so every tile is drawn one by one
+		std::vector<Point> tiles; // tiles drawn after the image, in order: the animated ones, or all of them if per_tile
+		Chunk() : sprite(NULL), dirty(true), last_used(0), per_tile(false) {}
+	};
+
+	class SortByLastUsed {
+	public:
+		bool operator()(const Chunk* a, const Chunk* b) const {
+			return a->last_used < b->last_used;
+		}
+	};
+
+	class Layer {
+	public:
+		bool ready;
+		Rect bounds; // area covered by the chunks, in pixels relative to the map origin
+		int chunks_w;
+		int chunks_h;
+		Point margin; // how far a tile image can reach from its position, in pixels
+		std::vector<Chunk> chunks;
+		Layer() : ready(false), chunks_w(0), chunks_h(0) {}
+	};
+
+	Point getTilePos(int x, int y) const;
+	void getTileRange(const Rect& area, int map_w, int map_h, Point& range_min, Point& range_max) const;
+	void setupLayer(Layer& layer, const Map_Layer& layerdata, const TileSet& tile_set);
+	bool getTileRect(int x, int y, const Map_Layer& layerdata, const TileSet& tile_set, const Rect& area, Rect& rect);
+	void findTiles(const Rect& area, const Point& margin, const Map_Layer& layerdata, const TileSet& tile_set, std::vector<Point>& tiles);
+	bool bake(Chunk& chunk, const Rect& area, const Point& margin, const Map_Layer& layerdata, const TileSet& tile_set);
+	bool bakeTile(Chunk& chunk, const Rect& area, int x, int y, const Map_Layer& layerdata, const TileSet& tile_set);
+	void releaseSprite(Chunk& chunk);
+	void renderTile(int x, int y, const Map_Layer& layerdata, const TileSet& tile_set, const Rect& area, const Point& origin);
+
+	std::vector<Layer> layers;
+	std::vector<Sprite*> free_sprites;
+	bool failed; // creating a chunk image failed once, so don't keep trying
+	unsigned frame;
+};
+
+#endif // LAYER_CHUNK_CACHE_H
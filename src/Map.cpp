@@ -27,6 +27,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "FileParser.h"
 #include "FogOfWar.h"
 #include "Map.h"
+#include "MapCache.h"
 #include "MapSaver.h"
 #include "MapRenderer.h"
 #include "MessageEngine.h"
@@ -249,6 +250,8 @@ int Map::load(const std::string& fname, bool load_procgen_cache) {
 
 	// @CLASS Map|Description of maps/
 	FileParser infile;
+	MapCache map_cache;
+	bool from_map_cache = false;
 	if (load_procgen_cache) {
 		if (!infile.open(procgen_filename, !FileParser::MOD_FILE, FileParser::ERROR_NORMAL)) {
 			// couldn't load cached map, try loading the original
@@ -256,6 +259,10 @@ int Map::load(const std::string& fname, bool load_procgen_cache) {
 				return 0;
 		}
 	}
+	else if (map_cache.load(fname)) {
+		infile.openEntries(fname, &map_cache.entries);
+		from_map_cache = true;
+	}
 	else {
 		if (!infile.open(fname, FileParser::MOD_FILE, FileParser::ERROR_NORMAL))
 			return 0;
@@ -275,8 +282,13 @@ int Map::load(const std::string& fname, bool load_procgen_cache) {
 		}
 		if (infile.section == "header")
 			loadHeader(infile);
-		else if (infile.section == "layer")
-			loadLayer(infile);
+		else if (infile.section == "layer") {
+			// the cache has already parsed the layer data, so there are no raw lines to read
+			if (from_map_cache && infile.key == "data" && !layers.empty())
+				layers.back() = map_cache.layers[layers.size()-1];
+			else
+				loadLayer(infile);
+		}
 		else if (infile.section == "enemy")
 			loadEnemyGroup(infile, &enemy_groups.back());
 		else if (infile.section == "npc")
@@ -338,10 +350,7 @@ int Map::load(const std::string& fname, bool load_procgen_cache) {
 	if (std::find(layernames.begin(), layernames.end(), "collision") == layernames.end()) {
 		layernames.push_back("collision");
 		layers.resize(layers.size()+1);
-		layers.back().resize(w);
-		for (size_t i=0; i<layers.back().size(); ++i) {
-			layers.back()[i].resize(h, 0);
-		}
+		layers.back().resize(w, h, 0);
 	}
 
 	if (fogofwar) {
@@ -375,19 +384,13 @@ int Map::load(const std::string& fname, bool load_procgen_cache) {
 		if (std::find(layernames.begin(), layernames.end(), "fow_fog") == layernames.end()) {
 			layernames.push_back("fow_fog");
 			layers.resize(layers.size()+1);
-			layers.back().resize(w);
-			for (size_t i=0; i<layers.back().size(); ++i) {
-				layers.back()[i].resize(h, FogOfWar::TILE_HIDDEN);
-			}
+			layers.back().resize(w, h, FogOfWar::TILE_HIDDEN);
 		}
 
 		if (std::find(layernames.begin(), layernames.end(), "fow_dark") == layernames.end()) {
 			layernames.push_back("fow_dark");
 			layers.resize(layers.size()+1);
-			layers.back().resize(w);
-			for (size_t i=0; i<layers.back().size(); ++i) {
-				layers.back()[i].resize(h, FogOfWar::TILE_HIDDEN);
-			}
+			layers.back().resize(w, h, FogOfWar::TILE_HIDDEN);
 		}
 	}
 
@@ -542,10 +545,7 @@ bool Map::loadLayer(FileParser &infile, bool exit_on_fail) {
 	if (infile.key == "type") {
 		// @ATTR layer.type|string|Map layer type.
 		layers.resize(layers.size()+1);
-		layers.back().resize(w);
-		for (size_t i=0; i<layers.back().size(); ++i) {
-			layers.back()[i].resize(h);
-		}
+		layers.back().resize(w, h);
 		layernames.push_back(infile.val);
 	}
 	else if (infile.key == "format") {
@@ -1491,9 +1491,9 @@ void Map::copyTileLayer(Map* src, size_t layer_index, size_t src_x, size_t src_y
 		return;
 
 	if (src_w == 0)
-		src_w = src->layers[layer_index].size();
+		src_w = src->layers[layer_index].getWidth();
 	if (src_h == 0)
-		src_h = src->layers[layer_index].size();
+		src_h = src->layers[layer_index].getHeight();
 
 	for (size_t x = src_x; x < src_w; ++x) {
 		if (x + x_offset >= w)
@@ -0,0 +1,362 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "MapCache.h"
+#include "ModManager.h"
+#include "Settings.h"
+#include "SharedResources.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+#include "UtilsParsing.h"
+
+#include <cstdlib>
+#include <cstring>
+
+/**
+ * The cache files are only read on the machine that wrote them, so values are stored in native byte order
+ */
+static const char MAGIC[8] = {'F','L','A','R','E','M','A','P'};
+
+static void writeU16(std::ofstream& outfile, unsigned short value) {
+	outfile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void writeU32(std::ofstream& outfile, uint32_t value) {
+	outfile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void writeU64(std::ofstream& outfile, uint64_t value) {
+	outfile.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+static void writeString(std::ofstream& outfile, const std::string& s) {
+	writeU32(outfile, static_cast<uint32_t>(s.length()));
+	outfile.write(s.data(), s.length());
+}
+
+static bool readU16(std::ifstream& infile, unsigned short& value) {
+	return static_cast<bool>(infile.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+static bool readU32(std::ifstream& infile, uint32_t& value) {
+	return static_cast<bool>(infile.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+static bool readU64(std::ifstream& infile, uint64_t& value) {
+	return static_cast<bool>(infile.read(reinterpret_cast<char*>(&value), sizeof(value)));
+}
+
+/**
+ * Lengths and counts can't be larger than the file itself. Checking this first means a damaged file can't make us
+ * allocate huge amounts of memory
+ */
+static bool readCount(std::ifstream& infile, uint64_t file_size, uint32_t& count) {
+	return readU32(infile, count) && count <= file_size;
+}
+
+static bool readString(std::ifstream& infile, uint64_t file_size, std::string& s) {
+	uint32_t length;
+	if (!readCount(infile, file_size, length))
+		return false;
+
+	s.resize(length);
+	if (length == 0)
+		return true;
+	return static_cast<bool>(infile.read(&s[0], length));
+}
+
+/**
+ * Same result as calling Parse::popFirstInt() for each tile, without copying the rest of the row every time
+ */
+static void parseRow(const std::string& row, unsigned short* tiles, unsigned short w) {
+	const char* pos = row.c_str();
+	for (unsigned short i = 0; i < w; ++i) {
+		tiles[i] = static_cast<unsigned short>(static_cast<int>(strtol(pos, NULL, 10)));
+
+		pos = strpbrk(pos, ",;");
+		if (!pos)
+			break;
+		pos++;
+	}
+}
+
+MapCache::MapCache()
+	: mod_sources(0) {
+}
+
+MapCache::~MapCache() {
+}
+
+void MapCache::clear() {
+	entries.clear();
+	layers.clear();
+	sources.clear();
+	mod_sources = 0;
+}
+
+bool MapCache::load(const std::string& fname) {
+	if (read(fname) && isCurrent(fname))
+		return true;
+
+	return compile(fname);
+}
+
+bool MapCache::compile(const std::string& fname) {
+	if (!parse(fname)) {
+		clear();
+		return false;
+	}
+
+	write(fname);
+	return true;
+}
+
+void MapCache::compileAll() {
+	std::vector<std::string> maps = mods->list("maps", !ModManager::LIST_FULL_PATHS);
+
+	size_t compiled = 0;
+	for (size_t i = 0; i < maps.size(); ++i) {
+		MapCache map_cache;
+		if (map_cache.compile(maps[i])) {
+			compiled++;
+		}
+		else {
+			Utils::logError("MapCache: Could not compile '%s'. Load it in-game to see the errors.", maps[i].c_str());
+		}
+	}
+
+	Utils::logInfo("MapCache: Compiled %u of %u map(s).", static_cast<unsigned>(compiled), static_cast<unsigned>(maps.size()));
+}
+
+/**
+ * Reads the map text file(s) the same way Map::load() does, but only the layer data is interpreted.
+ * Anything Map::loadLayer() would complain about makes this fail, so Map falls back to the text file and
+ * reports the error itself
+ */
+bool MapCache::parse(const std::string& fname) {
+	clear();
+
+	FileParser infile;
+	infile.record(&entries);
+	if (!infile.open(fname, FileParser::MOD_FILE, FileParser::ERROR_NONE))
+		return false;
+
+	unsigned short w = 1;
+	unsigned short h = 1;
+
+	while (infile.next()) {
+		if (infile.section == "header") {
+			if (infile.key == "width")
+				w = static_cast<unsigned short>(std::max(Parse::toInt(infile.val), 1));
+			else if (infile.key == "height")
+				h = static_cast<unsigned short>(std::max(Parse::toInt(infile.val), 1));
+		}
+		else if (infile.section == "layer") {
+			if (infile.key == "type") {
+				layers.push_back(Map_Layer(w, h));
+			}
+			else if (infile.key == "format") {
+				if (infile.val != "dec")
+					return false;
+			}
+			else if (infile.key == "data") {
+				if (layers.empty() || layers.back().getWidth() != w || layers.back().getHeight() != h)
+					return false;
+
+				for (unsigned short j = 0; j < h; ++j) {
+					std::string row = infile.getRawLine();
+					infile.incrementLineNum();
+
+					// verify the width of this row
+					int comma_count = 0;
+					for (size_t i = 0; i < row.length(); ++i) {
+						if (row[i] == ',') comma_count++;
+					}
+					if (!row.empty() && row[row.length()-1] != ',')
+						comma_count++;
+					if (comma_count != w)
+						return false;
+
+					parseRow(row, layers.back().getRow(j), w);
+				}
+			}
+		}
+	}
+
+	const std::vector<std::string>& source_files = infile.getSourceFiles();
+	infile.close();
+
+	// FileParser lists the files it located through the mods first; anything after them came from INCLUDE
+	mod_sources = static_cast<uint32_t>(mods->list(Filesystem::convertSlashes(fname), ModManager::LIST_FULL_PATHS).size());
+	if (mod_sources == 0 || mod_sources > source_files.size())
+		return false;
+
+	sources.resize(source_files.size());
+	for (size_t i = 0; i < source_files.size(); ++i) {
+		sources[i].path = source_files[i];
+		if (!Filesystem::getFileInfo(sources[i].path, sources[i].modified_time, sources[i].size))
+			return false;
+	}
+
+	return !sources.empty();
+}
+
+bool MapCache::read(const std::string& fname) {
+	clear();
+
+	std::ifstream infile(getCacheFilename(fname).c_str(), std::ios::in | std::ios::binary);
+	if (!infile.is_open())
+		return false;
+
+	infile.seekg(0, std::ios::end);
+	const uint64_t file_size = static_cast<uint64_t>(infile.tellg());
+	infile.seekg(0, std::ios::beg);
+
+	char magic[sizeof(MAGIC)];
+	uint32_t version;
+	std::string name;
+	if (!infile.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+		return false;
+	if (!readU32(infile, version) || version != VERSION)
+		return false;
+	if (!readString(infile, file_size, name) || name != fname)
+		return false;
+
+	uint32_t count;
+	if (!readCount(infile, file_size, count) || !readU32(infile, mod_sources) || mod_sources == 0 || mod_sources > count)
+		return false;
+	sources.resize(count);
+	for (size_t i = 0; i < sources.size(); ++i) {
+		if (!readString(infile, file_size, sources[i].path) || !readU64(infile, sources[i].modified_time) || !readU64(infile, sources[i].size))
+			return false;
+	}
+
+	if (!readCount(infile, file_size, count))
+		return false;
+	entries.resize(count);
+	for (size_t i = 0; i < entries.size(); ++i) {
+		FileParser::Entry& entry = entries[i];
+		uint32_t new_section, line_number;
+		if (!readU32(infile, new_section) || !readU32(infile, line_number))
+			return false;
+		if (!readString(infile, file_size, entry.section) || !readString(infile, file_size, entry.key) || !readString(infile, file_size, entry.val))
+			return false;
+		entry.new_section = (new_section != 0);
+		entry.line_number = line_number;
+	}
+
+	if (!readCount(infile, file_size, count))
+		return false;
+	layers.resize(count);
+	for (size_t i = 0; i < layers.size(); ++i) {
+		unsigned short w, h;
+		if (!readU16(infile, w) || !readU16(infile, h))
+			return false;
+
+		const uint64_t data_size = static_cast<uint64_t>(w) * h * sizeof(unsigned short);
+		if (data_size > file_size)
+			return false;
+
+		layers[i].resize(w, h);
+		if (data_size > 0 && !infile.read(reinterpret_cast<char*>(layers[i].getRow(0)), static_cast<std::streamsize>(data_size)))
+			return false;
+	}
+
+	return true;
+}
+
+bool MapCache::write(const std::string& fname) {
+	Filesystem::createDir(settings->path_user + "cache");
+	Filesystem::createDir(settings->path_user + "cache/maps");
+
+	std::string cache_filename = getCacheFilename(fname);
+	std::ofstream outfile(cache_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!outfile.is_open()) {
+		Utils::logError("MapCache: Could not write '%s'.", cache_filename.c_str());
+		return false;
+	}
+
+	outfile.write(MAGIC, sizeof(MAGIC));
+	writeU32(outfile, VERSION);
+	writeString(outfile, fname);
+
+	writeU32(outfile, static_cast<uint32_t>(sources.size()));
+	writeU32(outfile, mod_sources);
+	for (size_t i = 0; i < sources.size(); ++i) {
+		writeString(outfile, sources[i].path);
+		writeU64(outfile, sources[i].modified_time);
+		writeU64(outfile, sources[i].size);
+	}
+
+	writeU32(outfile, static_cast<uint32_t>(entries.size()));
+	for (size_t i = 0; i < entries.size(); ++i) {
+		writeU32(outfile, entries[i].new_section ? 1 : 0);
+		writeU32(outfile, entries[i].line_number);
+		writeString(outfile, entries[i].section);
+		writeString(outfile, entries[i].key);
+		writeString(outfile, entries[i].val);
+	}
+
+	writeU32(outfile, static_cast<uint32_t>(layers.size()));
+	for (size_t i = 0; i < layers.size(); ++i) {
+		const unsigned short w = layers[i].getWidth();
+		const unsigned short h = layers[i].getHeight();
+		writeU16(outfile, w);
+		writeU16(outfile, h);
+		if (!layers[i].empty())
+			outfile.write(reinterpret_cast<const char*>(layers[i].getRow(0)), static_cast<std::streamsize>(w) * h * sizeof(unsigned short));
+	}
+
+	bool success = outfile.good();
+	outfile.close();
+
+	if (!success) {
+		Utils::logError("MapCache: Could not write '%s'.", cache_filename.c_str());
+		Filesystem::removeFile(cache_filename);
+	}
+	return success;
+}
+
+/**
+ * The cache is current if the mods still locate exactly the same map files, and none of the files it was made
+ * from (including INCLUDE files) were changed since. Only the first 'mod_sources' entries are compared to the
+ * mod lookup, so a mod that was disabled can't hide behind the INCLUDE entries that follow them.
+ */
+bool MapCache::isCurrent(const std::string& fname) {
+	std::vector<std::string> located = mods->list(Filesystem::convertSlashes(fname), ModManager::LIST_FULL_PATHS);
+	if (located.empty() || located.size() != mod_sources)
+		return false;
+
+	for (size_t i = 0; i < located.size(); ++i) {
+		if (located[i] != sources[i].path)
+			return false;
+	}
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		uint64_t modified_time, size;
+		if (!Filesystem::getFileInfo(sources[i].path, modified_time, size))
+			return false;
+		if (modified_time != sources[i].modified_time || size != sources[i].size)
+			return false;
+	}
+
+	return true;
+}
+
+std::string MapCache::getCacheFilename(const std::string& fname) {
+	std::stringstream ss;
+	ss << settings->path_user << "cache/maps/" << Utils::hashString(fname) << ".dat";
+	return Filesystem::convertSlashes(ss.str());
+}
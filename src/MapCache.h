@@ -0,0 +1,76 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapCache
+ *
+ * A binary copy of a map's text file(s), stored in PATH_USER/cache/maps/.
+ *
+ * Layer data is kept as raw tile arrays. Every other key pair (header, enemy groups, NPCs, events) is kept in the
+ * order it was read, so Map can pass it through its usual loaders with FileParser::openEntries(). Those loaders
+ * look up statuses, powers, items and translations, which can change between runs, so they are not cached.
+ *
+ * The cache remembers the path, modification time and size of every file the map was read from. If any of them
+ * changed, or the mod list now locates a different set of files (more, fewer or other ones), the map is compiled again.
+ */
+
+#ifndef MAP_CACHE_H
+#define MAP_CACHE_H
+
+#include "CommonIncludes.h"
+#include "FileParser.h"
+#include "MapLayer.h"
+
+class MapCache {
+public:
+	// increase this whenever the file format or the way entries are recorded changes
+	static const unsigned VERSION = 2;
+
+	MapCache();
+	~MapCache();
+
+	// loads the cache of a map, compiling it first if it's missing or out of date
+	bool load(const std::string& fname);
+
+	// parses the text file(s) of a map and writes the cache
+	bool compile(const std::string& fname);
+
+	// compiles every map in maps/ of the enabled mods
+	static void compileAll();
+
+	std::vector<FileParser::Entry> entries;
+	std::vector<Map_Layer> layers; // one for each 'type' key in a [layer] section
+
+private:
+	class Source {
+	public:
+		std::string path;
+		uint64_t modified_time;
+		uint64_t size;
+		Source() : modified_time(0), size(0) {}
+	};
+
+	void clear();
+	bool parse(const std::string& fname);
+	bool read(const std::string& fname);
+	bool write(const std::string& fname);
+	bool isCurrent(const std::string& fname);
+	std::string getCacheFilename(const std::string& fname);
+
+	std::vector<Source> sources; // the files located by the mods come first, followed by INCLUDE files
+	uint32_t mod_sources; // how many of 'sources' were located by the mods
+};
+
+#endif // MAP_CACHE_H
@@ -30,8 +30,6 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #define NDEBUG
 #endif
 
-#include "AStarContainer.h"
-#include "AStarNode.h"
 #include "EngineSettings.h"
 #include "MapCollision.h"
 #include "SharedResources.h"
@@ -49,28 +47,45 @@ MapCollision::MapCollision()
 	: has_empty_tile(false)
 	, raycast_resolution(eset->misc.raycast_resolution)
 	, raycast_resolution_recip(1.f / eset->misc.raycast_resolution)
+	, astar_hierarchy(this)
+	, tile_version(0)
+	, sight_cache(SIGHT_CACHE_SIZE)
 	, map_size(Point())
 {
-	colmap.resize(1);
-	colmap[0].resize(1);
+	colmap.resize(1, 1);
 }
 
 void MapCollision::setMap(const Map_Layer& _colmap, unsigned short w, unsigned short h) {
 	has_empty_tile = false;
 
-	colmap.resize(w);
-	for (unsigned i=0; i<w; ++i) {
-		colmap[i].resize(h);
-	}
-	for (unsigned i=0; i<w; i++)
-		for (unsigned j=0; j<h; j++) {
-			colmap[i][j] = _colmap[i][j];
-			if (colmap[i][j] == 0)
+	colmap.resize(w, h);
+	for (unsigned j=0; j<h; j++) {
+		const unsigned short* src_row = _colmap.getRow(j);
+		unsigned short* row = colmap.getRow(j);
+		for (unsigned i=0; i<w; i++) {
+			row[i] = src_row[i];
+			if (row[i] == 0)
 				has_empty_tile = true;
 		}
+	}
 
 	map_size.x = w;
 	map_size.y = h;
+
+	tile_version++;
+	astar_hierarchy.build();
+}
+
+/**
+ * Changes a collision tile, keeping the pathfinding cluster graph up to date
+ */
+void MapCollision::setTile(int tile_x, int tile_y, unsigned short tile) {
+	if (isTileOutsideMap(tile_x, tile_y))
+		return;
+
+	colmap[tile_x][tile_y] = tile;
+	tile_version++;
+	astar_hierarchy.invalidate(tile_x, tile_y);
 }
 
 int sgn(float f) {
@@ -275,6 +290,24 @@ bool MapCollision::isValidPosition(const float& x, const float& y, int movement_
 	return isValidTile(int(x), int(y), movement_type, collide_type);
 }
 
+/**
+ * Same as isValidTile(), except that tiles which are only blocked by entities are valid
+ * Used for precomputed pathfinding data, which shouldn't change whenever an entity moves
+ */
+bool MapCollision::isValidTileStatic(int tile_x, int tile_y, int movement_type) const {
+	if (isTileOutsideMap(tile_x, tile_y)) return false;
+
+	if (movement_type == MOVE_INTANGIBLE)
+		return true;
+
+	const unsigned short tile = colmap[tile_x][tile_y];
+
+	if (movement_type == MOVE_FLYING)
+		return !(tile == BLOCKS_ALL || tile == BLOCKS_ALL_HIDDEN);
+
+	return tile == BLOCKS_NONE || tile == MAP_ONLY || tile == MAP_ONLY_ALT || tile == BLOCKS_ENTITIES || tile == BLOCKS_ENEMIES;
+}
+
 /**
  * Does not have the "slide" submovement that move() features
  * Line can be arbitrary angles.
@@ -325,8 +358,95 @@ bool MapCollision::lineCheck(const float& x1, const float& y1, const float& x2,
 	return true;
 }
 
+/**
+ * Walks the tiles crossed by a line from the center of the start tile to the center of the end tile
+ * Both ends are included. When the line passes exactly through a corner, it steps diagonally
+ */
+bool MapCollision::tileLineOfSight(const Point& start, const Point& end) const {
+	const int nx = abs(end.x - start.x);
+	const int ny = abs(end.y - start.y);
+	const int sx = (end.x > start.x) ? 1 : -1;
+	const int sy = (end.y > start.y) ? 1 : -1;
+
+	Point p = start;
+	if (isWall(static_cast<float>(p.x), static_cast<float>(p.y)))
+		return false;
+
+	int ix = 0;
+	int iy = 0;
+	while (ix < nx || iy < ny) {
+		// compare where the line crosses the next vertical and horizontal tile edges
+		int64_t decision = static_cast<int64_t>(1 + 2 * ix) * ny - static_cast<int64_t>(1 + 2 * iy) * nx;
+		if (decision == 0) {
+			p.x += sx;
+			p.y += sy;
+			ix++;
+			iy++;
+		}
+		else if (decision < 0) {
+			p.x += sx;
+			ix++;
+		}
+		else {
+			p.y += sy;
+			iy++;
+		}
+
+		if (isWall(static_cast<float>(p.x), static_cast<float>(p.y)))
+			return false;
+	}
+
+	return true;
+}
+
+/**
+ * Sight is checked between tiles, not exact positions, so results can be cached per pair of tiles
+ * Only walls block sight, so the cache stays valid until the static collision changes
+ */
 bool MapCollision::lineOfSight(const float& x1, const float& y1, const float& x2, const float& y2) {
-	return lineCheck(x1, y1, x2, y2, CHECK_SIGHT, MOVE_NORMAL);
+	Point start(static_cast<int>(floorf(x1)), static_cast<int>(floorf(y1)));
+	Point end(static_cast<int>(floorf(x2)), static_cast<int>(floorf(y2)));
+
+	if (isTileOutsideMap(start.x, start.y) || isTileOutsideMap(end.x, end.y))
+		return false;
+
+	uint64_t key;
+	SightCacheEntry& entry = sight_cache[getSightCacheIndex(start, end, key)];
+	if (entry.valid && entry.key == key && entry.tile_version == tile_version)
+		return entry.visible;
+
+	entry.valid = true;
+	entry.key = key;
+	entry.tile_version = tile_version;
+	entry.visible = tileLineOfSight(start, end);
+
+	return entry.visible;
+}
+
+/**
+ * Uses cached results, but doesn't add new ones
+ */
+bool MapCollision::lineOfSightReadOnly(const float& x1, const float& y1, const float& x2, const float& y2) const {
+	Point start(static_cast<int>(floorf(x1)), static_cast<int>(floorf(y1)));
+	Point end(static_cast<int>(floorf(x2)), static_cast<int>(floorf(y2)));
+
+	if (isTileOutsideMap(start.x, start.y) || isTileOutsideMap(end.x, end.y))
+		return false;
+
+	uint64_t key;
+	const SightCacheEntry& entry = sight_cache[getSightCacheIndex(start, end, key)];
+	if (entry.valid && entry.key == key && entry.tile_version == tile_version)
+		return entry.visible;
+
+	return tileLineOfSight(start, end);
+}
+
+size_t MapCollision::getSightCacheIndex(const Point& start, const Point& end, uint64_t& key) const {
+	const uint64_t start_index = static_cast<uint64_t>(start.y) * map_size.x + start.x;
+	const uint64_t end_index = static_cast<uint64_t>(end.y) * map_size.x + end.x;
+	key = (start_index << 32) | end_index;
+
+	return static_cast<size_t>((start_index * 2654435761u) ^ (end_index * 40503u)) & (SIGHT_CACHE_SIZE - 1);
 }
 
 bool MapCollision::lineOfMovement(const float& x1, const float& y1, const float& x2, const float& y2, int movement_type) {
@@ -410,77 +530,96 @@ bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, s
 		unblock(end_pos.x, end_pos.y);
 	}
 
+	bool use_hierarchy = astar_hierarchy.isEnabled() && Utils::calcDist(FPoint(start), FPoint(end)) > static_cast<float>(AStarHierarchy::CLUSTER_SIZE);
+
+	// long paths are planned on the cluster graph, everything else (and any failure to do so) uses a regular search
+	if (!use_hierarchy || !computeHierarchicalPath(start, end, path, movement_type, limit)) {
+		computeLocalPath(start, end, path, movement_type, limit, NULL);
+	}
+
+	// reblock target if needed
+	if (target_blocks) block(end_pos.x, end_pos.y, target_blocks_type == BLOCKS_ENEMIES);
+
+	return !path.empty();
+}
+
+/**
+ * Regular A* search from start to end, optionally restricted to the tiles within bounds
+ * Waypoints are stored in path, from end to start
+ * @return true if the end was reached, false if path leads to the closest node found instead
+ */
+bool MapCollision::computeLocalPath(const Point& start, const Point& end, std::vector<FPoint> &path, int movement_type, unsigned int limit, const Rect* bounds) {
 	Point current = start;
-	AStarNode* node = new AStarNode(start);
-	node->setActualCost(0);
-	node->setEstimatedCost(Utils::calcDist(FPoint(start),FPoint(end)));
-	node->setParent(current);
+	Point neighbours[AStarNode::MAX_NEIGHBOURS];
 
-	AStarContainer open(map_size.x, map_size.y, limit);
-	AStarCloseContainer close(map_size.x, map_size.y, limit);
+	astar.reset(map_size.x, map_size.y, limit);
+	astar.addOpen(start, current, 0, Utils::calcDist(FPoint(start),FPoint(end)));
 
-	open.add(node);
+	AStarNode* node = NULL;
 
-	while (!open.isEmpty() && static_cast<unsigned>(close.getSize()) < limit) {
-		node = open.get_shortest_f();
+	while (!astar.isOpenEmpty() && static_cast<unsigned>(astar.getCloseSize()) < limit) {
+		node = astar.getShortestF();
 
 		current.x = node->getX();
 		current.y = node->getY();
-		close.add(node);
-		open.remove(node);
+		astar.close(node);
 
 		if ( current.x == end.x && current.y == end.y)
 			break; //path found !
 
 		//limit evaluated nodes to the size of the map
-		std::list<Point> neighbours = node->getNeighbours(map_size.x, map_size.y);
+		int neighbour_count = node->getNeighbours(neighbours, map_size.x, map_size.y);
 
 		// for every neighbour of current node
-		for (std::list<Point>::iterator it=neighbours.begin(); it != neighbours.end(); ++it)	{
-			Point neighbour = *it;
+		for (int j = 0; j < neighbour_count; ++j) {
+			const Point& neighbour = neighbours[j];
 
 			// do not exceed the node limit when adding nodes
-			if (static_cast<unsigned>(open.getSize()) >= limit) {
+			if (static_cast<unsigned>(astar.getOpenSize()) >= limit) {
 				break;
 			}
 
+			// if a search area is given, don't leave it
+			if (bounds && !Utils::isWithinRect(*bounds, neighbour))
+				continue;
+
 			// if neighbour is not free of any collision, skip it
 			if (!isValidTile(neighbour.x,neighbour.y,movement_type, MapCollision::COLLIDE_TYPE_ALL_ENTITIES))
 				continue;
 			// if nabour is already in close, skip it
-			if(close.exists(neighbour))
+			if(astar.isClosed(neighbour))
 				continue;
 
+			float actual_cost = node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour));
+
 			// if neighbour isn't inside open, add it as a new Node
-			if(!open.exists(neighbour)) {
-				AStarNode* newNode = new AStarNode(neighbour);
-				newNode->setActualCost(node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour)));
-				newNode->setParent(current);
-				newNode->setEstimatedCost(Utils::calcDist(FPoint(neighbour),FPoint(end)));
-				open.add(newNode);
+			if(!astar.isOpen(neighbour)) {
+				astar.addOpen(neighbour, current, actual_cost, Utils::calcDist(FPoint(neighbour),FPoint(end)));
 			}
 			// else, update it's cost if better
 			else {
-				AStarNode* i = open.get(neighbour.x, neighbour.y);
-				if (node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour)) < i->getActualCost()) {
-					Point pos(i->getX(), i->getY());
-					Point parent_pos(node->getX(), node->getY());
-					open.updateParent(pos, parent_pos, node->getActualCost() + Utils::calcDist(FPoint(current),FPoint(neighbour)));
+				AStarNode* i = astar.get(neighbour.x, neighbour.y);
+				if (actual_cost < i->getActualCost()) {
+					astar.updateParent(neighbour, current, actual_cost);
 				}
 			}
 		}
 	}
 
-	if (!(current.x == end.x && current.y == end.y)) {
+	bool found = (current.x == end.x && current.y == end.y);
 
-		//couldnt find the target so map a path to the closest node found
-		node = close.get_shortest_h();
-		current.x = node->getX();
-		current.y = node->getY();
+	if (!found) {
 
-		while (!(current.x == start.x && current.y == start.y)) {
-			path.push_back(collisionToMap(current));
-			current = close.get(current.x, current.y)->getParent();
+		//couldnt find the target so map a path to the closest node found
+		node = astar.getShortestH();
+		if (node) {
+			current.x = node->getX();
+			current.y = node->getY();
+
+			while (!(current.x == start.x && current.y == start.y)) {
+				path.push_back(collisionToMap(current));
+				current = astar.get(current.x, current.y)->getParent();
+			}
 		}
 	}
 	else {
@@ -488,13 +627,59 @@ bool MapCollision::computePath(const FPoint& start_pos, const FPoint& end_pos, s
 		path.push_back(collisionToMap(end));
 		while (!(current.x == start.x && current.y == start.y)) {
 			path.push_back(collisionToMap(current));
-			current = close.get(current.x, current.y)->getParent();
+			current = astar.get(current.x, current.y)->getParent();
 		}
 	}
-	// reblock target if needed
-	if (target_blocks) block(end_pos.x, end_pos.y, target_blocks_type == BLOCKS_ENEMIES);
 
-	return !path.empty();
+	return found;
+}
+
+/**
+ * Plans a path on the cluster graph and then refines each leg of it with a search that is restricted to a single cluster
+ * Waypoints are stored in path, from end to start
+ * @return false if the cluster graph has no route, in which case path is left empty
+ */
+bool MapCollision::computeHierarchicalPath(const Point& start, const Point& end, std::vector<FPoint> &path, int movement_type, unsigned int limit) {
+	std::vector<Point> waypoints;
+	if (!astar_hierarchy.findPath(start, end, movement_type, limit, waypoints))
+		return false;
+
+	// the full route, from start (excluded) to end
+	std::vector<Point> route;
+	std::vector<FPoint> segment;
+	const unsigned int segment_limit = AStarHierarchy::CLUSTER_SIZE * AStarHierarchy::CLUSTER_SIZE;
+
+	for (size_t i = 1; i < waypoints.size(); ++i) {
+		Rect bounds = astar_hierarchy.getClusterRect(waypoints[i-1]);
+
+		// waypoints in different clusters are always adjacent to each other
+		if (!Utils::isWithinRect(bounds, waypoints[i])) {
+			route.push_back(waypoints[i]);
+			continue;
+		}
+
+		segment.clear();
+		bool reached = computeLocalPath(waypoints[i-1], waypoints[i], segment, movement_type, segment_limit, &bounds);
+
+		for (size_t j = segment.size(); j > 0; --j) {
+			Point p(segment[j-1]);
+			if (route.empty() || !(route.back() == p))
+				route.push_back(p);
+		}
+
+		// something (probably an entity) is in the way; stop at the closest node we could find
+		if (!reached)
+			break;
+	}
+
+	if (route.empty())
+		return false;
+
+	for (size_t i = route.size(); i > 0; --i) {
+		path.push_back(collisionToMap(route[i-1]));
+	}
+
+	return true;
 }
 
 void MapCollision::block(const float& map_x, const float& map_y, bool is_ally) {
@@ -26,11 +26,12 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef MAP_COLLISION_H
 #define MAP_COLLISION_H
 
+#include "AStarContainer.h"
+#include "AStarHierarchy.h"
 #include "CommonIncludes.h"
+#include "MapLayer.h"
 #include "Utils.h"
 
-typedef std::vector< std::vector<unsigned short> > Map_Layer;
-
 class MapCollision {
 private:
 	static const float MIN_TILE_GAP;
@@ -44,6 +45,7 @@ private:
 	bool isTileOutsideMap(const int& tile_x, const int& tile_y) const;
 
 	bool lineCheck(const float& x1, const float& y1, const float& x2, const float& y2, int check_type, int movement_type);
+	bool tileLineOfSight(const Point& start, const Point& end) const;
 
 	bool smallStepForcedSlideAlongGrid(
 		float &x, float &y, float step_x, float step_y, int movement_type, int collide_type);
@@ -61,6 +63,34 @@ private:
 	float raycast_resolution;
 	float raycast_resolution_recip;
 
+	bool computeLocalPath(const Point& start, const Point& end, std::vector<FPoint> &path, int movement_type, unsigned int limit, const Rect* bounds);
+	bool computeHierarchicalPath(const Point& start, const Point& end, std::vector<FPoint> &path, int movement_type, unsigned int limit);
+
+	// reused by computePath() so that searching for a path doesn't allocate memory
+	AStarContainer astar;
+
+	// cluster graph for long paths
+	AStarHierarchy astar_hierarchy;
+
+	// incremented every time the static collision changes (see setMap() and setTile())
+	unsigned int tile_version;
+
+	// results of recent lineOfSight() checks, keyed on the start and end tiles
+	// entries from before the last change to the static collision are ignored
+	class SightCacheEntry {
+	public:
+		bool valid;
+		bool visible;
+		unsigned int tile_version;
+		uint64_t key;
+		SightCacheEntry() : valid(false), visible(false), tile_version(0), key(0) {}
+	};
+
+	static const int SIGHT_CACHE_SIZE = 4096; // must be a power of 2
+	std::vector<SightCacheEntry> sight_cache;
+
+	size_t getSightCacheIndex(const Point& start, const Point& end, uint64_t& key) const;
+
 public:
 	// const flags
 	static const bool IS_ALLY = true;
@@ -100,14 +130,19 @@ public:
 	~MapCollision();
 
 	void setMap(const Map_Layer& _colmap, unsigned short w, unsigned short h);
+	void setTile(int tile_x, int tile_y, unsigned short tile);
 	bool move(float &x, float &y, float step_x, float step_y, int movement_type, int collide_type);
 
 	bool isOutsideMap(const float& tile_x, const float& tile_y) const;
 	bool isWall(const float& x, const float& y) const;
 
 	bool isValidPosition(const float& x, const float& y, int movement_type, int collide_type) const;
+	bool isValidTileStatic(int tile_x, int tile_y, int movement_type) const;
 
 	bool lineOfSight(const float& x1, const float& y1, const float& x2, const float& y2);
+
+	// same result as lineOfSight(). Safe to call from several threads while the collision map isn't being changed
+	bool lineOfSightReadOnly(const float& x1, const float& y1, const float& x2, const float& y2) const;
 	bool lineOfMovement(const float& x1, const float& y1, const float& x2, const float& y2, int movement_type);
 
 	bool isFacing(const float& x1, const float& y1, char direction, const float& x2, const float& y2);
@@ -124,6 +159,7 @@ public:
 	}
 
 	bool hasEmptyTile() { return has_empty_tile; }
+	unsigned int getTileVersion() const { return tile_version; }
 
 	Map_Layer colmap;
 	Point map_size;
@@ -0,0 +1,116 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "EventManager.h"
+#include "MapEventIndex.h"
+
+#include <functional>
+
+MapEventIndex::MapEventIndex()
+	: dirty(true)
+	, event_count(0)
+	, cells_w(0)
+	, cells_h(0)
+{
+}
+
+MapEventIndex::~MapEventIndex() {
+}
+
+void MapEventIndex::clear() {
+	dirty = true;
+}
+
+void MapEventIndex::update(const std::vector<Event>& events, int map_w, int map_h) {
+	if (!dirty && event_count == events.size())
+		return;
+
+	dirty = false;
+	event_count = events.size();
+
+	cells_w = std::max((map_w + CELL_SIZE - 1) / CELL_SIZE, 1);
+	cells_h = std::max((map_h + CELL_SIZE - 1) / CELL_SIZE, 1);
+	cells.assign(static_cast<size_t>(cells_w * cells_h), std::vector<size_t>());
+	global_events.clear();
+	npc_events.clear();
+
+	for (size_t i = 0; i < events.size(); ++i) {
+		const Event& ev = events[i];
+
+		if (ev.activate_type == Event::ACTIVATE_STATIC || ev.activate_type == Event::ACTIVATE_ON_CLEAR || ev.activate_type == Event::ACTIVATE_ON_LEAVE)
+			global_events.push_back(i);
+
+		bool is_npc = false;
+		for (size_t j = 0; j < ev.components.size(); ++j) {
+			if (ev.components[j].type == EventComponent::NPC_HOTSPOT) {
+				is_npc = true;
+				break;
+			}
+		}
+
+		if (is_npc && ev.hotspot.h != 0)
+			npc_events.push_back(i);
+
+		if (ev.location.w > 0 && ev.location.h > 0)
+			addToCells(i, ev.location);
+		if (!is_npc && ev.hotspot.w > 0 && ev.hotspot.h > 0)
+			addToCells(i, ev.hotspot);
+		if (ev.center.x >= 0 && ev.center.y >= 0)
+			addToCells(i, Rect(static_cast<int>(ev.center.x), static_cast<int>(ev.center.y), 1, 1));
+	}
+}
+
+void MapEventIndex::addToCells(size_t event_index, const Rect& bounds) {
+	const int x0 = std::max(bounds.x / CELL_SIZE, 0);
+	const int y0 = std::max(bounds.y / CELL_SIZE, 0);
+	const int x1 = std::min((bounds.x + bounds.w - 1) / CELL_SIZE, cells_w - 1);
+	const int y1 = std::min((bounds.y + bounds.h - 1) / CELL_SIZE, cells_h - 1);
+
+	for (int y = y0; y <= y1; ++y) {
+		for (int x = x0; x <= x1; ++x) {
+			std::vector<size_t>& cell = cells[y * cells_w + x];
+			// the location, hotspot and center of an event often share a cell
+			if (cell.empty() || cell.back() != event_index)
+				cell.push_back(event_index);
+		}
+	}
+}
+
+void MapEventIndex::query(const Rect& area, int flags, std::vector<size_t>& result) const {
+	result.clear();
+
+	if (flags & QUERY_GLOBAL)
+		result.insert(result.end(), global_events.begin(), global_events.end());
+	if (flags & QUERY_NPC)
+		result.insert(result.end(), npc_events.begin(), npc_events.end());
+
+	if (area.w > 0 && area.h > 0 && !cells.empty()) {
+		const int x0 = std::max(area.x / CELL_SIZE, 0);
+		const int y0 = std::max(area.y / CELL_SIZE, 0);
+		const int x1 = std::min((area.x + area.w - 1) / CELL_SIZE, cells_w - 1);
+		const int y1 = std::min((area.y + area.h - 1) / CELL_SIZE, cells_h - 1);
+
+		for (int y = y0; y <= y1; ++y) {
+			for (int x = x0; x <= x1; ++x) {
+				const std::vector<size_t>& cell = cells[y * cells_w + x];
+				result.insert(result.end(), cell.begin(), cell.end());
+			}
+		}
+	}
+
+	// events are checked from last to first, as they were before the index existed
+	std::sort(result.begin(), result.end(), std::greater<size_t>());
+	result.erase(std::unique(result.begin(), result.end()), result.end());
+}
@@ -0,0 +1,72 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class MapEventIndex
+ *
+ * Sorts the events of a map into square cells of tiles, so that MapRenderer only has to look at the events near
+ * the hero or the mouse cursor instead of every event on the map.
+ *
+ * An event is put in every cell touched by its location, its hotspot and its center. Events that don't depend on
+ * where the hero is (static, on_clear and on_leave) and NPC hotspots (which are picked by the NPC's sprite) are
+ * kept in separate lists.
+ *
+ * The index stores positions in the event list. It is rebuilt when the number of events changes, or after clear().
+ */
+
+#ifndef MAP_EVENT_INDEX_H
+#define MAP_EVENT_INDEX_H
+
+#include "CommonIncludes.h"
+#include "Utils.h"
+
+class Event;
+
+class MapEventIndex {
+public:
+	// width and height of a cell, in tiles
+	static const int CELL_SIZE = 8;
+
+	enum {
+		QUERY_AREA = 0,
+		QUERY_GLOBAL = 1, // also return static, on_clear and on_leave events
+		QUERY_NPC = 2 // also return NPC hotspots
+	};
+
+	MapEventIndex();
+	~MapEventIndex();
+
+	// forces a rebuild on the next update() (e.g. when events were erased or a new map was loaded)
+	void clear();
+
+	void update(const std::vector<Event>& events, int map_w, int map_h);
+
+	// puts the indexes of the events that may be in area (in tiles) into result, sorted from last to first
+	void query(const Rect& area, int flags, std::vector<size_t>& result) const;
+
+private:
+	void addToCells(size_t event_index, const Rect& bounds);
+
+	bool dirty;
+	size_t event_count;
+	int cells_w;
+	int cells_h;
+
+	std::vector<std::vector<size_t> > cells;
+	std::vector<size_t> global_events;
+	std::vector<size_t> npc_events;
+};
+
+#endif // MAP_EVENT_INDEX_H
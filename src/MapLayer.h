@@ -0,0 +1,117 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Map_Layer
+ *
+ * A 2D grid of tile ids, stored in a single contiguous row-major array.
+ *
+ * Tiles are accessed as layer[x][y], like the nested vectors this replaces. That form does no bounds checking;
+ * use get() and set() when the position might be outside the layer.
+ */
+
+#ifndef MAP_LAYER_H
+#define MAP_LAYER_H
+
+#include <algorithm>
+#include <vector>
+
+class Map_Layer {
+public:
+	class Column {
+	public:
+		Column(unsigned short* _data, size_t _stride) : data(_data), stride(_stride) {}
+		unsigned short& operator[](size_t y) const { return data[y * stride]; }
+	private:
+		unsigned short* data;
+		size_t stride;
+	};
+
+	class ConstColumn {
+	public:
+		ConstColumn(const unsigned short* _data, size_t _stride) : data(_data), stride(_stride) {}
+		const unsigned short& operator[](size_t y) const { return data[y * stride]; }
+	private:
+		const unsigned short* data;
+		size_t stride;
+	};
+
+	Map_Layer()
+		: w(0)
+		, h(0)
+	{}
+
+	Map_Layer(unsigned short _w, unsigned short _h, unsigned short value = 0)
+		: w(_w)
+		, h(_h)
+		, tiles(static_cast<size_t>(_w) * _h, value)
+	{}
+
+	/**
+	 * Tiles that are inside both the old and new size keep their value. New tiles are set to value
+	 */
+	void resize(unsigned short _w, unsigned short _h, unsigned short value = 0) {
+		std::vector<unsigned short> new_tiles(static_cast<size_t>(_w) * _h, value);
+		for (unsigned short y = 0; y < h && y < _h; ++y) {
+			for (unsigned short x = 0; x < w && x < _w; ++x) {
+				new_tiles[static_cast<size_t>(y) * _w + x] = tiles[static_cast<size_t>(y) * w + x];
+			}
+		}
+		tiles.swap(new_tiles);
+		w = _w;
+		h = _h;
+	}
+
+	void fill(unsigned short value) {
+		std::fill(tiles.begin(), tiles.end(), value);
+	}
+
+	unsigned short getWidth() const { return w; }
+	unsigned short getHeight() const { return h; }
+	bool empty() const { return tiles.empty(); }
+
+	bool isValid(int x, int y) const {
+		return x >= 0 && y >= 0 && x < w && y < h;
+	}
+
+	// bounds-checked read. Positions outside the layer are empty (0)
+	unsigned short get(int x, int y) const {
+		return isValid(x, y) ? tiles[static_cast<size_t>(y) * w + x] : 0;
+	}
+
+	// bounds-checked write. Positions outside the layer are ignored
+	void set(int x, int y, unsigned short value) {
+		if (isValid(x, y))
+			tiles[static_cast<size_t>(y) * w + x] = value;
+	}
+
+	// direct access to a whole row of tiles, for loops that walk along x
+	unsigned short* getRow(int y) { return data(static_cast<size_t>(y) * w); }
+	const unsigned short* getRow(int y) const { return data(static_cast<size_t>(y) * w); }
+
+	Column operator[](size_t x) { return Column(data(x), w); }
+	ConstColumn operator[](size_t x) const { return ConstColumn(data(x), w); }
+
+private:
+	// indexing an empty vector is undefined even if the element is never read, so an empty layer gives NULL
+	unsigned short* data(size_t offset) { return tiles.empty() ? NULL : &tiles[0] + offset; }
+	const unsigned short* data(size_t offset) const { return tiles.empty() ? NULL : &tiles[0] + offset; }
+
+	unsigned short w;
+	unsigned short h;
+	std::vector<unsigned short> tiles;
+};
+
+#endif // MAP_LAYER_H
@@ -43,6 +43,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
@@ -65,6 +66,10 @@ MapRenderer::MapRenderer()
 	, tip_pos()
 	, show_tooltip(false)
 	, drawn_hero(false)
+	, fow_hidden_reach(0)
+	, renderables_submitted(0)
+	, renderables_culled(0)
+	, has_removed_events(false)
 	, cam()
 	, map_change(false)
 	, teleportation(false)
@@ -194,16 +199,20 @@ int MapRenderer::load(const std::string& fname) {
 
 	Map::load(fname);
 
+	event_index.clear();
+	has_removed_events = false;
+	camp->notifyChange(CampaignManager::CHANGE_TILES);
+
 	loadMusic();
 
 	for (unsigned i = 0; i < layers.size(); ++i) {
 		if (layernames[i] == "collision") {
-			short width = static_cast<short>(layers[i].size());
+			short width = static_cast<short>(layers[i].getWidth());
 			if (width == 0) {
 				Utils::logError("MapRenderer: Map width is 0. Can't set collision layer.");
 				break;
 			}
-			short height = static_cast<short>(layers[i][0].size());
+			short height = static_cast<short>(layers[i].getHeight());
 			collider.setMap(layers[i], width, height);
 			removeLayer(i);
 		}
@@ -228,8 +237,8 @@ int MapRenderer::load(const std::string& fname) {
 
 	std::vector<unsigned> corrupted;
 	for (unsigned i = 0; i < layers.size(); ++i) {
-		for (unsigned x = 0; x < layers[i].size(); ++x) {
-			for (unsigned y = 0; y < layers[i][x].size(); ++y) {
+		for (unsigned y = 0; y < layers[i].getHeight(); ++y) {
+			for (unsigned x = 0; x < layers[i].getWidth(); ++x) {
 				const unsigned tile_id = layers[i][x][y];
 				TileSet* tile_set = &tset;
 
@@ -263,6 +272,11 @@ int MapRenderer::load(const std::string& fname) {
 
 	render_device->setBackgroundColor(background_color);
 
+	fow_hidden_tiles.clear();
+	fow_hidden_reach = 0;
+
+	layer_cache.clear();
+
 	return 0;
 }
 
@@ -353,9 +367,85 @@ void calculatePriosOrtho(std::vector<Renderable> &r) {
 	}
 }
 
+void MapRenderer::calculatePrios(std::vector<Renderable> &r) {
+	if (eset->tileset.orientation == eset->tileset.TILESET_ORTHOGONAL)
+		calculatePriosOrtho(r);
+	else
+		calculatePriosIso(r);
+}
+
+/**
+ * Stable LSD radix sort on the prio of each renderable, 8 bits per pass.
+ * Prios only use a few bit ranges (see calculatePriosIso()), so passes where every key has the same digit are skipped.
+ * The keys are sorted first and the renderables are only moved once at the end
+ */
+void MapRenderer::sortRenderables(std::vector<Renderable> &r) {
+	const size_t count = r.size();
+
+	// not worth the setup for short lists
+	if (count < 64) {
+		std::stable_sort(r.begin(), r.end(), priocompare);
+		return;
+	}
+
+	static const int PASSES = 8;
+	unsigned histograms[PASSES][256] = {{0}};
+
+	sort_keys.resize(count);
+	sort_keys_temp.resize(count);
+
+	for (size_t i = 0; i < count; ++i) {
+		const uint64_t key = r[i].prio;
+		sort_keys[i] = std::pair<uint64_t, unsigned>(key, static_cast<unsigned>(i));
+		for (int pass = 0; pass < PASSES; ++pass) {
+			histograms[pass][(key >> (pass * 8)) & 0xff]++;
+		}
+	}
+
+	bool sorted = false;
+	for (int pass = 0; pass < PASSES; ++pass) {
+		unsigned* histogram = histograms[pass];
+		const int shift = pass * 8;
+
+		if (histogram[(sort_keys[0].first >> shift) & 0xff] == count)
+			continue;
+
+		// turn the counts into the first index of each bucket
+		unsigned offset = 0;
+		for (int i = 0; i < 256; ++i) {
+			const unsigned bucket_count = histogram[i];
+			histogram[i] = offset;
+			offset += bucket_count;
+		}
+
+		for (size_t i = 0; i < count; ++i) {
+			sort_keys_temp[histogram[(sort_keys[i].first >> shift) & 0xff]++] = sort_keys[i];
+		}
+		sort_keys.swap(sort_keys_temp);
+		sorted = true;
+	}
+
+	if (!sorted)
+		return;
+
+	sort_buffer.clear();
+	sort_buffer.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		sort_buffer.push_back(r[sort_keys[i].second]);
+	}
+	r.swap(sort_buffer);
+}
+
 void MapRenderer::render(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
+	PROFILE_SCOPE("MapRenderer::render");
+
 	drawn_hero = false;
 
+	renderables_submitted = 0;
+	renderables_culled = 0;
+	cullRenderables(r);
+	cullRenderables(r_dead);
+
 	map_parallax.render(cam.shake, "");
 
 	hero_bounds = Rect();
@@ -381,20 +471,40 @@ void MapRenderer::render(std::vector<Renderable> &r, std::vector<Renderable> &r_
 		}
 	}
 
-	if (eset->tileset.orientation == eset->tileset.TILESET_ORTHOGONAL) {
-		calculatePriosOrtho(r);
-		calculatePriosOrtho(r_dead);
-		std::sort(r.begin(), r.end(), priocompare);
-		std::sort(r_dead.begin(), r_dead.end(), priocompare);
+	calculatePrios(r);
+	calculatePrios(r_dead);
+	sortRenderables(r);
+	sortRenderables(r_dead);
+
+	if (eset->tileset.orientation == eset->tileset.TILESET_ORTHOGONAL)
 		renderOrtho(r, r_dead);
-	}
-	else {
-		calculatePriosIso(r);
-		calculatePriosIso(r_dead);
-		std::sort(r.begin(), r.end(), priocompare);
-		std::sort(r_dead.begin(), r_dead.end(), priocompare);
+	else
 		renderIso(r, r_dead);
+
+	layer_cache.endFrame();
+}
+
+/**
+ * Removes renderables that would be drawn entirely outside of the view, so they don't need to be sorted
+ */
+void MapRenderer::cullRenderables(std::vector<Renderable> &r) {
+	size_t visible = 0;
+	for (size_t i = 0; i < r.size(); ++i) {
+		Point p = Utils::mapToScreen(r[i].map_pos.x, r[i].map_pos.y, cam.shake.x, cam.shake.y);
+		int x = p.x - r[i].offset.x;
+		int y = p.y - r[i].offset.y;
+
+		if (x >= settings->view_w || y >= settings->view_h || x + r[i].src.w <= 0 || y + r[i].src.h <= 0)
+			continue;
+
+		if (visible != i)
+			r[visible] = r[i];
+		visible++;
 	}
+
+	renderables_submitted += static_cast<unsigned>(visible);
+	renderables_culled += static_cast<unsigned>(r.size() - visible);
+	r.resize(visible);
 }
 
 void MapRenderer::drawRenderable(std::vector<Renderable>::iterator r_cursor) {
@@ -411,10 +521,13 @@ void MapRenderer::drawRenderable(std::vector<Renderable>::iterator r_cursor) {
 	}
 }
 
-void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile_set) {
+/**
+ * Finds the tiles that renderIsoLayer() needs to draw with the current camera position.
+ * This is the same for every layer, so it only needs to be done once per frame
+ */
+void MapRenderer::calcIsoRows() {
 	int_fast16_t i; // first index of the map array
 	int_fast16_t j; // second index of the map array
-	Point dest;
 	const Point upperleft(Utils::screenToMap(0, 0, cam.shake.x, cam.shake.y));
 	const int_fast16_t max_tiles_width =   static_cast<int_fast16_t>((settings->view_w / eset->tileset.tile_w) + 2*tset.max_size_x);
 	const int_fast16_t max_tiles_height = static_cast<int_fast16_t>((2 * settings->view_h / eset->tileset.tile_h) + 2*(tset.max_size_y+1));
@@ -422,6 +535,8 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile
 	j = static_cast<int_fast16_t>(upperleft.y - tset.max_size_y/2 + tset.max_size_x);
 	i = static_cast<int_fast16_t>(upperleft.x - tset.max_size_y/2 - tset.max_size_x);
 
+	iso_rows.clear();
+
 	for (uint_fast16_t y = max_tiles_height ; y; --y) {
 		int_fast16_t tiles_width = 0;
 
@@ -444,14 +559,44 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile
 		// lower left (south west) corner is caught by having 0 in there, so j>0
 		const int_fast16_t j_end = std::max(static_cast<int_fast16_t>(j+i-w+1),	std::max(static_cast<int_fast16_t>(j - max_tiles_width), static_cast<int_fast16_t>(0)));
 
-		Point p = Utils::mapToScreen(float(i), float(j), cam.shake.x, cam.shake.y);
-		p = centerTile(p);
+		if (j > j_end) {
+			TileRow row;
+			row.i = i;
+			row.j = j;
+			row.count = static_cast<int_fast16_t>(j - j_end);
+			row.p = centerTile(Utils::mapToScreen(float(i), float(j), cam.shake.x, cam.shake.y));
+			iso_rows.push_back(row);
+
+			i = static_cast<int_fast16_t>(i + row.count);
+			tiles_width = static_cast<int_fast16_t>(tiles_width + row.count);
+			j = j_end;
+		}
+
+		j = static_cast<int_fast16_t>(j + tiles_width);
+		i = static_cast<int_fast16_t>(i - tiles_width);
+		// Go one line deeper, the starting position goes zig-zag
+		if (y % 2)
+			i++;
+		else
+			j++;
+	}
+}
+
+void MapRenderer::renderIsoLayer(size_t layer_index, const TileSet& tile_set) {
+	Point dest;
+
+	const Map_Layer& layerdata = layers[layer_index];
+	const bool check_fow = (fogofwar == FogOfWar::TYPE_OVERLAY && layer_index != fow->dark_layer_id);
+
+	for (size_t row = 0; row < iso_rows.size(); ++row) {
+		int_fast16_t i = iso_rows[row].i;
+		int_fast16_t j = iso_rows[row].j;
+		Point p = iso_rows[row].p;
 
 		// draw one horizontal line
-		while (j > j_end) {
+		for (int_fast16_t count = iso_rows[row].count; count; --count) {
 			--j;
 			++i;
-			++tiles_width;
 			p.x += eset->tileset.tile_w;
 
 			if (const uint_fast16_t current_tile = layerdata[i][j]) {
@@ -461,49 +606,8 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile
 					dest.y = p.y - tile.offset.y;
 
 					//skip rendering tiles that are underneath fow hidden tiles
-					if (fogofwar == FogOfWar::TYPE_OVERLAY) {
-						if (&layerdata != &layers[fow->dark_layer_id]) {
-							if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
-
-								//check tile's corners
-								Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
-								Point t_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y, cam.shake.x, cam.shake.y));
-								Point b_l(Utils::screenToMap(dest.x, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-								Point b_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-
-								//limit to map bounds
-								if (t_l.x < 0) t_l.x = 0;
-								if (t_l.x >= w) t_l.x = w-1;
-								if (t_l.y < 0) t_l.y = 0;
-								if (t_l.y >= h) t_l.y = h-1;
-
-								if (t_r.x < 0) t_r.x = 0;
-								if (t_r.x >= w) t_r.x = w-1;
-								if (t_r.y < 0) t_r.y = 0;
-								if (t_r.y >= h) t_r.y = h-1;
-
-								if (b_l.x < 0) b_l.x = 0;
-								if (b_l.x >= w) b_l.x = w-1;
-								if (b_l.y < 0) b_l.y = 0;
-								if (b_l.y >= h) b_l.y = h-1;
-
-								if (b_r.x < 0) b_r.x = 0;
-								if (b_r.x >= w) b_r.x = w-1;
-								if (b_r.y < 0) b_r.y = 0;
-								if (b_r.y >= h) b_r.y = h-1;
-
-								if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-											if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
-												continue;
-											}
-										}
-									}
-								}
-							}
-						}
-					}
+					if (check_fow && isFogHiddenTile(layer_index, i, j, tile))
+						continue;
 
 					// no need to set w and h in dest, as it is ignored
 					// by SDL_BlitSurface
@@ -519,16 +623,20 @@ void MapRenderer::renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile
 				}
 			}
 		}
-		j = static_cast<int_fast16_t>(j + tiles_width);
-		i = static_cast<int_fast16_t>(i - tiles_width);
-		// Go one line deeper, the starting position goes zig-zag
-		if (y % 2)
-			i++;
-		else
-			j++;
 	}
 }
 
+/**
+ * Layers below the object layer are never faded and only need per-tile colors for tinted fog of war, so they can be
+ * drawn from pre-rendered chunks. Returns false if the layer still needs to be drawn tile by tile
+ */
+bool MapRenderer::renderCachedLayer(size_t layer_index) {
+	if (fogofwar == FogOfWar::TYPE_TINT)
+		return false;
+
+	return layer_cache.render(layer_index, layers[layer_index], tset, cam.shake);
+}
+
 void MapRenderer::renderIsoBackObjects(std::vector<Renderable> &r) {
 	std::vector<Renderable>::iterator it;
 	for (it = r.begin(); it != r.end(); ++it)
@@ -559,7 +667,7 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 	std::queue<std::vector<Renderable>::iterator> render_behind_NE;
 	std::queue<std::vector<Renderable>::iterator> render_behind_none;
 
-	Map_Layer drawn_tiles(w, std::vector<unsigned short>(h, 0));
+	Map_Layer drawn_tiles(w, h);
 
 	for (uint_fast16_t y = max_tiles_height ; y; --y) {
 		int_fast16_t tiles_width = 0;
@@ -582,6 +690,7 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 		Point p = Utils::mapToScreen(float(i), float(j), cam.shake.x, cam.shake.y);
 		p = centerTile(p);
 		const Map_Layer &current_layer = layers[index_objectlayer];
+		const bool check_fow = (fogofwar == FogOfWar::TYPE_OVERLAY && index_objectlayer != fow->dark_layer_id);
 		bool is_last_NE_tile = false;
 		while (j > j_end) {
 			--j;
@@ -615,49 +724,8 @@ void MapRenderer::renderIsoFrontObjects(std::vector<Renderable> &r) {
 						tile.tile->setDestFromPoint(dest);
 
 						//skip rendering tiles that are underneath fow hidden tiles
-						if (fogofwar == FogOfWar::TYPE_OVERLAY) {
-							if (&current_layer != &layers[fow->dark_layer_id]) {
-								if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
-
-									//check tile's corners
-									Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
-									Point t_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y, cam.shake.x, cam.shake.y));
-									Point b_l(Utils::screenToMap(dest.x, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-									Point b_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-
-									//limit to map bounds
-									if (t_l.x < 0) t_l.x = 0;
-									if (t_l.x >= w) t_l.x = w-1;
-									if (t_l.y < 0) t_l.y = 0;
-									if (t_l.y >= h) t_l.y = h-1;
-
-									if (t_r.x < 0) t_r.x = 0;
-									if (t_r.x >= w) t_r.x = w-1;
-									if (t_r.y < 0) t_r.y = 0;
-									if (t_r.y >= h) t_r.y = h-1;
-
-									if (b_l.x < 0) b_l.x = 0;
-									if (b_l.x >= w) b_l.x = w-1;
-									if (b_l.y < 0) b_l.y = 0;
-									if (b_l.y >= h) b_l.y = h-1;
-
-									if (b_r.x < 0) b_r.x = 0;
-									if (b_r.x >= w) b_r.x = w-1;
-									if (b_r.y < 0) b_r.y = 0;
-									if (b_r.y >= h) b_r.y = h-1;
-
-									if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-											if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-												if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
-													continue;
-												}
-											}
-										}
-									}
-								}
-							}
-						}
+						if (check_fow && isFogHiddenTile(index_objectlayer, i, j, tile))
+							continue;
 
 						if (fogofwar == FogOfWar::TYPE_TINT) {
 							tile.tile->color_mod = fow->getTileColorMod(i, j);
@@ -834,8 +902,11 @@ do_last_NE_tile:
 void MapRenderer::renderIso(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
 	size_t index = 0;
 
+	calcIsoRows();
+
 	while (index < index_objectlayer) {
-		renderIsoLayer(layers[index], tset);
+		if (!renderCachedLayer(index))
+			renderIsoLayer(index, tset);
 		map_parallax.render(cam.shake, layernames[index]);
 		index++;
 	}
@@ -848,17 +919,17 @@ void MapRenderer::renderIso(std::vector<Renderable> &r, std::vector<Renderable>
 	while (index < layers.size()) {
 		if (fogofwar == FogOfWar::TYPE_OVERLAY) {
 			if (layernames[index] == "fow_dark") {
-				renderIsoLayer(layers[index],fow->tset_dark);
+				renderIsoLayer(index, fow->tset_dark);
 			}
 			else if (layernames[index] == "fow_fog") {
-				renderIsoLayer(layers[index],fow->tset_fog);
+				renderIsoLayer(index, fow->tset_fog);
 			}
 			else {
-				renderIsoLayer(layers[index], tset);
+				renderIsoLayer(index, tset);
 			}
 		}
 		else if (layernames[index] != "fow_dark" && layernames[index] != "fow_fog") {
-			renderIsoLayer(layers[index], tset);
+			renderIsoLayer(index, tset);
 		}
 		map_parallax.render(cam.shake, layernames[index]);
 		index++;
@@ -870,9 +941,11 @@ void MapRenderer::renderIso(std::vector<Renderable> &r, std::vector<Renderable>
 	drawDevCursor();
 }
 
-void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata, const TileSet& tile_set) {
+void MapRenderer::renderOrthoLayer(size_t layer_index, const TileSet& tile_set) {
 
 	Point dest;
+	const Map_Layer& layerdata = layers[layer_index];
+	const bool check_fow = (fogofwar == FogOfWar::TYPE_OVERLAY && layer_index != fow->dark_layer_id);
 	const Point upperleft(Utils::screenToMap(0, 0, cam.shake.x, cam.shake.y));
 
 	short int startj = static_cast<short int>(std::max(0, upperleft.y));
@@ -897,49 +970,8 @@ void MapRenderer::renderOrthoLayer(const Map_Layer& layerdata, const TileSet& ti
 					bool skip_tile_render = false;
 
 					//skip rendering tiles that are underneath fow hidden tiles
-					if (fogofwar == FogOfWar::TYPE_OVERLAY) {
-						if (&layerdata != &layers[fow->dark_layer_id]) {
-							if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
-
-								//check tile's corners
-								Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
-								Point t_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y, cam.shake.x, cam.shake.y));
-								Point b_l(Utils::screenToMap(dest.x, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-								Point b_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-
-								//limit to map bounds
-								if (t_l.x < 0) t_l.x = 0;
-								if (t_l.x >= w) t_l.x = w-1;
-								if (t_l.y < 0) t_l.y = 0;
-								if (t_l.y >= h) t_l.y = h-1;
-
-								if (t_r.x < 0) t_r.x = 0;
-								if (t_r.x >= w) t_r.x = w-1;
-								if (t_r.y < 0) t_r.y = 0;
-								if (t_r.y >= h) t_r.y = h-1;
-
-								if (b_l.x < 0) b_l.x = 0;
-								if (b_l.x >= w) b_l.x = w-1;
-								if (b_l.y < 0) b_l.y = 0;
-								if (b_l.y >= h) b_l.y = h-1;
-
-								if (b_r.x < 0) b_r.x = 0;
-								if (b_r.x >= w) b_r.x = w-1;
-								if (b_r.y < 0) b_r.y = 0;
-								if (b_r.y >= h) b_r.y = h-1;
-
-								if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-											if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
-												skip_tile_render = true;
-											}
-										}
-									}
-								}
-							}
-						}
-					}
+					if (check_fow)
+						skip_tile_render = isFogHiddenTile(layer_index, i, j, tile);
 
 					tile.tile->setDestFromPoint(dest);
 					if (!skip_tile_render) {
@@ -987,6 +1019,8 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 	if (index_objectlayer >= layers.size())
 		return;
 
+	const bool check_fow = (fogofwar == FogOfWar::TYPE_OVERLAY && index_objectlayer != fow->dark_layer_id);
+
 	for (j = startj; j < max_tiles_height; j++) {
 		Point p = Utils::mapToScreen(starti, j, cam.shake.x, cam.shake.y);
 		p = centerTile(p);
@@ -1002,49 +1036,8 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 					bool skip_tile_render = false;
 
 					//skip rendering tiles that are underneath fow hidden tiles
-					if (fogofwar == FogOfWar::TYPE_OVERLAY) {
-						if (&layers[index_objectlayer] != &layers[fow->dark_layer_id]) {
-							if (layers[fow->dark_layer_id][i][j] == FogOfWar::TILE_HIDDEN) {
-
-								//check tile's corners
-								Point t_l(Utils::screenToMap(dest.x, dest.y, cam.shake.x, cam.shake.y));
-								Point t_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y, cam.shake.x, cam.shake.y));
-								Point b_l(Utils::screenToMap(dest.x, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-								Point b_r(Utils::screenToMap(dest.x + tile.tile->getClip().w, dest.y + tile.tile->getClip().h, cam.shake.x, cam.shake.y));
-
-								//limit to map bounds
-								if (t_l.x < 0) t_l.x = 0;
-								if (t_l.x >= w) t_l.x = w-1;
-								if (t_l.y < 0) t_l.y = 0;
-								if (t_l.y >= h) t_l.y = h-1;
-
-								if (t_r.x < 0) t_r.x = 0;
-								if (t_r.x >= w) t_r.x = w-1;
-								if (t_r.y < 0) t_r.y = 0;
-								if (t_r.y >= h) t_r.y = h-1;
-
-								if (b_l.x < 0) b_l.x = 0;
-								if (b_l.x >= w) b_l.x = w-1;
-								if (b_l.y < 0) b_l.y = 0;
-								if (b_l.y >= h) b_l.y = h-1;
-
-								if (b_r.x < 0) b_r.x = 0;
-								if (b_r.x >= w) b_r.x = w-1;
-								if (b_r.y < 0) b_r.y = 0;
-								if (b_r.y >= h) b_r.y = h-1;
-
-								if (layers[fow->dark_layer_id][t_l.x][t_l.y] == FogOfWar::TILE_HIDDEN) {
-									if (layers[fow->dark_layer_id][t_r.x][t_r.y] == FogOfWar::TILE_HIDDEN) {
-										if (layers[fow->dark_layer_id][b_l.x][b_l.y] == FogOfWar::TILE_HIDDEN) {
-											if (layers[fow->dark_layer_id][b_r.x][b_r.y] == FogOfWar::TILE_HIDDEN) {
-												skip_tile_render = true;
-											}
-										}
-									}
-								}
-							}
-						}
-					}
+					if (check_fow)
+						skip_tile_render = isFogHiddenTile(index_objectlayer, i, j, tile);
 
 					if (!skip_tile_render) {
 						if (fogofwar == FogOfWar::TYPE_TINT) {
@@ -1075,7 +1068,8 @@ void MapRenderer::renderOrthoFrontObjects(std::vector<Renderable> &r) {
 void MapRenderer::renderOrtho(std::vector<Renderable> &r, std::vector<Renderable> &r_dead) {
 	unsigned index = 0;
 	while (index < index_objectlayer) {
-		renderOrthoLayer(layers[index], tset);
+		if (!renderCachedLayer(index))
+			renderOrthoLayer(index, tset);
 		map_parallax.render(cam.shake, layernames[index]);
 		index++;
 	}
@@ -1088,17 +1082,17 @@ void MapRenderer::renderOrtho(std::vector<Renderable> &r, std::vector<Renderable
 	while (index < layers.size()) {
 		if (fogofwar == FogOfWar::TYPE_OVERLAY) {
 			if (layernames[index] == "fow_dark") {
-				renderOrthoLayer(layers[index],fow->tset_dark);
+				renderOrthoLayer(index, fow->tset_dark);
 			}
 			else if (layernames[index] == "fow_fog") {
-				renderOrthoLayer(layers[index],fow->tset_fog);
+				renderOrthoLayer(index, fow->tset_fog);
 			}
 			else {
-				renderOrthoLayer(layers[index], tset);
+				renderOrthoLayer(index, tset);
 			}
 		}
 		else if (layernames[index] != "fow_dark" && layernames[index] != "fow_fog") {
-			renderOrthoLayer(layers[index], tset);
+			renderOrthoLayer(index, tset);
 		}
 		map_parallax.render(cam.shake, layernames[index]);
 		index++;
@@ -1126,40 +1120,44 @@ void MapRenderer::executeOnLoadEvents() {
 		return;
 	}
 
-	std::vector<Event>::iterator it;
+	camp->checkHeroChanges();
 
-	// loop in reverse because we may erase elements
-	for (it = events.end(); it != events.begin(); ) {
-		--it;
+	// loop in reverse, like the other event checks
+	for (size_t i = events.size(); i > 0; --i) {
+		std::vector<Event>::iterator it = events.begin() + (i-1);
 
 		// skip inactive events
-		if (!eventm->isActive(*it)) continue;
+		if (it->removed || !eventm->isActive(*it)) continue;
 
 		if ((*it).activate_type == Event::ACTIVATE_ON_LOAD) {
 			if (eventm->executeEvent(*it))
-				it = events.erase(it);
+				removeEvent(i-1);
 		}
 	}
 
 	// Also check static events, as they should execute alongside on_load events
 	// Yet, this should be done *after* the on_load events to not break old behavior.
 	// That's why we don't just check static events in the above loop
-	for (it = events.end(); it != events.begin(); ) {
-		--it;
+	for (size_t i = events.size(); i > 0; --i) {
+		std::vector<Event>::iterator it = events.begin() + (i-1);
 
 		// skip inactive events
-		if (!eventm->isActive(*it)) continue;
+		if (it->removed || !eventm->isActive(*it)) continue;
 
 		if ((*it).activate_type == Event::ACTIVATE_STATIC) {
 			if (eventm->executeEvent(*it))
-				it = events.erase(it);
+				removeEvent(i-1);
 		}
 	}
+
+	eraseRemovedEvents();
 }
 
 void MapRenderer::executeOnMapExitEvents() {
 	std::vector<Event>::iterator it;
 
+	camp->checkHeroChanges();
+
 	// We're leaving the map, so the events of this map are removed anyway in
 	// the next frame (Reminder: We're about to load a new map ;),
 	// so we will ignore the events keep_after_trigger value and do not delete
@@ -1174,29 +1172,68 @@ void MapRenderer::executeOnMapExitEvents() {
 	}
 }
 
+/**
+ * Brings the cached event requirements and the event index up to date before looking for events to trigger
+ */
+void MapRenderer::prepareEvents() {
+	camp->checkHeroChanges();
+	event_index.update(events, w, h);
+}
+
+/**
+ * Events are only marked while the event checks loop over the index, eraseRemovedEvents() takes them out afterwards
+ */
+void MapRenderer::removeEvent(size_t index) {
+	events[index].removed = true;
+	has_removed_events = true;
+}
+
+void MapRenderer::eraseRemovedEvents() {
+	if (!has_removed_events)
+		return;
+
+	// keep the remaining events in their original order
+	size_t dest = 0;
+	for (size_t i = 0; i < events.size(); ++i) {
+		if (events[i].removed)
+			continue;
+		if (dest != i)
+			events[dest] = events[i];
+		++dest;
+	}
+	events.erase(events.begin() + dest, events.end());
+
+	has_removed_events = false;
+	event_index.clear();
+}
+
 void MapRenderer::checkEvents(const FPoint& loc) {
 	Point maploc;
 	maploc.x = int(loc.x);
 	maploc.y = int(loc.y);
-	std::vector<Event>::iterator it;
 
-	// loop in reverse because we may erase elements
-	for (it = events.end(); it != events.begin(); ) {
-		--it;
+	prepareEvents();
+
+	// only events at the hero's tile and those that don't depend on the hero's position can be triggered
+	event_index.query(Rect(maploc.x, maploc.y, 1, 1), MapEventIndex::QUERY_GLOBAL, event_candidates);
+
+	for (size_t i = 0; i < event_candidates.size(); ++i) {
+		const size_t index = event_candidates[i];
+		std::vector<Event>::iterator it = events.begin() + index;
 
 		// skip inactive events
-		if (!eventm->isActive(*it)) continue;
+		if (it->removed || !eventm->isActive(*it)) continue;
 
 		// static events are run every frame without interaction from the player
 		if ((*it).activate_type == Event::ACTIVATE_STATIC) {
 			if (eventm->executeEvent(*it))
-				it = events.erase(it);
+				removeEvent(index);
 			continue;
 		}
 
 		if ((*it).activate_type == Event::ACTIVATE_ON_CLEAR) {
 			if (enemies_cleared && eventm->executeEvent(*it))
-				it = events.erase(it);
+				removeEvent(index);
 			continue;
 		}
 
@@ -1216,16 +1253,18 @@ void MapRenderer::checkEvents(const FPoint& loc) {
 				if ((*it).getComponent(EventComponent::WAS_INSIDE_EVENT_AREA)) {
 					(*it).deleteAllComponents(EventComponent::WAS_INSIDE_EVENT_AREA);
 					if (eventm->executeEvent(*it))
-						it = events.erase(it);
+						removeEvent(index);
 				}
 			}
 		}
 		else if ((*it).activate_type == Event::ACTIVATE_ON_TRIGGER) {
 			if (inside)
 				if (eventm->executeEvent(*it))
-					it = events.erase(it);
+					removeEvent(index);
 		}
 	}
+
+	eraseRemovedEvents();
 }
 
 /**
@@ -1256,11 +1295,17 @@ void MapRenderer::checkHotspots() {
 
 	int interact_key = (settings->mouse_move && settings->mouse_move_swap) ? Input::MAIN2 : Input::MAIN1;
 
-	// work backwards through events because events can be erased in the loop.
-	// this prevents the iterator from becoming invalid.
-	std::vector<Event>::iterator it;
-	for (it = events.end(); it != events.begin(); ) {
-		--it;
+	prepareEvents();
+
+	// a tile can be drawn this far (in tiles) from its position, so only hotspots this close to the tile under the mouse can match
+	// NPC hotspots are matched against the NPC's sprite, so they are always checked
+	const int reach = tset.max_size_x + tset.max_size_y + 1;
+	const Point mouse_tile(Utils::screenToMap(mouse_pos.x, mouse_pos.y, cam.pos.x, cam.pos.y));
+	event_index.query(Rect(mouse_tile.x - reach, mouse_tile.y - reach, reach * 2 + 1, reach * 2 + 1), MapEventIndex::QUERY_NPC, event_candidates);
+
+	for (size_t i = 0; i < event_candidates.size(); ++i) {
+		const size_t event_id = event_candidates[i];
+		std::vector<Event>::iterator it = events.begin() + event_id;
 
 		// skip inactive events
 		if (!eventm->isActive(*it)) continue;
@@ -1346,8 +1391,10 @@ void MapRenderer::checkHotspots() {
 							pc->mm_target_object = Avatar::MM_TARGET_NONE;
 						}
 
-						if (eventm->executeEvent(*it))
-							it = events.erase(it);
+						if (eventm->executeEvent(*it)) {
+							removeEvent(event_id);
+							eraseRemovedEvents();
+						}
 					}
 					else if (settings->mouse_move) {
 						if (is_npc) {
@@ -1384,13 +1431,18 @@ void MapRenderer::checkHotspots() {
 void MapRenderer::checkNearestEvent() {
 	if (!inpt->usingMouse()) show_tooltip = false;
 
-	std::vector<Event>::iterator it;
+	prepareEvents();
+
+	// events are indexed by their center, which must be within interact_range
+	const int range = static_cast<int>(ceilf(eset->misc.interact_range)) + 1;
+	const Point hero_tile(pc->stats.pos);
+	event_index.query(Rect(hero_tile.x - range, hero_tile.y - range, range * 2 + 1, range * 2 + 1), MapEventIndex::QUERY_NPC, event_candidates);
+
 	std::vector<Event>::iterator nearest = events.end();
 	float best_distance = std::numeric_limits<float>::max();
 
-	// loop in reverse because we may erase elements
-	for (it = events.end(); it != events.begin(); ) {
-		--it;
+	for (size_t i = 0; i < event_candidates.size(); ++i) {
+		std::vector<Event>::iterator it = events.begin() + event_candidates[i];
 
 		// skip inactive events
 		if (!eventm->isActive(*it)) continue;
@@ -1426,8 +1478,11 @@ void MapRenderer::checkNearestEvent() {
 		if (inpt->pressing[Input::ACCEPT] && !inpt->lock[Input::ACCEPT]) {
 			inpt->lock[Input::ACCEPT] = true;
 
-			if(eventm->executeEvent(*nearest))
-				events.erase(nearest);
+			const size_t index = static_cast<size_t>(nearest - events.begin());
+			if(eventm->executeEvent(*nearest)) {
+				removeEvent(index);
+				eraseRemovedEvents();
+			}
 		}
 	}
 }
@@ -1494,6 +1549,85 @@ Point MapRenderer::centerTile(const Point& p) {
 	return r;
 }
 
+/**
+ * Checks if a tile is drawn entirely over hidden fog of war, by looking at where the corners of its image are on the map.
+ * The result only depends on the map, so it is kept until invalidateFogHiddenTiles() is called for the tile
+ */
+bool MapRenderer::isFogHiddenTile(size_t layer_index, const int_fast16_t x, const int_fast16_t y, const Tile_Def& tile) {
+	if (fow_hidden_tiles.size() != layers.size())
+		fow_hidden_tiles.resize(layers.size());
+
+	std::vector<uint8_t>& hidden_tiles = fow_hidden_tiles[layer_index];
+	if (hidden_tiles.size() != static_cast<size_t>(w) * h)
+		hidden_tiles.assign(static_cast<size_t>(w) * h, FOW_HIDDEN_UNKNOWN);
+
+	uint8_t& state = hidden_tiles[static_cast<size_t>(y) * w + x];
+	if (state != FOW_HIDDEN_UNKNOWN)
+		return state == FOW_HIDDEN_YES;
+
+	const Map_Layer& dark_layer = layers[fow->dark_layer_id];
+	state = FOW_HIDDEN_NO;
+
+	if (dark_layer[x][y] != FogOfWar::TILE_HIDDEN)
+		return false;
+
+	// the camera position doesn't matter here, so use the origin
+	const Point p = centerTile(Utils::mapToScreen(float(x), float(y), 0, 0));
+	const Point dest(p.x - tile.offset.x, p.y - tile.offset.y);
+	const Rect clip = tile.tile->getClip();
+
+	Point corners[4];
+	corners[0] = Point(Utils::screenToMap(dest.x, dest.y, 0, 0));
+	corners[1] = Point(Utils::screenToMap(dest.x + clip.w, dest.y, 0, 0));
+	corners[2] = Point(Utils::screenToMap(dest.x, dest.y + clip.h, 0, 0));
+	corners[3] = Point(Utils::screenToMap(dest.x + clip.w, dest.y + clip.h, 0, 0));
+
+	for (int k = 0; k < 4; ++k) {
+		fow_hidden_reach = std::max(fow_hidden_reach, std::max(abs(corners[k].x - static_cast<int>(x)), abs(corners[k].y - static_cast<int>(y))));
+
+		//limit to map bounds
+		const int corner_x = std::max(0, std::min(corners[k].x, w-1));
+		const int corner_y = std::max(0, std::min(corners[k].y, h-1));
+		if (dark_layer[corner_x][corner_y] != FogOfWar::TILE_HIDDEN)
+			return false;
+	}
+
+	state = FOW_HIDDEN_YES;
+	return true;
+}
+
+/**
+ * Tiles near the area might have corners inside it, so they are checked again too
+ */
+void MapRenderer::invalidateFogHiddenTiles(const Rect& area) {
+	const int x_min = std::max(0, area.x - fow_hidden_reach);
+	const int y_min = std::max(0, area.y - fow_hidden_reach);
+	const int x_max = std::min(static_cast<int>(w) - 1, area.x + area.w - 1 + fow_hidden_reach);
+	const int y_max = std::min(static_cast<int>(h) - 1, area.y + area.h - 1 + fow_hidden_reach);
+
+	for (size_t i = 0; i < fow_hidden_tiles.size(); ++i) {
+		std::vector<uint8_t>& hidden_tiles = fow_hidden_tiles[i];
+		if (hidden_tiles.empty())
+			continue;
+
+		for (int y = y_min; y <= y_max; ++y) {
+			for (int x = x_min; x <= x_max; ++x) {
+				hidden_tiles[static_cast<size_t>(y) * w + x] = FOW_HIDDEN_UNKNOWN;
+			}
+		}
+	}
+}
+
+void MapRenderer::setLayerTile(size_t layer_index, int x, int y, unsigned short tile_id) {
+	if (layer_index >= layers.size() || !layers[layer_index].isValid(x, y))
+		return;
+
+	layers[layer_index][x][y] = tile_id;
+	camp->notifyChange(CampaignManager::CHANGE_TILES);
+	invalidateFogHiddenTiles(Rect(x, y, 1, 1));
+	layer_cache.invalidate(layer_index, x, y);
+}
+
 void MapRenderer::getTileBounds(const int_fast16_t x, const int_fast16_t y, const Map_Layer& layerdata, Rect& bounds, Point& center) {
 	if (x >= 0 && x < w && y >= 0 && y < h) {
 		if (const uint_fast16_t tile_index = layerdata[x][y]) {
@@ -1636,6 +1770,15 @@ void MapRenderer::drawDevHUD() {
 
 		render_device->drawEllipse(p0.x - radius, p0.y - radius/distort, p0.x + radius, p0.y + radius/distort, color_hazard, 15);
 	}
+
+	// render device statistics
+	{
+		std::string draw_calls = msg->getv("Draw calls: %d", static_cast<int>(render_device->getDrawCallCount()));
+		font->renderShadowed(draw_calls, settings->view_w_half, 0, FontEngine::JUSTIFY_CENTER, NULL, 0, font->getColor(FontEngine::COLOR_WHITE));
+
+		std::string renderables = msg->getv("Renderables: %d drawn, %d culled", static_cast<int>(renderables_submitted), static_cast<int>(renderables_culled));
+		font->renderShadowed(renderables, settings->view_w_half, font->getLineHeight(), FontEngine::JUSTIFY_CENTER, NULL, 0, font->getColor(FontEngine::COLOR_WHITE));
+	}
 }
 
 void MapRenderer::setMapParallax(const std::string& mp_filename) {
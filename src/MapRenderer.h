@@ -30,8 +30,10 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "Camera.h"
 #include "CommonIncludes.h"
+#include "LayerChunkCache.h"
 #include "Map.h"
 #include "MapCollision.h"
+#include "MapEventIndex.h"
 #include "MapParallax.h"
 #include "TileSet.h"
 #include "TooltipData.h"
@@ -58,7 +60,20 @@ private:
 
 	void drawRenderable(std::vector<Renderable>::iterator r_cursor);
 
-	void renderIsoLayer(const Map_Layer& layerdata, const TileSet& tile_set);
+	void cullRenderables(std::vector<Renderable> &r);
+
+	// the first tile and its screen position for each row of tiles in the view, see calcIsoRows()
+	class TileRow {
+	public:
+		int_fast16_t i;
+		int_fast16_t j;
+		int_fast16_t count;
+		Point p;
+	};
+
+	void calcIsoRows();
+	void renderIsoLayer(size_t layer_index, const TileSet& tile_set);
+	bool renderCachedLayer(size_t layer_index);
 
 	// renders only objects
 	void renderIsoBackObjects(std::vector<Renderable> &r);
@@ -67,7 +82,7 @@ private:
 	void renderIsoFrontObjects(std::vector<Renderable> &r);
 	void renderIso(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
 
-	void renderOrthoLayer(const Map_Layer& layerdata, const TileSet& tile_set);
+	void renderOrthoLayer(size_t layer_index, const TileSet& tile_set);
 	void renderOrthoBackObjects(std::vector<Renderable> &r);
 	void renderOrthoFrontObjects(std::vector<Renderable> &r);
 	void renderOrtho(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
@@ -76,11 +91,17 @@ private:
 
 	void createTooltip(EventComponent *ec);
 
+	void prepareEvents();
+	void removeEvent(size_t index);
+	void eraseRemovedEvents();
+
 	void getTileBounds(const int_fast16_t x, const int_fast16_t y, const Map_Layer& layerdata, Rect& bounds, Point& center);
 
 	void drawDevCursor();
 	void drawDevHUD();
 
+	bool isFogHiddenTile(size_t layer_index, const int_fast16_t x, const int_fast16_t y, const Tile_Def& tile);
+
 	bool checkTileOverlappingHero(const int_fast16_t x, const int_fast16_t y, const Map_Layer& layerdata);
 	void fadeOverlapTile(const Tile_Def& tile, const int_fast16_t x, const int_fast16_t y, const Map_Layer& layerdata);
 
@@ -90,6 +111,36 @@ private:
 
 	std::vector<std::vector<Renderable>::iterator> hidden_entities;
 
+	std::vector<TileRow> iso_rows;
+
+	// scratch space for sortRenderables()
+	std::vector< std::pair<uint64_t, unsigned> > sort_keys;
+	std::vector< std::pair<uint64_t, unsigned> > sort_keys_temp;
+	std::vector<Renderable> sort_buffer;
+
+	// for each layer and tile, whether it is drawn entirely over hidden fog of war. See isFogHiddenTile()
+	enum {
+		FOW_HIDDEN_UNKNOWN = 0,
+		FOW_HIDDEN_NO = 1,
+		FOW_HIDDEN_YES = 2
+	};
+	std::vector< std::vector<uint8_t> > fow_hidden_tiles;
+
+	// how far (in tiles) the corners of a tile can be from the tile itself
+	int fow_hidden_reach;
+
+	// pre-rendered chunks of the layers below the object layer
+	LayerChunkCache layer_cache;
+
+	// renderables kept and dropped by cullRenderables() during the last frame
+	unsigned renderables_submitted;
+	unsigned renderables_culled;
+
+	// events near the hero or the mouse cursor, see MapEventIndex
+	MapEventIndex event_index;
+	std::vector<size_t> event_candidates;
+	bool has_removed_events;
+
 public:
 	typedef std::pair< std::vector<EventComponent>, Point> MapLoot;
 
@@ -105,6 +156,10 @@ public:
 	void logic(bool paused);
 	void render(std::vector<Renderable> &r, std::vector<Renderable> &r_dead);
 
+	// render() calls these on every frame. Public so that --benchmark can time them
+	void calculatePrios(std::vector<Renderable> &r);
+	void sortRenderables(std::vector<Renderable> &r);
+
 	void checkEvents(const FPoint& loc);
 	void checkHotspots();
 	void checkNearestEvent();
@@ -122,6 +177,12 @@ public:
 	bool isValidTile(const unsigned &tile);
 	Point centerTile(const Point& p);
 
+	// called when tiles in the area (of any layer) change, or when fog of war is revealed there
+	void invalidateFogHiddenTiles(const Rect& area);
+
+	// changes a single tile of a layer, updating anything that was derived from it
+	void setLayerTile(size_t layer_index, int x, int y, unsigned short tile_id);
+
 	void setMapParallax(const std::string& mp_filename);
 
 	void drawProcgenChunkMap(Image* canvas);
@@ -36,10 +36,12 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "NPC.h"
 #include "NPCManager.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
+#include "SoundManager.h"
 #include "Utils.h"
 #include "UtilsFileSystem.h"
 #include "UtilsParsing.h"
@@ -478,6 +480,10 @@ void MenuDevConsole::execute() {
 		log_history->add("toggle_fps - " + msg->get("turns on/off the display of the FPS counter"), WidgetLog::MSG_UNIQUE);
 		log_history->add("toggle_hud - " + msg->get("turns on/off all of the HUD elements"), WidgetLog::MSG_UNIQUE);
 		log_history->add("toggle_devhud - " + msg->get("turns on/off the developer hud"), WidgetLog::MSG_UNIQUE);
+		log_history->add("toggle_profiler - " + msg->get("turns on/off the frame profiler overlay"), WidgetLog::MSG_UNIQUE);
+		log_history->add("profile_start - " + msg->get("starts recording the time spent in each part of every frame"), WidgetLog::MSG_UNIQUE);
+		log_history->add("profile_stop - " + msg->get("stops recording and saves the frame times as CSV and as a Chrome trace"), WidgetLog::MSG_UNIQUE);
+		log_history->add("sound_stats - " + msg->get("prints the hit rate and memory use of the sound effect cache, and how sounds are using the mixer channels"), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_powers - " + msg->get("Prints a list of powers that match a search term. No search term will list all items"), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_maps - " + msg->get("Prints out all the map filenames located in the \"maps/\" directory."), WidgetLog::MSG_UNIQUE);
 		log_history->add("list_status - " + msg->get("Prints out the active campaign statuses that match a search term. No search term will list all active statuses"), WidgetLog::MSG_UNIQUE);
@@ -503,6 +509,46 @@ void MenuDevConsole::execute() {
 		settings->show_fps = !settings->show_fps;
 		log_history->add(msg->get("Toggled the FPS counter"), WidgetLog::MSG_UNIQUE);
 	}
+	else if (args[0] == "toggle_profiler") {
+		profiler->show_overlay = !profiler->show_overlay;
+		log_history->add(msg->get("Toggled the profiler overlay"), WidgetLog::MSG_UNIQUE);
+	}
+	else if (args[0] == "profile_start") {
+		profiler->startRecording();
+		log_history->add(msg->get("Started recording frame times"), WidgetLog::MSG_UNIQUE);
+	}
+	else if (args[0] == "profile_stop") {
+		if (!profiler->isRecording()) {
+			log_history->add(msg->get("Frame times are not being recorded. Use 'profile_start' first."), WidgetLog::MSG_UNIQUE);
+		}
+		else {
+			std::string csv_filename = settings->path_user + "profile.csv";
+			std::string trace_filename = settings->path_user + "profile_trace.json";
+			if (profiler->stopRecording(csv_filename, trace_filename)) {
+				log_history->add(msg->getv("Saved frame times to '%s' and '%s'", csv_filename.c_str(), trace_filename.c_str()), WidgetLog::MSG_UNIQUE);
+			}
+			else {
+				log_history->add(msg->get("Could not save the frame times. See the log for details."), WidgetLog::MSG_UNIQUE);
+			}
+		}
+	}
+	else if (args[0] == "sound_stats") {
+		SoundStats stats;
+		snd->getStats(stats);
+
+		const unsigned long plays = stats.hits + stats.misses;
+		const float hit_rate = (plays > 0 ? 100.0f * static_cast<float>(stats.hits) / static_cast<float>(plays) : 100.0f);
+		const float resident_mb = static_cast<float>(stats.resident_bytes) / (1024.0f * 1024.0f);
+
+		log_history->add(msg->getv("Decoded sounds: %d of %d (%.1f MB)", static_cast<int>(stats.resident_count), static_cast<int>(stats.sound_count), resident_mb), WidgetLog::MSG_UNIQUE);
+		if (stats.budget_bytes > 0)
+			log_history->add(msg->getv("Cache budget: %d MB", static_cast<int>(stats.budget_bytes / (1024 * 1024))), WidgetLog::MSG_UNIQUE);
+		else
+			log_history->add(msg->get("Cache budget: unlimited"), WidgetLog::MSG_UNIQUE);
+		log_history->add(msg->getv("Hit rate: %.1f%% (%d hits, %d misses, %d evictions)", hit_rate, static_cast<int>(stats.hits), static_cast<int>(stats.misses), static_cast<int>(stats.evictions)), WidgetLog::MSG_UNIQUE);
+		log_history->add(msg->getv("Voices: %d playing, %d virtual, %d stopped for more important sounds", static_cast<int>(stats.playing_voices), static_cast<int>(stats.virtual_voices), static_cast<int>(stats.stolen)), WidgetLog::MSG_UNIQUE);
+		log_history->add(msg->getv("Sounds skipped: %d out of range, %d duplicates, %d without a channel", static_cast<int>(stats.culled), static_cast<int>(stats.coalesced), static_cast<int>(stats.dropped)), WidgetLog::MSG_UNIQUE);
+	}
 	else if (args[0] == "list_status") {
 		std::string search_terms;
 		for (size_t i=1; i<args.size(); i++) {
@@ -54,6 +54,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "ModManager.h"
 #include "NPC.h"
 #include "PowerManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
@@ -316,6 +317,8 @@ void MenuManager::handleKeyboardNavigation() {
 }
 
 void MenuManager::logic() {
+	PROFILE_SCOPE("MenuManager::logic");
+
 	ItemStack stack;
 
 	subtitles->logic(snd->getLastPlayedSID());
@@ -1545,6 +1548,8 @@ void MenuManager::resetDrag() {
 }
 
 void MenuManager::render() {
+	PROFILE_SCOPE("MenuManager::render");
+
 	if (!settings->show_hud) {
 		// if the hud is disabled, only show a few necessary menus
 
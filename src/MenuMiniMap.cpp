@@ -270,24 +270,40 @@ void MenuMiniMap::prerender(MapCollision *collider, int map_w, int map_h) {
 	map_size.y = map_h;
 
 	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC) {
-		prerenderIso(collider, &map_surface, &map_surface_entities, base_zoom);
-		prerenderIso(collider, &map_surface_2x, &map_surface_entities_2x, base_zoom*2);
+		prerenderIso(&map_surface, &map_surface_entities, base_zoom);
+		prerenderIso(&map_surface_2x, &map_surface_entities_2x, base_zoom*2);
 	}
 	else {
 		// eset->tileset.TILESET_ORTHOGONAL
-		prerenderOrtho(collider, &map_surface, &map_surface_entities, base_zoom);
-		prerenderOrtho(collider, &map_surface_2x, &map_surface_entities_2x, base_zoom*2);
+		prerenderOrtho(&map_surface, &map_surface_entities, base_zoom);
+		prerenderOrtho(&map_surface_2x, &map_surface_entities_2x, base_zoom*2);
 	}
+
+	Rect bounds(0, 0, map_size.x, map_size.y);
+	update(collider, &bounds);
 }
+
 void MenuMiniMap::update(MapCollision *collider, Rect *bounds) {
+	Rect area;
+	area.x = std::max(bounds->x, 0);
+	area.y = std::max(bounds->y, 0);
+	area.w = std::min(bounds->w, map_size.x) - area.x;
+	area.h = std::min(bounds->h, map_size.y) - area.y;
+
+	if (area.w <= 0 || area.h <= 0)
+		return;
+
+	// both zoom levels are drawn from the same tile colors
+	fillTileColors(collider, area);
+
 	if (eset->tileset.orientation == eset->tileset.TILESET_ISOMETRIC) {
-		updateIso(collider, &map_surface, base_zoom, bounds);
-		updateIso(collider, &map_surface_2x, base_zoom*2, bounds);
+		updateIso(&map_surface, base_zoom, area);
+		updateIso(&map_surface_2x, base_zoom*2, area);
 	}
 	else {
 		// eset->tileset.TILESET_ORTHOGONAL
-		updateOrtho(collider, &map_surface, base_zoom, bounds);
-		updateOrtho(collider, &map_surface_2x, base_zoom*2, bounds);
+		updateOrtho(&map_surface, base_zoom, area);
+		updateOrtho(&map_surface_2x, base_zoom*2, area);
 	}
 }
 
@@ -348,146 +364,135 @@ void MenuMiniMap::renderMapSurface(const FPoint& hero_pos) {
 	}
 }
 
-void MenuMiniMap::prerenderOrtho(MapCollision *collider, Sprite** tile_surface, Sprite** entity_surface, int zoom) {
+void MenuMiniMap::prerenderOrtho(Sprite** tile_surface, Sprite** entity_surface, int zoom) {
 	int surface_size = std::max(map_size.x + zoom, map_size.y + zoom) * zoom;
 	createMapSurface(tile_surface, surface_size, surface_size);
 	createMapSurface(entity_surface, pos.w, pos.h);
+}
 
-	if (!(*tile_surface))
-		return;
-
-	Rect bounds(0, 0, map_size.x, map_size.y);
-	updateOrtho(collider, tile_surface, zoom, &bounds);
+void MenuMiniMap::prerenderIso(Sprite** tile_surface, Sprite** entity_surface, int zoom) {
+	int surface_size = std::max(map_size.x + zoom, map_size.y + zoom) * 2 * zoom;
+	createMapSurface(tile_surface, surface_size, surface_size);
+	createMapSurface(entity_surface, pos.w, pos.h);
 }
 
-void MenuMiniMap::updateOrtho(MapCollision *collider, Sprite** tile_surface, int zoom, Rect *bounds) {
+void MenuMiniMap::fillTileColors(MapCollision *collider, const Rect& area) {
+	tile_colors.resize(static_cast<size_t>(area.w * area.h));
 
-	if (!(*tile_surface))
-		return;
+	const bool use_fog = eset->misc.fogofwar > 0;
 
-	Image* target_img = (*tile_surface)->getGraphics();
+	for (int j = 0; j < area.h; j++) {
+		for (int i = 0; i < area.w; i++) {
+			const int tile_x = area.x + i;
+			const int tile_y = area.y + j;
+			int tile_type = collider->colmap[tile_x][tile_y];
+			Color* draw_color = NULL;
+
+			if (tile_type == 1 || tile_type == 5) draw_color = &color_wall;
+			else if (tile_type == 2 || tile_type == 6) draw_color = &color_obst;
 
-	Color draw_color;
+			// fully transparent tiles would not change the surface
+			if (draw_color && draw_color->a == 0) draw_color = NULL;
 
-	if (bounds->x == 0 && bounds->y == 0 && bounds->w == map_size.x && bounds->h == map_size.y) {
-		target_img->beginPixelBatch();
+			// fog of war
+			if (use_fog && mapr->layers[fow->dark_layer_id][tile_x][tile_y] != 0) draw_color = NULL;
+
+			tile_colors[j * area.w + i] = draw_color;
+		}
 	}
-	else {
-		Point hero(pc->stats.pos);
+}
 
-		Rect clip;
-		clip.x = (zoom * hero.x) - pos.w/2;
-		clip.y = (zoom * hero.y) - pos.h/2;
-		clip.w = pos.w;
-		clip.h = pos.h;
+void MenuMiniMap::updateOrtho(Sprite** tile_surface, int zoom, const Rect& area) {
 
-		if (clip.x<0) clip.x=0;
-		if (clip.y<0) clip.y=0;
-		if (clip.x + clip.w > target_img->getWidth()) clip.w = target_img->getWidth() - clip.x;
-		if (clip.y + clip.h > target_img->getHeight()) clip.h = target_img->getHeight() - clip.y;
+	if (!(*tile_surface))
+		return;
 
-		target_img->beginPixelBatch(clip);
-	}
+	Image* target_img = (*tile_surface)->getGraphics();
+
+	// only the pixels covered by the updated tiles are redrawn
+	Rect clip;
+	clip.x = std::max((zoom * area.x) - 1, 0);
+	clip.y = std::max((zoom * area.y) - 1, 0);
+	clip.w = std::min((zoom * (area.x + area.w)) - 1, target_img->getWidth()) - clip.x;
+	clip.h = std::min((zoom * (area.y + area.h)) - 1, target_img->getHeight()) - clip.y;
+
+	if (clip.w <= 0 || clip.h <= 0)
+		return;
 
-	for (int i=bounds->x; i<bounds->w; i++) {
-		for (int j=bounds->y; j<bounds->h; j++) {
-			bool draw_tile = true;
-			int tile_type = collider->colmap[i][j];
+	target_img->beginPixelBatch(clip);
 
-			if (tile_type == 1 || tile_type == 5) draw_color = color_wall;
-			else if (tile_type == 2 || tile_type == 6) draw_color = color_obst;
-			else draw_tile = false;
+	for (int j = 0; j < area.h; j++) {
+		Color** row = &tile_colors[j * area.w];
 
-			if (eset->misc.fogofwar > 0) {
-				tile_type = mapr->layers[fow->dark_layer_id][i][j];
-				if (tile_type != 0) draw_tile = false;
-			}
+		int i = 0;
+		while (i < area.w) {
+			// neighboring tiles of the same color are drawn as one span
+			int span = 1;
+			while (i + span < area.w && row[i + span] == row[i])
+				span++;
 
-			if (draw_tile && draw_color.a != 0) {
+			if (row[i]) {
+				const int x = (zoom * (area.x + i)) - 1;
+				const int y = (zoom * (area.y + j)) - 1;
 				for (int l = 0; l < zoom; l++) {
-					for (int k =0; k < zoom; k++) {
-						target_img->drawPixel((zoom*i)+k-1, (zoom*j)+l-1, draw_color);
-					}
+					target_img->drawPixelSpan(x, y + l, zoom * span, *row[i]);
 				}
 			}
+
+			i += span;
 		}
 	}
 
 	target_img->endPixelBatch();
 }
 
-void MenuMiniMap::prerenderIso(MapCollision *collider, Sprite** tile_surface, Sprite** entity_surface, int zoom) {
-	int surface_size = std::max(map_size.x + zoom, map_size.y + zoom) * 2 * zoom;
-	createMapSurface(tile_surface, surface_size, surface_size);
-	createMapSurface(entity_surface, pos.w, pos.h);
+void MenuMiniMap::updateIso(Sprite** tile_surface, int zoom, const Rect& area) {
 
 	if (!(*tile_surface))
 		return;
 
-	Rect bounds(0, 0, map_size.x, map_size.y);
-	updateIso(collider, tile_surface, zoom, &bounds);
-}
-
-void MenuMiniMap::updateIso(MapCollision *collider, Sprite** tile_surface, int zoom, Rect *bounds) {
-
-	if (!(*tile_surface))
-		return;
+	Image* target_img = (*tile_surface)->getGraphics();
 
-	Color draw_color;
-	int tile_type;
+	const int max_size = std::max(map_size.x, map_size.y);
+	const int last_x = area.x + area.w - 1;
+	const int last_y = area.y + area.h - 1;
 
-	Point ent_pos;
-	Image* target_img = (*tile_surface)->getGraphics();
+	// only the pixels covered by the updated tiles are redrawn
+	Rect clip;
+	clip.x = std::max(zoom * (area.x - last_y + max_size - 1), 0);
+	clip.y = std::max((zoom * (area.x + area.y)) - 1, 0);
+	clip.w = std::min(zoom * (last_x - area.y + max_size + 1), target_img->getWidth()) - clip.x;
+	clip.h = std::min((zoom * (last_x + last_y + 1)) - 1, target_img->getHeight()) - clip.y;
 
-	if (bounds->x == 0 && bounds->y == 0 && bounds->w == map_size.x && bounds->h == map_size.y) {
-		target_img->beginPixelBatch();
-	}
-	else {
-		Point hero(pc->stats.pos);
-		Point hero_offset;
-		hero_offset.x = hero.x - hero.y + std::max(map_size.x, map_size.y);
-		hero_offset.y = hero.x + hero.y;
-
-		Rect clip;
-		clip.x = (zoom * hero_offset.x) - pos.w/2;
-		clip.y = (zoom * hero_offset.y) - pos.h/2;
-		clip.w = pos.w;
-		clip.h = pos.h;
-
-		if (clip.x<0) clip.x=0;
-		if (clip.y<0) clip.y=0;
-		if (clip.x + clip.w > target_img->getWidth()) clip.w = target_img->getWidth() - clip.x;
-		if (clip.y + clip.h > target_img->getHeight()) clip.h = target_img->getHeight() - clip.y;
-
-		target_img->beginPixelBatch(clip);
-	}
+	if (clip.w <= 0 || clip.h <= 0)
+		return;
 
-	for (int i=bounds->x; i<bounds->w; i++) {
-		for (int j=bounds->y; j<bounds->h; j++) {
-			tile_type = collider->colmap[i][j];
-			bool draw_tile = true;
+	target_img->beginPixelBatch(clip);
 
-			if (tile_type == 1 || tile_type == 5) draw_color = color_wall;
-			else if (tile_type == 2 || tile_type == 6) draw_color = color_obst;
-			else draw_tile = false;
+	// tiles where x+y is the same share the same rows of pixels, and (x+1, y-1) is drawn right next to (x, y)
+	for (int diagonal = area.x + area.y; diagonal <= last_x + last_y; diagonal++) {
+		const int first_i = std::max(area.x, diagonal - last_y);
+		const int last_i = std::min(last_x, diagonal - area.y);
 
-			// fog of war
-			if (eset->misc.fogofwar > 0) {
-				tile_type = mapr->layers[fow->dark_layer_id][i][j];
-				if (tile_type != 0) draw_tile = false;
-			}
+		int i = first_i;
+		while (i <= last_i) {
+			Color* draw_color = tile_colors[(diagonal - i - area.y) * area.w + (i - area.x)];
 
-			if (draw_tile) {
-				ent_pos.x = zoom*(i - j + std::max(map_size.x, map_size.y));
-				ent_pos.y = zoom*(i + j) - 1;
+			// neighboring tiles of the same color are drawn as one span
+			int span = 1;
+			while (i + span <= last_i && tile_colors[(diagonal - i - span - area.y) * area.w + (i + span - area.x)] == draw_color)
+				span++;
 
+			if (draw_color) {
+				const int j = diagonal - i;
+				const int x = zoom * (i - j + max_size - 1);
+				const int y = (zoom * diagonal) - 1;
 				for (int l = 0; l < zoom; l++) {
-					for (int k = 0; k < zoom; k++) {
-						target_img->drawPixel(ent_pos.x+k, ent_pos.y+l, draw_color);
-						target_img->drawPixel(ent_pos.x+k-zoom, ent_pos.y+l, draw_color);
-					}
+					target_img->drawPixelSpan(x, y + l, 2 * zoom * span, *draw_color);
 				}
 			}
+
+			i += span;
 		}
 	}
 
@@ -508,9 +513,7 @@ void MenuMiniMap::renderEntitiesOrtho(Sprite* entity_surface, int zoom, const Po
 
 	for (size_t i=0; i<entities.size(); i++) {
 		for (int l = 0; l < zoom; l++) {
-			for (int k = 0; k < zoom; k++) {
-				target_img->drawPixel(zoom*entities[i]->x-entity_offset.x+k-1, zoom*entities[i]->y-entity_offset.y+l-1, *entities[i]->color);
-			}
+			target_img->drawPixelSpan(zoom*entities[i]->x-entity_offset.x-1, zoom*entities[i]->y-entity_offset.y+l-1, zoom, *entities[i]->color);
 		}
 	}
 
@@ -536,10 +539,7 @@ void MenuMiniMap::renderEntitiesIso(Sprite* entity_surface, int zoom, const Poin
 		ent_pos.y = zoom*(entities[i]->x + entities[i]->y) - entity_offset.y - 1;
 
 		for (int l = 0; l < zoom; l++) {
-			for (int k = 0; k < zoom; k++) {
-				target_img->drawPixel(ent_pos.x+k, ent_pos.y+l, *entities[i]->color);
-				target_img->drawPixel(ent_pos.x+k-zoom, ent_pos.y+l, *entities[i]->color);
-			}
+			target_img->drawPixelSpan(ent_pos.x-zoom, ent_pos.y+l, 2*zoom, *entities[i]->color);
 		}
 	}
 
@@ -77,12 +77,16 @@ private:
 
 	std::vector<PixelEntity*> entities;
 
+	// the color of each tile in the area being updated (row by row), or NULL if the tile isn't drawn
+	std::vector<Color*> tile_colors;
+
 	void createMapSurface(Sprite** target_surface, int w, int h);
 	void renderMapSurface(const FPoint& hero_pos);
-	void prerenderOrtho(MapCollision *collider, Sprite** tile_surface, Sprite** entity_surface, int zoom);
-	void prerenderIso(MapCollision *collider, Sprite** tile_surface, Sprite** entity_surface, int zoom);
-	void updateIso(MapCollision *collider, Sprite** tile_surface, int zoom, Rect *bounds);
-	void updateOrtho(MapCollision *collider, Sprite** tile_surface, int zoom, Rect *bounds);
+	void prerenderOrtho(Sprite** tile_surface, Sprite** entity_surface, int zoom);
+	void prerenderIso(Sprite** tile_surface, Sprite** entity_surface, int zoom);
+	void fillTileColors(MapCollision *collider, const Rect& area);
+	void updateIso(Sprite** tile_surface, int zoom, const Rect& area);
+	void updateOrtho(Sprite** tile_surface, int zoom, const Rect& area);
 	void renderEntitiesOrtho(Sprite* entity_surface, int zoom, const Point& entity_offset);
 	void renderEntitiesIso(Sprite* entity_surface, int zoom, const Point& entity_offset);
 	void clearEntities();
@@ -99,6 +103,7 @@ public:
 	void render(const FPoint& hero_pos);
 	void prerender(MapCollision *collider, int map_w, int map_h);
 	void setMapTitle(const std::string& map_title);
+	// redraws the tiles from bounds->x/y up to (but not including) bounds->w/h
 	void update(MapCollision *collider, Rect *bounds);
 
 	bool clicked_config;
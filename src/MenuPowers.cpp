@@ -114,6 +114,13 @@ int MenuPowersCellGroup::getBonusLevels() {
 	return blevel;
 }
 
+/**
+ * FNV-1a
+ */
+static void hashUnlockValue(uint32_t& hash, uint32_t value) {
+	hash = (hash ^ value) * 16777619u;
+}
+
 MenuPowers::MenuPowers()
 	: skip_section(false)
 	, points_left(0)
@@ -124,6 +131,7 @@ MenuPowers::MenuPowers()
 	, tree_loaded(false)
 	, default_power_tab(-1)
 	, upgrade_button_offset(eset->resolutions.icon_size, 0)
+	, unlock_state(0)
 	, tooltip_text_shield(msg->get("Magical Shield"))
 	, tooltip_text_heal(msg->get("Healing"))
 	, newPowerNotification(false)
@@ -1474,7 +1482,12 @@ void MenuPowers::logic() {
 		tablist.setNextTabList(&tablist_pow[default_power_tab]);
 	}
 
-	setUnlockedPowers();
+	// checking every cell is expensive, so only do it when something the requirements depend on has changed
+	uint32_t state = getUnlockState();
+	if (state != unlock_state) {
+		unlock_state = state;
+		setUnlockedPowers();
+	}
 
 	points_left = (pc->stats.level * pc->stats.power_points_per_level) - getPointsUsed();
 	if (points_left > 0) {
@@ -1822,6 +1835,39 @@ void MenuPowers::addBonusLevels(PowerID power_index, int bonus_levels) {
 	pgroup->bonus_levels.push_back(bonus);
 }
 
+/**
+ * Hash of everything that checkRequirements() and the passive power checks in setUnlockedPowers() read
+ * Statuses, items and the hero's class come from CampaignManager's change generations
+ */
+uint32_t MenuPowers::getUnlockState() {
+	uint32_t hash = 2166136261u;
+	hashUnlockValue(hash, camp->getGeneration(CampaignManager::CHANGE_STATUS | CampaignManager::CHANGE_ITEMS | CampaignManager::CHANGE_CLASS));
+	hashUnlockValue(hash, pc->stats.level);
+	hashUnlockValue(hash, pc->stats.alive);
+	hashUnlockValue(hash, pc->stats.transformed);
+	hashUnlockValue(hash, pc->stats.effects.stun);
+	hashUnlockValue(hash, static_cast<uint32_t>(pc->stats.powers_list.size()));
+	hashUnlockValue(hash, static_cast<uint32_t>(pc->stats.powers_passive.size()));
+	hashUnlockValue(hash, static_cast<uint32_t>(pc->stats.equip_flags.size()));
+
+	// HP and MP are compared exactly, for power costs and resource states
+	uint32_t bits;
+	memcpy(&bits, &pc->stats.hp, sizeof(bits));
+	hashUnlockValue(hash, bits);
+	memcpy(&bits, &pc->stats.mp, sizeof(bits));
+	hashUnlockValue(hash, bits);
+
+	for (size_t i = 0; i < eset->primary_stats.list.size(); ++i) {
+		hashUnlockValue(hash, pc->stats.get_primary(i));
+	}
+	for (size_t i = 0; i < power_cell.size(); ++i) {
+		hashUnlockValue(hash, power_cell[i].getBonusLevels());
+	}
+
+	// 0 means setUnlockedPowers() hasn't been called by logic() yet
+	return hash == 0 ? 1 : hash;
+}
+
 std::string MenuPowers::getItemBonusPowerReqString(PowerID power_index) {
 	MenuPowersCell* pcell = getCellByPowerIndex(power_index);
 
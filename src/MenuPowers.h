@@ -159,6 +159,9 @@ private:
 
 	std::vector<MenuPowersCell*> recently_locked_cells;
 
+	// getUnlockState() when logic() last called setUnlockedPowers()
+	uint32_t unlock_state;
+
 	std::string tooltip_text_shield;
 	std::string tooltip_text_heal;
 
@@ -189,6 +192,7 @@ public:
 
 	void clearActionBarBonusLevels();
 	void clearBonusLevels();
+	uint32_t getUnlockState();
 	void addBonusLevels(PowerID power_index, int bonus_levels);
 	std::string getItemBonusPowerReqString(PowerID power_index);
 
@@ -186,7 +186,9 @@ void NPCManager::createMapEvent(const NPC& npc, size_t _npcs) {
 
 void NPCManager::logic() {
 	for (unsigned i=0; i<npcs.size(); i++) {
+		FPoint old_pos = npcs[i]->stats.pos;
 		npcs[i]->logic();
+		entitym->entity_grid.update(npcs[i], old_pos);
 	}
 }
 
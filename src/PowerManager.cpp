@@ -173,7 +173,9 @@ Power::Power()
 	, name("")
 	, description("")
 	, attack_anim("")
+	, attack_anim_id(StringTable::EMPTY)
 	, animation_name("")
+	, animation_id(StringTable::EMPTY)
 	, spawn_type("")
 	, script("")
 
@@ -383,6 +385,7 @@ void PowerManager::loadPowers() {
 			else {
 				power->new_state = Power::STATE_ATTACK;
 				power->attack_anim = infile.val;
+				power->attack_anim_id = StringTable::get(infile.val);
 			}
 		}
 		else if (infile.key == "state_duration") {
@@ -663,6 +666,7 @@ void PowerManager::loadPowers() {
 		else if (infile.key == "animation") {
 			// @ATTR power.animation|filename|The filename of the power animation.
 			power->animation_name = infile.val;
+			power->animation_id = StringTable::get(infile.val);
 		}
 		else if (infile.key == "soundfx") {
 			// @ATTR power.soundfx|filename|Filename of a sound effect to play when the power is used.
@@ -1201,9 +1205,9 @@ void PowerManager::loadPowers() {
 			count_allocated++;
 
 		// load animations
-		if (!power->animation_name.empty()) {
-			anim->increaseCount(power->animation_name);
-			power_animations[i] = anim->getAnimationSet(power->animation_name)->getAnimation("");
+		if (power->animation_id != StringTable::EMPTY) {
+			anim->increaseCount(power->animation_id);
+			power_animations[i] = anim->getAnimationSet(power->animation_id)->getAnimation(StringTable::EMPTY);
 		}
 
 		// verify power ids
@@ -1431,8 +1435,8 @@ void PowerManager::initHazard(PowerID power_index, StatBlock *src_stats, const F
 	}
 
 	// animation properties
-	if (haz->power->animation_name != "") {
-		haz->loadAnimation(haz->power->animation_name);
+	if (haz->power->animation_id != StringTable::EMPTY) {
+		haz->loadAnimation(haz->power->animation_id);
 	}
 
 	if (haz->power->directional) {
@@ -2428,8 +2432,8 @@ PowerManager::~PowerManager() {
 		if (!powers[i])
 			continue;
 
-		if (!powers[i]->animation_name.empty()) {
-			anim->decreaseCount(powers[i]->animation_name);
+		if (powers[i]->animation_id != StringTable::EMPTY) {
+			anim->decreaseCount(powers[i]->animation_id);
 		}
 
 		delete powers[i];
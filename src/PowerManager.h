@@ -30,6 +30,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 #include "Map.h"
 #include "MapCollision.h"
+#include "StringTable.h"
 #include "Utils.h"
 
 class Animation;
@@ -310,7 +311,9 @@ public:
 	std::string name;
 	std::string description;
 	std::string attack_anim; // name of the animation to play when using this power, if it is not block
+	StringID attack_anim_id;
 	std::string animation_name;
+	StringID animation_id;
 	std::string spawn_type;
 	std::string script;
 
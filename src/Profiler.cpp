@@ -0,0 +1,269 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "FontEngine.h"
+#include "Profiler.h"
+#include "Settings.h"
+#include "Utils.h"
+#include "UtilsFileSystem.h"
+
+#include <iomanip>
+
+// names of all sections, in the order they were first used
+static std::vector<std::string> section_names;
+
+static std::string escapeJSON(const std::string& s) {
+	std::string result;
+	for (size_t i = 0; i < s.length(); ++i) {
+		if (s[i] == '"' || s[i] == '\\')
+			result += '\\';
+		result += s[i];
+	}
+	return result;
+}
+
+Profiler::Profiler()
+	: show_overlay(false)
+	, frame_section(0)
+	, history_index(0)
+	, frame_start_ticks(SDL_GetPerformanceCounter())
+	, ms_per_tick(1000.0 / static_cast<double>(SDL_GetPerformanceFrequency()))
+	, recording(false)
+	, record_start_ticks(0)
+{
+	frame_section = getSection("Frame");
+	addSections();
+}
+
+Profiler::~Profiler() {
+}
+
+size_t Profiler::getSection(const char* name) {
+	for (size_t i = 0; i < section_names.size(); ++i) {
+		if (section_names[i] == name)
+			return i;
+	}
+
+	section_names.push_back(name);
+	return section_names.size() - 1;
+}
+
+/**
+ * Adds the sections that were named since the last call
+ */
+void Profiler::addSections() {
+	for (size_t i = sections.size(); i < section_names.size(); ++i) {
+		sections.push_back(Section(section_names[i]));
+	}
+}
+
+void Profiler::addTime(size_t section, uint64_t start_ticks, uint64_t end_ticks) {
+	if (section >= sections.size()) {
+		addSections();
+		if (section >= sections.size())
+			return;
+	}
+
+	sections[section].frame_ticks += end_ticks - start_ticks;
+
+	if (recording && trace_events.size() < MAX_TRACE_EVENTS)
+		trace_events.push_back(TraceEvent(section, start_ticks, end_ticks));
+}
+
+void Profiler::endFrame() {
+	uint64_t now = SDL_GetPerformanceCounter();
+	sections[frame_section].frame_ticks = now - frame_start_ticks;
+
+	if (recording) {
+		if (trace_events.size() < MAX_TRACE_EVENTS)
+			trace_events.push_back(TraceEvent(frame_section, frame_start_ticks, now));
+
+		if (recorded_frames.size() < MAX_RECORDED_FRAMES) {
+			recorded_frames.push_back(std::vector<uint64_t>(sections.size(), 0));
+			for (size_t i = 0; i < sections.size(); ++i) {
+				recorded_frames.back()[i] = sections[i].frame_ticks;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < sections.size(); ++i) {
+		sections[i].history[history_index] = sections[i].frame_ticks;
+		sections[i].frame_ticks = 0;
+	}
+	history_index = (history_index + 1) % HISTORY_SIZE;
+
+	frame_start_ticks = now;
+}
+
+/**
+ * Draws one line per section along the right edge of the screen
+ */
+void Profiler::render() {
+	if (!show_overlay)
+		return;
+
+	const int x = settings->view_w - font->getLineHeight();
+	int y = font->getLineHeight() * 2;
+
+	std::string title = "Profiler (ms, average / max)";
+	if (recording)
+		title += " [REC]";
+	font->renderShadowed(title, x, y, FontEngine::JUSTIFY_RIGHT, NULL, 0, font->getColor(FontEngine::COLOR_WHITE));
+	y += font->getLineHeight();
+
+	for (size_t i = 0; i < sections.size(); ++i) {
+		uint64_t total = 0;
+		uint64_t worst = 0;
+		for (size_t j = 0; j < HISTORY_SIZE; ++j) {
+			total += sections[i].history[j];
+			worst = std::max(worst, sections[i].history[j]);
+		}
+
+		float average_ms = static_cast<float>(ticksToMs(total) / static_cast<double>(HISTORY_SIZE));
+		float worst_ms = static_cast<float>(ticksToMs(worst));
+		std::string line = sections[i].name + ": " + Utils::floatToString(average_ms, 2) + " / " + Utils::floatToString(worst_ms, 2);
+
+		font->renderShadowed(line, x, y, FontEngine::JUSTIFY_RIGHT, NULL, 0, font->getColor(FontEngine::COLOR_WHITE));
+		y += font->getLineHeight();
+	}
+}
+
+void Profiler::startRecording() {
+	recorded_frames.clear();
+	trace_events.clear();
+	record_start_ticks = SDL_GetPerformanceCounter();
+	recording = true;
+}
+
+bool Profiler::stopRecording(const std::string& csv_filename, const std::string& trace_filename) {
+	recording = false;
+
+	bool success = writeCSV(csv_filename);
+	success = writeTrace(trace_filename) && success;
+
+	if (trace_events.size() >= MAX_TRACE_EVENTS)
+		Utils::logInfo("Profiler: The trace was cut off after %u events.", static_cast<unsigned>(MAX_TRACE_EVENTS));
+	if (recorded_frames.size() >= MAX_RECORDED_FRAMES)
+		Utils::logInfo("Profiler: The recording was cut off after %u frames.", static_cast<unsigned>(MAX_RECORDED_FRAMES));
+
+	recorded_frames.clear();
+	trace_events.clear();
+	return success;
+}
+
+bool Profiler::isRecording() const {
+	return recording;
+}
+
+void Profiler::logSummary() const {
+	if (recorded_frames.empty()) {
+		Utils::logInfo("Profiler: No frames were recorded.");
+		return;
+	}
+
+	const size_t frame_count = recorded_frames.size();
+	Utils::logInfo("Profiler: %u frames (ms per frame: average, median, 95th percentile, max)", static_cast<unsigned>(frame_count));
+
+	std::vector<uint64_t> samples(frame_count);
+	for (size_t i = 0; i < sections.size(); ++i) {
+		uint64_t total = 0;
+		for (size_t j = 0; j < frame_count; ++j) {
+			samples[j] = (i < recorded_frames[j].size()) ? recorded_frames[j][i] : 0;
+			total += samples[j];
+		}
+		std::sort(samples.begin(), samples.end());
+
+		double average_ms = ticksToMs(total) / static_cast<double>(frame_count);
+		double median_ms = ticksToMs(samples[frame_count / 2]);
+		double p95_ms = ticksToMs(samples[std::min(frame_count - 1, (frame_count * 95) / 100)]);
+		double max_ms = ticksToMs(samples.back());
+
+		Utils::logInfo("Profiler: %-32s %8.3f %8.3f %8.3f %8.3f", sections[i].name.c_str(), average_ms, median_ms, p95_ms, max_ms);
+	}
+}
+
+double Profiler::ticksToMs(uint64_t ticks) const {
+	return static_cast<double>(ticks) * ms_per_tick;
+}
+
+/**
+ * One row per frame, one column per section
+ */
+bool Profiler::writeCSV(const std::string& filename) {
+	std::ofstream outfile(Filesystem::convertSlashes(filename).c_str(), std::ios::out);
+	if (!outfile.is_open()) {
+		Utils::logError("Profiler: Could not write '%s'.", filename.c_str());
+		return false;
+	}
+
+	outfile << "frame";
+	for (size_t i = 0; i < sections.size(); ++i) {
+		outfile << "," << sections[i].name;
+	}
+	outfile << "\n";
+
+	outfile << std::fixed << std::setprecision(3);
+	for (size_t i = 0; i < recorded_frames.size(); ++i) {
+		outfile << i;
+		for (size_t j = 0; j < sections.size(); ++j) {
+			// sections that were added later are empty in earlier frames
+			uint64_t ticks = (j < recorded_frames[i].size()) ? recorded_frames[i][j] : 0;
+			outfile << "," << ticksToMs(ticks);
+		}
+		outfile << "\n";
+	}
+
+	bool success = outfile.good();
+	outfile.close();
+
+	if (success)
+		Utils::logInfo("Profiler: Wrote %u frames to '%s'.", static_cast<unsigned>(recorded_frames.size()), filename.c_str());
+	return success;
+}
+
+/**
+ * Chrome trace event format. Each scope is a "complete" event; nesting is shown based on the times alone
+ */
+bool Profiler::writeTrace(const std::string& filename) {
+	std::ofstream outfile(Filesystem::convertSlashes(filename).c_str(), std::ios::out);
+	if (!outfile.is_open()) {
+		Utils::logError("Profiler: Could not write '%s'.", filename.c_str());
+		return false;
+	}
+
+	const double us_per_tick = ms_per_tick * 1000.0;
+
+	outfile << std::fixed << std::setprecision(3);
+	outfile << "{\"traceEvents\":[\n";
+	for (size_t i = 0; i < trace_events.size(); ++i) {
+		const TraceEvent& event = trace_events[i];
+		double ts = static_cast<double>(event.start_ticks - record_start_ticks) * us_per_tick;
+		double dur = static_cast<double>(event.end_ticks - event.start_ticks) * us_per_tick;
+
+		outfile << "{\"name\":\"" << escapeJSON(sections[event.section].name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1";
+		outfile << ",\"ts\":" << ts << ",\"dur\":" << dur << "}";
+		if (i + 1 < trace_events.size())
+			outfile << ",";
+		outfile << "\n";
+	}
+	outfile << "]}\n";
+
+	bool success = outfile.good();
+	outfile.close();
+
+	if (success)
+		Utils::logInfo("Profiler: Wrote %u trace events to '%s'.", static_cast<unsigned>(trace_events.size()), filename.c_str());
+	return success;
+}
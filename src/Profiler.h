@@ -0,0 +1,122 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class Profiler
+ *
+ * Measures how long each part of a frame takes. Put PROFILE_SCOPE("Name") at the start of a block, and the time
+ * until the end of that block is added to the "Name" section for the current frame. Scopes may be nested.
+ *
+ * The overlay shows the average and worst time of every section over the last HISTORY_SIZE frames. While recording,
+ * every frame is also kept so it can be written out as CSV (one row per frame) and as a Chrome trace (one event per
+ * scope, for chrome://tracing or Perfetto).
+ *
+ * Only use PROFILE_SCOPE on the main thread. Building with FLARE_NO_PROFILER defined removes all scopes.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include "CommonIncludes.h"
+#include "SharedResources.h"
+
+class Profiler {
+public:
+	// number of frames the overlay averages over
+	static const size_t HISTORY_SIZE = 120;
+
+	// stop adding trace events and frames beyond these, so a long recording can't use up all memory
+	static const size_t MAX_TRACE_EVENTS = 1000000;
+	static const size_t MAX_RECORDED_FRAMES = 108000; // 30 minutes at 60 fps
+
+	Profiler();
+	~Profiler();
+
+	// returns the index of the section with this name, adding it if needed
+	// indexes are shared by all profilers, so they stay valid when the profiler is recreated (e.g. on a soft reset)
+	static size_t getSection(const char* name);
+
+	void addTime(size_t section, uint64_t start_ticks, uint64_t end_ticks);
+	void endFrame();
+	void render();
+
+	void startRecording();
+	// writes the recorded frames and stops recording. Returns false if a file could not be written
+	bool stopRecording(const std::string& csv_filename, const std::string& trace_filename);
+	bool isRecording() const;
+	// logs the average, median, 95th percentile and worst time of each section over the recorded frames
+	void logSummary() const;
+
+	bool show_overlay;
+
+private:
+	class Section {
+	public:
+		std::string name;
+		uint64_t frame_ticks; // time spent in this section during the current frame
+		std::vector<uint64_t> history;
+		explicit Section(const std::string& _name) : name(_name), frame_ticks(0), history(HISTORY_SIZE, 0) {}
+	};
+
+	class TraceEvent {
+	public:
+		size_t section;
+		uint64_t start_ticks;
+		uint64_t end_ticks;
+		TraceEvent(size_t _section, uint64_t _start_ticks, uint64_t _end_ticks) : section(_section), start_ticks(_start_ticks), end_ticks(_end_ticks) {}
+	};
+
+	void addSections();
+	double ticksToMs(uint64_t ticks) const;
+	bool writeCSV(const std::string& filename);
+	bool writeTrace(const std::string& filename);
+
+	std::vector<Section> sections;
+	size_t frame_section; // the whole frame, from one endFrame() to the next
+	size_t history_index;
+	uint64_t frame_start_ticks;
+	double ms_per_tick;
+
+	bool recording;
+	uint64_t record_start_ticks;
+	std::vector< std::vector<uint64_t> > recorded_frames; // ticks of each section, per frame
+	std::vector<TraceEvent> trace_events;
+};
+
+/**
+ * Adds the time from construction to destruction to a section
+ */
+class ProfilerScope {
+public:
+	explicit ProfilerScope(size_t _section) : section(_section), start_ticks(SDL_GetPerformanceCounter()) {}
+	~ProfilerScope() { profiler->addTime(section, start_ticks, SDL_GetPerformanceCounter()); }
+private:
+	size_t section;
+	uint64_t start_ticks;
+};
+
+#define PROFILER_JOIN_INNER(a, b) a##b
+#define PROFILER_JOIN(a, b) PROFILER_JOIN_INNER(a, b)
+
+#ifdef FLARE_NO_PROFILER
+#define PROFILE_SCOPE(name)
+#else
+// the section is looked up once per call site
+#define PROFILE_SCOPE(name) \
+	static const size_t PROFILER_JOIN(profiler_section_, __LINE__) = Profiler::getSection(name); \
+	ProfilerScope PROFILER_JOIN(profiler_scope_, __LINE__)(PROFILER_JOIN(profiler_section_, __LINE__))
+#endif
+
+#endif // PROFILER_H
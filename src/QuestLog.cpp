@@ -38,7 +38,8 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "UtilsFileSystem.h"
 #include "UtilsParsing.h"
 
-QuestLog::QuestLog(MenuLog *_log) {
+QuestLog::QuestLog(MenuLog *_log)
+	: requirements_generation(0) {
 	log = _log;
 
 	newQuestNotification = false;
@@ -161,7 +162,9 @@ void QuestLog::load(const std::string& filename) {
 }
 
 void QuestLog::logic() {
-	createQuestList();
+	// quests can only become active or complete when a requirement changes
+	if (camp->getGeneration(CampaignManager::CHANGE_REQUIREMENTS) != requirements_generation)
+		createQuestList();
 }
 
 /**
@@ -171,6 +174,8 @@ void QuestLog::createQuestList() {
 	std::vector<size_t> temp_quest_ids;
 	std::vector<size_t> temp_complete_quest_ids;
 
+	requirements_generation = camp->getGeneration(CampaignManager::CHANGE_REQUIREMENTS);
+
 	// check quest requirements
 	for (size_t i=0; i<quest_sections.size(); i++) {
 		if (camp->checkRequirementsInVector(quest_sections[i])) {
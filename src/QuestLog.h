@@ -48,6 +48,9 @@ private:
 	std::vector<size_t> complete_quest_ids;
 	std::vector<Quest> quests;
 
+	// CampaignManager::getGeneration() when the quest list was last created
+	unsigned requirements_generation;
+
 public:
 	explicit QuestLog(MenuLog *_log);
 	~QuestLog();
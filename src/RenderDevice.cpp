@@ -68,6 +68,12 @@ Sprite *Image::createSprite() {
 	return sprite;
 }
 
+void Image::drawPixelSpan(int x, int y, int w, const Color& color) {
+	for (int i = 0; i < w; ++i) {
+		drawPixel(x + i, y, color);
+	}
+}
+
 void Image::beginPixelBatch() {
 }
 
@@ -78,6 +84,10 @@ void Image::beginPixelBatch(Rect& bounds) {
 void Image::endPixelBatch() {
 }
 
+bool Image::usePremultipliedAlpha() {
+	return false;
+}
+
 
 /*
  * Sprite
@@ -173,6 +183,8 @@ RenderDevice::RenderDevice()
 	, is_initialized(false)
 	, reload_graphics(false)
 	, ddpi(0)
+	, draw_calls(0)
+	, last_draw_calls(0)
 {
 }
 
@@ -318,6 +330,10 @@ bool RenderDevice::reloadGraphics() {
 	return false;
 }
 
+unsigned RenderDevice::getDrawCallCount() const {
+	return last_draw_calls;
+}
+
 void RenderDevice::freeImage(Image *image) {
 	if (!image) return;
 
@@ -113,11 +113,16 @@ public:
 
 	virtual void fillWithColor(const Color& color) = 0;
 	virtual void drawPixel(int x, int y, const Color& color) = 0;
+	// sets w pixels in a row, starting at (x, y)
+	virtual void drawPixelSpan(int x, int y, int w, const Color& color);
 	virtual void drawLine(int x0, int y0, int x1, int y1, const Color& color) = 0;
 	virtual void drawFilledRect(int x, int y, int w, int h, const Color& color) = 0;
 	virtual void beginPixelBatch();
 	virtual void beginPixelBatch(Rect& bounds);
 	virtual void endPixelBatch();
+	// call after drawing onto a transparent image with renderToImage(), which leaves colors multiplied by alpha.
+	// Returns false if the image can't be drawn correctly afterwards
+	virtual bool usePremultipliedAlpha();
 	virtual Image* resize(int width, int height) = 0;
 
 	class Sprite *createSprite();
@@ -178,20 +183,16 @@ class QueuedImage {
 public:
 	void* surface;
 	int error_type;
-	bool load_attempted;
 	std::string filename;
 	std::string loc_filename;
-	SDL_mutex* mutex;
-	SDL_cond* loaded;
+	std::string load_error; // set by the loading thread, since SDL errors are per-thread
 
 	QueuedImage()
 		: surface(NULL)
 		, error_type(0)
-		, load_attempted(false)
 		, filename()
 		, loc_filename()
-		, mutex(NULL)
-		, loaded(NULL)
+		, load_error()
 	{}
 };
 
@@ -258,6 +259,9 @@ public:
 
 	bool reloadGraphics();
 
+	/** the number of draw calls sent to the screen during the last frame */
+	unsigned getDrawCallCount() const;
+
 	void pushQueuedImage(const std::string& filename, int error_type);
 	virtual void loadQueuedImages() = 0;
 	void cleanupQueuedImages();
@@ -296,6 +300,10 @@ protected:
 	std::vector<QueuedImage> image_queue;
 	std::vector<Image*> image_queue_cleanup;
 
+	/* Draw calls of the current frame. Moved to last_draw_calls by commitFrame() */
+	unsigned draw_calls;
+	unsigned last_draw_calls;
+
 private:
 	typedef std::map<std::string, Image *> IMAGE_CACHE_CONTAINER;
 	typedef IMAGE_CACHE_CONTAINER::iterator IMAGE_CACHE_CONTAINER_ITER;
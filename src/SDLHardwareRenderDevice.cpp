@@ -34,39 +34,102 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Platform.h"
 #include "SharedResources.h"
 #include "Settings.h"
+#include "ThreadPool.h"
 
 #include "SDLHardwareRenderDevice.h"
 #include "SDLFontEngine.h"
 
+/**
+ * Orders indexes into the image queue by image height, tallest first
+ */
+class AtlasSortByHeight {
+public:
+	explicit AtlasSortByHeight(const std::vector<QueuedImage>* _queue) : queue(_queue) {}
+
+	bool operator()(size_t a, size_t b) const {
+		return static_cast<SDL_Surface*>((*queue)[a].surface)->h > static_cast<SDL_Surface*>((*queue)[b].surface)->h;
+	}
+
+private:
+	const std::vector<QueuedImage>* queue;
+};
+
 SDLHardwareImage::SDLHardwareImage(RenderDevice *_device, SDL_Renderer *_renderer)
 	: Image(_device)
 	, renderer(_renderer)
 	, surface(NULL)
+	, atlas_page(NULL)
+	, atlas_rect()
 	, pixel_batch_surface(NULL)
 	, pixel_batch_type(PIXEL_BATCH_NONE) {
 }
 
 SDLHardwareImage::~SDLHardwareImage() {
-	if (surface)
+	// queued draws might still use this texture
+	static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
+
+	if (atlas_page)
+		atlas_page->unref();
+	else if (surface)
 		SDL_DestroyTexture(surface);
 	if (pixel_batch_surface)
 		SDL_FreeSurface(pixel_batch_surface);
 }
 
 int SDLHardwareImage::getWidth() const {
+	if (atlas_page)
+		return atlas_rect.w;
+
 	int w, h;
 	SDL_QueryTexture(surface, NULL, NULL, &w, &h);
 	return (surface ? w : 0);
 }
 
 int SDLHardwareImage::getHeight() const {
+	if (atlas_page)
+		return atlas_rect.h;
+
 	int w, h;
 	SDL_QueryTexture(surface, NULL, NULL, &w, &h);
 	return (surface ? h : 0);
 }
 
+/**
+ * Copies this image out of its atlas page. Drawing to the shared texture would also change the other images on it
+ */
+bool SDLHardwareImage::detachFromAtlas() {
+	if (!atlas_page)
+		return true;
+
+	SDL_Texture *copy = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, atlas_rect.w, atlas_rect.h);
+	if (!copy) {
+		Utils::logError("SDLHardwareImage: Couldn't copy image from atlas: %s", SDL_GetError());
+		return false;
+	}
+
+	static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
+
+	SDL_Rect src = atlas_rect;
+	SDL_SetRenderTarget(renderer, copy);
+	SDL_SetTextureBlendMode(copy, SDL_BLENDMODE_BLEND);
+	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_NONE);
+	SDL_SetTextureColorMod(surface, 255, 255, 255);
+	SDL_SetTextureAlphaMod(surface, 255);
+	SDL_RenderCopy(renderer, surface, &src, NULL);
+	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
+	SDL_SetRenderTarget(renderer, NULL);
+
+	surface = copy;
+	atlas_page->unref();
+	atlas_page = NULL;
+	atlas_rect = Rect();
+	return true;
+}
+
 void SDLHardwareImage::fillWithColor(const Color& color) {
-	if (!surface) return;
+	if (!surface || !detachFromAtlas()) return;
+
+	static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 
 	SDL_SetRenderTarget(renderer, surface);
 	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
@@ -104,6 +167,9 @@ void SDLHardwareImage::drawPixel(int x, int y, const Color& color) {
 }
 
 void SDLHardwareImage::drawPixelSingle(int x, int y, const Color& color) {
+	if (!detachFromAtlas()) return;
+
+	static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 	SDL_SetRenderTarget(renderer, surface);
 	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
@@ -152,7 +218,74 @@ void SDLHardwareImage::drawPixelBatch(int x, int y, const Color& color) {
 	}
 }
 
+/*
+ * Set w pixels in a row, starting at (x, y)
+ */
+void SDLHardwareImage::drawPixelSpan(int x, int y, int w, const Color& color) {
+	if (!surface) return;
+
+	if (y < 0 || y >= getHeight())
+		return;
+
+	// clip the span to the image
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (x + w > getWidth())
+		w = getWidth() - x;
+	if (w <= 0)
+		return;
+
+	switch (pixel_batch_type) {
+		case PIXEL_BATCH_NONE:
+			drawFilledRect(x, y, w, 1, color);
+			break;
+		case PIXEL_BATCH_AREA:
+			if (y < pixel_batch_area.y || y > pixel_batch_area.y + pixel_batch_area.h - 1) return;
+			if (x < pixel_batch_area.x) {
+				w -= pixel_batch_area.x - x;
+				x = pixel_batch_area.x;
+			}
+			if (x + w > pixel_batch_area.x + pixel_batch_area.w)
+				w = pixel_batch_area.x + pixel_batch_area.w - x;
+			if (w <= 0) return;
+			drawPixelSpanBatch(x - pixel_batch_area.x, y - pixel_batch_area.y, w, color);
+			break;
+		case PIXEL_BATCH_ALL:
+			drawPixelSpanBatch(x, y, w, color);
+			break;
+	}
+}
+
+void SDLHardwareImage::drawPixelSpanBatch(int x, int y, int w, const Color& color) {
+	int bpp = pixel_batch_surface->format->BytesPerPixel;
+	if (bpp != 4) {
+		for (int i = 0; i < w; ++i) {
+			drawPixelBatch(x + i, y, color);
+		}
+		return;
+	}
+
+	Uint32 pixel = SDL_MapRGBA(pixel_batch_surface->format, color.r, color.g, color.b, color.a);
+
+	if (SDL_MUSTLOCK(pixel_batch_surface)) {
+		SDL_LockSurface(pixel_batch_surface);
+	}
+
+	// one plain fill per span, which the compiler can vectorize
+	Uint32 *p = reinterpret_cast<Uint32*>(static_cast<Uint8*>(pixel_batch_surface->pixels) + y * pixel_batch_surface->pitch) + x;
+	std::fill_n(p, w, pixel);
+
+	if (SDL_MUSTLOCK(pixel_batch_surface)) {
+		SDL_UnlockSurface(pixel_batch_surface);
+	}
+}
+
 void SDLHardwareImage::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
+	if (!detachFromAtlas()) return;
+
+	static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 	SDL_SetRenderTarget(renderer, surface);
 	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
@@ -167,6 +300,9 @@ void SDLHardwareImage::drawFilledRect(int x, int y, int w, int h, const Color& c
 	rect.w = w;
 	rect.h = h;
 
+	if (!detachFromAtlas()) return;
+
+	static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 	SDL_SetRenderTarget(renderer, surface);
 	SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
@@ -216,9 +352,17 @@ void SDLHardwareImage::beginPixelBatch(Rect& bounds) {
 void SDLHardwareImage::endPixelBatch() {
 	if (!surface || !pixel_batch_surface) return;
 
+	if (!detachFromAtlas()) {
+		SDL_FreeSurface(pixel_batch_surface);
+		pixel_batch_surface = NULL;
+		pixel_batch_type = PIXEL_BATCH_NONE;
+		return;
+	}
+
 	SDL_Texture *pixel_batch_texture = SDL_CreateTextureFromSurface(renderer, pixel_batch_surface);
 
 	if (pixel_batch_texture) {
+		static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 		SDL_SetRenderTarget(renderer, surface);
 		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
 
@@ -238,6 +382,21 @@ void SDLHardwareImage::endPixelBatch() {
 	pixel_batch_type = PIXEL_BATCH_NONE;
 }
 
+/**
+ * Draws the texture with a blend mode for colors that are already multiplied by alpha
+ */
+bool SDLHardwareImage::usePremultipliedAlpha() {
+#if SDL_VERSION_ATLEAST(2, 0, 6)
+	if (!surface || atlas_page)
+		return false;
+
+	SDL_BlendMode blend_mode = SDL_ComposeCustomBlendMode(SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD, SDL_BLENDFACTOR_ONE, SDL_BLENDFACTOR_ONE_MINUS_SRC_ALPHA, SDL_BLENDOPERATION_ADD);
+	return SDL_SetTextureBlendMode(surface, blend_mode) == 0;
+#else
+	return false;
+#endif
+}
+
 Image* SDLHardwareImage::resize(int width, int height) {
 	if(!surface || width <= 0 || height <= 0)
 		return NULL;
@@ -249,8 +408,15 @@ Image* SDLHardwareImage::resize(int width, int height) {
 
 	if (scaled->surface != NULL) {
 		// copy the source texture to the new texture, stretching it in the process
+		static_cast<SDLHardwareRenderDevice *>(device)->flushBatch();
 		SDL_SetRenderTarget(renderer, scaled->surface);
-		SDL_RenderCopyEx(renderer, surface, NULL, NULL, 0, NULL, SDL_FLIP_NONE);
+		if (atlas_page) {
+			SDL_Rect src = atlas_rect;
+			SDL_RenderCopyEx(renderer, surface, &src, NULL, 0, NULL, SDL_FLIP_NONE);
+		}
+		else {
+			SDL_RenderCopyEx(renderer, surface, NULL, NULL, 0, NULL, SDL_FLIP_NONE);
+		}
 		SDL_SetRenderTarget(renderer, NULL);
 
 		// Remove the old surface
@@ -271,6 +437,12 @@ SDLHardwareRenderDevice::SDLHardwareRenderDevice()
 	, titlebar_icon(NULL)
 	, title(NULL)
 	, background_color(0,0,0,255)
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	, batch_texture(NULL)
+	, batch_blend_mode(SDL_BLENDMODE_NONE)
+	, batch_texture_w(0)
+	, batch_texture_h(0)
+#endif
 {
 	Utils::logInfo("Using Render Device: SDLHardwareRenderDevice (hardware, SDL 2, %s)", SDL_GetCurrentVideoDriver());
 
@@ -443,21 +615,22 @@ int SDLHardwareRenderDevice::render(Renderable& r, Rect& dest) {
 	dest.h = r.src.h;
     SDL_Rect src = r.src;
     SDL_Rect _dest = dest;
-	SDL_SetRenderTarget(renderer, texture);
 
-	SDL_Texture *surface = static_cast<SDLHardwareImage *>(r.image)->surface;
+	SDLHardwareImage *image = static_cast<SDLHardwareImage *>(r.image);
+	if (!mapAtlasRect(image, src, _dest))
+		return 0;
+
+	SDL_Texture *surface = image->surface;
 
+	SDL_BlendMode blend_mode;
 	if (r.blend_mode == Renderable::BLEND_ADD) {
-		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_ADD);
+		blend_mode = SDL_BLENDMODE_ADD;
 	}
 	else { // Renderable::BLEND_NORMAL
-		SDL_SetTextureBlendMode(surface, SDL_BLENDMODE_BLEND);
+		blend_mode = SDL_BLENDMODE_BLEND;
 	}
 
-	SDL_SetTextureColorMod(surface, r.color_mod.r, r.color_mod.g, r.color_mod.b);
-	SDL_SetTextureAlphaMod(surface, r.alpha_mod);
-
-	return SDL_RenderCopy(renderer, surface, &src, &_dest);
+	return drawTexture(surface, blend_mode, src, _dest, r.color_mod, r.alpha_mod);
 }
 
 int SDLHardwareRenderDevice::render(Sprite *r) {
@@ -486,19 +659,177 @@ int SDLHardwareRenderDevice::render(Sprite *r) {
 
     SDL_Rect src = m_clip;
     SDL_Rect dest = m_dest;
+
+	SDLHardwareImage *image = static_cast<SDLHardwareImage *>(r->getGraphics());
+	if (!mapAtlasRect(image, src, dest))
+		return 0;
+
+	SDL_Texture *surface = image->surface;
+
+	// sprites keep whatever blend mode their texture has
+	// atlas pages are shared with animations that change the blend mode, but they always have an alpha channel
+	SDL_BlendMode blend_mode = SDL_BLENDMODE_BLEND;
+	if (!image->atlas_page)
+		SDL_GetTextureBlendMode(surface, &blend_mode);
+
+	return drawTexture(surface, blend_mode, src, dest, r->color_mod, r->alpha_mod);
+}
+
+/**
+ * Moves src from image coordinates to atlas page coordinates, cutting off anything outside of the image
+ * dest is cut off by the same amount. Returns false if nothing is left to draw
+ */
+bool SDLHardwareRenderDevice::mapAtlasRect(SDLHardwareImage *image, SDL_Rect& src, SDL_Rect& dest) {
+	if (!image->atlas_page)
+		return true;
+
+	if (src.x < 0) {
+		dest.x -= src.x;
+		src.w += src.x;
+		dest.w += src.x;
+		src.x = 0;
+	}
+	if (src.y < 0) {
+		dest.y -= src.y;
+		src.h += src.y;
+		dest.h += src.y;
+		src.y = 0;
+	}
+	src.w = std::min(src.w, image->atlas_rect.w - src.x);
+	src.h = std::min(src.h, image->atlas_rect.h - src.y);
+	if (src.w <= 0 || src.h <= 0)
+		return false;
+
+	dest.w = std::min(dest.w, src.w);
+	dest.h = std::min(dest.h, src.h);
+
+	src.x += image->atlas_rect.x;
+	src.y += image->atlas_rect.y;
+	return true;
+}
+
+/**
+ * Draws part of a texture to the screen. If possible, the draw is queued and merged with the draws before it
+ */
+int SDLHardwareRenderDevice::drawTexture(SDL_Texture *surface, SDL_BlendMode blend_mode, const SDL_Rect& src, const SDL_Rect& dest, const Color& color_mod, uint8_t alpha_mod) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	if (!surface)
+		return -1;
+
+	if (surface != batch_texture || blend_mode != batch_blend_mode) {
+		flushBatch();
+
+		int w, h;
+		if (SDL_QueryTexture(surface, NULL, NULL, &w, &h) != 0 || w <= 0 || h <= 0)
+			return -1;
+
+		batch_texture = surface;
+		batch_blend_mode = blend_mode;
+		batch_texture_w = static_cast<float>(w);
+		batch_texture_h = static_cast<float>(h);
+	}
+
+	// like SDL_RenderCopy(), only draw the part of src that is inside the texture
+	SDL_Rect clip = src;
+	SDL_Rect pos = dest;
+	if (clip.x < 0) {
+		pos.x -= clip.x;
+		clip.w += clip.x;
+		clip.x = 0;
+	}
+	if (clip.y < 0) {
+		pos.y -= clip.y;
+		clip.h += clip.y;
+		clip.y = 0;
+	}
+	clip.w = std::min(clip.w, static_cast<int>(batch_texture_w) - clip.x);
+	clip.h = std::min(clip.h, static_cast<int>(batch_texture_h) - clip.y);
+	if (clip.w <= 0 || clip.h <= 0 || pos.w <= 0 || pos.h <= 0)
+		return 0;
+	pos.w = std::min(pos.w, clip.w);
+	pos.h = std::min(pos.h, clip.h);
+
+	SDL_Color color;
+	color.r = color_mod.r;
+	color.g = color_mod.g;
+	color.b = color_mod.b;
+	color.a = alpha_mod;
+
+	const float x0 = static_cast<float>(pos.x);
+	const float y0 = static_cast<float>(pos.y);
+	const float x1 = static_cast<float>(pos.x + pos.w);
+	const float y1 = static_cast<float>(pos.y + pos.h);
+	const float u0 = static_cast<float>(clip.x) / batch_texture_w;
+	const float v0 = static_cast<float>(clip.y) / batch_texture_h;
+	const float u1 = static_cast<float>(clip.x + pos.w) / batch_texture_w;
+	const float v1 = static_cast<float>(clip.y + pos.h) / batch_texture_h;
+
+	const int first = static_cast<int>(batch_vertices.size());
+
+	SDL_Vertex vertex;
+	vertex.color = color;
+
+	vertex.position.x = x0; vertex.position.y = y0; vertex.tex_coord.x = u0; vertex.tex_coord.y = v0;
+	batch_vertices.push_back(vertex);
+	vertex.position.x = x1; vertex.position.y = y0; vertex.tex_coord.x = u1; vertex.tex_coord.y = v0;
+	batch_vertices.push_back(vertex);
+	vertex.position.x = x1; vertex.position.y = y1; vertex.tex_coord.x = u1; vertex.tex_coord.y = v1;
+	batch_vertices.push_back(vertex);
+	vertex.position.x = x0; vertex.position.y = y1; vertex.tex_coord.x = u0; vertex.tex_coord.y = v1;
+	batch_vertices.push_back(vertex);
+
+	batch_indices.push_back(first);
+	batch_indices.push_back(first + 1);
+	batch_indices.push_back(first + 2);
+	batch_indices.push_back(first);
+	batch_indices.push_back(first + 2);
+	batch_indices.push_back(first + 3);
+
+	return 0;
+#else
 	SDL_SetRenderTarget(renderer, texture);
 
-	SDL_Texture *surface = static_cast<SDLHardwareImage *>(r->getGraphics())->surface;
-	SDL_SetTextureColorMod(surface, r->color_mod.r, r->color_mod.g, r->color_mod.b);
-	SDL_SetTextureAlphaMod(surface, r->alpha_mod);
+	SDL_SetTextureBlendMode(surface, blend_mode);
+	SDL_SetTextureColorMod(surface, color_mod.r, color_mod.g, color_mod.b);
+	SDL_SetTextureAlphaMod(surface, alpha_mod);
 
-	return SDL_RenderCopy(renderer, static_cast<SDLHardwareImage *>(r->getGraphics())->surface, &src, &dest);
+	++draw_calls;
+	return SDL_RenderCopy(renderer, surface, &src, &dest);
+#endif
+}
+
+void SDLHardwareRenderDevice::flushBatch() {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	if (batch_indices.empty()) {
+		batch_texture = NULL;
+		return;
+	}
+
+	SDL_SetRenderTarget(renderer, texture);
+
+	// the color and alpha mods are in the vertex colors instead
+	SDL_SetTextureBlendMode(batch_texture, batch_blend_mode);
+	SDL_SetTextureColorMod(batch_texture, 255, 255, 255);
+	SDL_SetTextureAlphaMod(batch_texture, 255);
+
+	SDL_RenderGeometry(renderer, batch_texture, &batch_vertices[0], static_cast<int>(batch_vertices.size()), &batch_indices[0], static_cast<int>(batch_indices.size()));
+	++draw_calls;
+
+	batch_vertices.clear();
+	batch_indices.clear();
+	batch_texture = NULL;
+#endif
 }
 
 int SDLHardwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* dest_image, Rect& dest) {
 	if (!src_image || !dest_image)
 		return -1;
 
+	if (!static_cast<SDLHardwareImage *>(dest_image)->detachFromAtlas())
+		return -1;
+
+	flushBatch();
+
 	if (SDL_SetRenderTarget(renderer, static_cast<SDLHardwareImage *>(dest_image)->surface) != 0)
 		return -1;
 
@@ -507,8 +838,18 @@ int SDLHardwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* d
     SDL_Rect _src = src;
     SDL_Rect _dest = dest;
 
+	if (!mapAtlasRect(static_cast<SDLHardwareImage *>(src_image), _src, _dest)) {
+		SDL_SetRenderTarget(renderer, NULL);
+		return 0;
+	}
+
+	// copy the source as it is, without color/alpha changes left over from render()
+	SDL_Texture *src_surface = static_cast<SDLHardwareImage *>(src_image)->surface;
+	SDL_SetTextureColorMod(src_surface, 255, 255, 255);
+	SDL_SetTextureAlphaMod(src_surface, 255);
+
 	SDL_SetTextureBlendMode(static_cast<SDLHardwareImage *>(dest_image)->surface, SDL_BLENDMODE_BLEND);
-	SDL_RenderCopy(renderer, static_cast<SDLHardwareImage *>(src_image)->surface, &_src, &_dest);
+	SDL_RenderCopy(renderer, src_surface, &_src, &_dest);
 	SDL_SetRenderTarget(renderer, NULL);
 	return 0;
 }
@@ -536,13 +877,19 @@ Image * SDLHardwareRenderDevice::renderTextToImage(FontStyle* font_style, const
 }
 
 void SDLHardwareRenderDevice::drawPixel(int x, int y, const Color& color) {
+	flushBatch();
+	SDL_SetRenderTarget(renderer, texture);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawPoint(renderer, x, y);
+	++draw_calls;
 }
 
 void SDLHardwareRenderDevice::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
+	flushBatch();
+	SDL_SetRenderTarget(renderer, texture);
 	SDL_SetRenderDrawColor(renderer, color.r, color.g, color.b, color.a);
 	SDL_RenderDrawLine(renderer, x0, y0, x1, y1);
+	++draw_calls;
 }
 
 void SDLHardwareRenderDevice::drawRectangle(const Point& p0, const Point& p1, const Color& color) {
@@ -553,6 +900,7 @@ void SDLHardwareRenderDevice::drawRectangle(const Point& p0, const Point& p1, co
 }
 
 void SDLHardwareRenderDevice::blankScreen() {
+	flushBatch();
 	SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
 	SDL_SetRenderTarget(renderer, NULL);
 	SDL_RenderClear(renderer);
@@ -563,15 +911,22 @@ void SDLHardwareRenderDevice::blankScreen() {
 }
 
 void SDLHardwareRenderDevice::commitFrame() {
+	flushBatch();
+
 	SDL_SetRenderTarget(renderer, NULL);
 	SDL_RenderCopy(renderer, texture, NULL, NULL);
 	SDL_RenderPresent(renderer);
 	inpt->window_resized = false;
 
+	last_draw_calls = draw_calls;
+	draw_calls = 0;
+
 	return;
 }
 
 void SDLHardwareRenderDevice::destroyContext() {
+	flushBatch();
+
 	resetGamma();
 
 	// we need to free all loaded graphics as they may be tied to the current context
@@ -622,6 +977,7 @@ Image *SDLHardwareRenderDevice::createImage(int width, int height) {
 			image = NULL;
 		}
 		else {
+				flushBatch();
 				SDL_SetRenderTarget(renderer, image->surface);
 				SDL_SetTextureBlendMode(image->surface, SDL_BLENDMODE_BLEND);
 				SDL_SetRenderDrawColor(renderer, 0,0,0,0);
@@ -697,6 +1053,8 @@ void SDLHardwareRenderDevice::getWindowSize(short unsigned *screen_w, short unsi
 }
 
 void SDLHardwareRenderDevice::windowResize() {
+	flushBatch();
+
 	windowResizeInternal();
 
 	SDL_RenderSetLogicalSize(renderer, settings->view_w, settings->view_h);
@@ -750,37 +1108,41 @@ unsigned short SDLHardwareRenderDevice::getRefreshRate() {
 	return static_cast<unsigned short>(mode.refresh_rate);
 }
 
-int SDLHardwareRenderDevice::loadQueuedImage(void* data) {
+void SDLHardwareRenderDevice::loadQueuedImage(void* data) {
 	QueuedImage* image = static_cast<QueuedImage*>(data);
-	SDL_LockMutex(image->mutex);
 	image->surface = IMG_Load(image->loc_filename.c_str());
-	image->load_attempted = true;
-	SDL_CondSignal(image->loaded);
-	SDL_UnlockMutex(image->mutex);
-	return 0;
+	if (!image->surface)
+		image->load_error = IMG_GetError();
 }
 
+/**
+ * Images are decoded on the worker threads. Creating the images from the decoded data is done here afterwards
+ */
 void SDLHardwareRenderDevice::loadQueuedImages() {
-	std::vector<SDL_Thread*> threads(image_queue.size(), NULL);
-
 	for (size_t i = 0; i < image_queue.size(); ++i) {
-		std::string thread_name = "Image queue: " + image_queue[i].filename;
-		image_queue[i].mutex = SDL_CreateMutex();
-		image_queue[i].loaded = SDL_CreateCond();
-		threads[i] = SDL_CreateThread(loadQueuedImage, thread_name.c_str(), &image_queue[i]);
+		thread_pool->submit(loadQueuedImage, &image_queue[i]);
 	}
+	thread_pool->wait();
+
+	std::vector<SDLHardwareImage*> atlas_pages(image_queue.size(), NULL);
+	std::vector<Rect> atlas_rects(image_queue.size());
+	if (settings->texture_atlas)
+		packQueuedImages(atlas_pages, atlas_rects);
 
 	for (size_t i = 0; i < image_queue.size(); ++i) {
-		SDL_LockMutex(image_queue[i].mutex);
 		SDLHardwareImage *image = new SDLHardwareImage(this, renderer);
-		if (!image) return;
 
-		if (!image_queue[i].surface && !image_queue[i].load_attempted) {
-			SDL_CondWait(image_queue[i].loaded, image_queue[i].mutex);
+		if (atlas_pages[i]) {
+			image->surface = atlas_pages[i]->surface;
+			image->atlas_page = atlas_pages[i];
+			image->atlas_rect = atlas_rects[i];
+			SDL_FreeSurface(static_cast<SDL_Surface*>(image_queue[i].surface));
+			image_queue[i].surface = NULL;
 		}
-
-		if (image_queue[i].surface) {
+		else if (image_queue[i].surface) {
 			image->surface = SDL_CreateTextureFromSurface(renderer, static_cast<SDL_Surface*>(image_queue[i].surface));
+			if (!image->surface)
+				image_queue[i].load_error = SDL_GetError();
 			SDL_FreeSurface(static_cast<SDL_Surface*>(image_queue[i].surface));
 			image_queue[i].surface = NULL;
 		}
@@ -788,10 +1150,10 @@ void SDLHardwareRenderDevice::loadQueuedImages() {
 		if(image->surface == NULL) {
 			delete image;
 			if (image_queue[i].error_type != ERROR_NONE)
-				Utils::logError("SDLHardwareRenderDevice: Couldn't load image: '%s'. %s", image_queue[i].filename.c_str(), IMG_GetError());
+				Utils::logError("SDLHardwareRenderDevice: Couldn't load image: '%s'. %s", image_queue[i].filename.c_str(), image_queue[i].load_error.c_str());
 
 			if (image_queue[i].error_type == ERROR_EXIT) {
-				Utils::logErrorDialog("SDLHardwareRenderDevice: Couldn't load image: '%s'.\n%s", image_queue[i].filename.c_str(), IMG_GetError());
+				Utils::logErrorDialog("SDLHardwareRenderDevice: Couldn't load image: '%s'.\n%s", image_queue[i].filename.c_str(), image_queue[i].load_error.c_str());
 				mods->resetModConfig();
 				Utils::Exit(1);
 			}
@@ -801,19 +1163,135 @@ void SDLHardwareRenderDevice::loadQueuedImages() {
 			cacheStore(image_queue[i].filename, image);
 			image_queue_cleanup.push_back(static_cast<Image*>(image));
 		}
+	}
 
-		SDL_UnlockMutex(image_queue[i].mutex);
+	image_queue.clear();
+}
 
-		SDL_DestroyMutex(image_queue[i].mutex);
-		SDL_DestroyCond(image_queue[i].loaded);
-		image_queue[i].mutex = NULL;
-		image_queue[i].loaded = NULL;
+/**
+ * Packs the decoded images from the queue into as few textures as possible, so that drawing them needs fewer texture switches
+ * Images are placed on shelves: left to right in rows, with each row as tall as its first (tallest) image
+ * For each queued image that was packed, atlas_pages gets the page (holding one reference for the image) and atlas_rects its position
+ */
+void SDLHardwareRenderDevice::packQueuedImages(std::vector<SDLHardwareImage*>& atlas_pages, std::vector<Rect>& atlas_rects) {
+	int page_w = ATLAS_PAGE_SIZE;
+	int page_h = ATLAS_PAGE_SIZE;
+
+	SDL_RendererInfo renderer_info;
+	if (SDL_GetRendererInfo(renderer, &renderer_info) == 0) {
+		if (renderer_info.max_texture_width > 0)
+			page_w = std::min(page_w, renderer_info.max_texture_width);
+		if (renderer_info.max_texture_height > 0)
+			page_h = std::min(page_h, renderer_info.max_texture_height);
 	}
 
-	for (size_t i = 0; i < threads.size(); ++i) {
-		SDL_WaitThread(threads[i], NULL);
+	// large images (such as big sprite sheets) would leave little room for anything else, so they keep their own texture
+	// only images that fit in half the page width and half the page height (with padding) are packed, i.e. at most a quarter of the page area
+	std::vector<size_t> candidates;
+	for (size_t i = 0; i < image_queue.size(); ++i) {
+		SDL_Surface *surface = static_cast<SDL_Surface*>(image_queue[i].surface);
+		if (surface && surface->w + ATLAS_PADDING <= page_w / 2 && surface->h + ATLAS_PADDING <= page_h / 2)
+			candidates.push_back(i);
 	}
 
-	image_queue.clear();
-}
+	if (candidates.size() < 2)
+		return;
+
+	std::sort(candidates.begin(), candidates.end(), AtlasSortByHeight(&image_queue));
+
+	std::vector<int> page_ids(image_queue.size(), -1);
+	std::vector<int> page_heights;
+	std::vector<unsigned> page_counts;
+	int shelf_x = 0;
+	int shelf_y = 0;
+	int shelf_h = 0;
+
+	for (size_t k = 0; k < candidates.size(); ++k) {
+		size_t i = candidates[k];
+		SDL_Surface *surface = static_cast<SDL_Surface*>(image_queue[i].surface);
+		const int w = surface->w + ATLAS_PADDING;
+		const int h = surface->h + ATLAS_PADDING;
+
+		if (page_heights.empty() || shelf_x + w > page_w) {
+			// start a new shelf, on a new page if this one is full
+			shelf_x = 0;
+			shelf_y += shelf_h;
+			shelf_h = h;
+
+			if (page_heights.empty() || shelf_y + h > page_h) {
+				shelf_y = 0;
+				page_heights.push_back(0);
+				page_counts.push_back(0);
+			}
+		}
 
+		atlas_rects[i] = Rect(shelf_x, shelf_y, surface->w, surface->h);
+		page_ids[i] = static_cast<int>(page_heights.size()) - 1;
+		page_heights.back() = std::max(page_heights.back(), shelf_y + h);
+		page_counts.back()++;
+
+		shelf_x += w;
+	}
+
+	Uint32 rmask, gmask, bmask, amask;
+	Utils::setSDL_RGBA(&rmask, &gmask, &bmask, &amask);
+
+	unsigned packed_images = 0;
+	unsigned packed_pages = 0;
+
+	for (size_t page_id = 0; page_id < page_heights.size(); ++page_id) {
+		// a page holding a single image would only waste memory
+		if (page_counts[page_id] < 2)
+			continue;
+
+		SDL_Surface *page_surface = SDL_CreateRGBSurface(0, page_w, page_heights[page_id], BITS_PER_PIXEL, rmask, gmask, bmask, amask);
+		if (!page_surface) {
+			Utils::logError("SDLHardwareRenderDevice: Couldn't create atlas surface: %s", SDL_GetError());
+			continue;
+		}
+
+		for (size_t k = 0; k < candidates.size(); ++k) {
+			size_t i = candidates[k];
+			if (page_ids[i] != static_cast<int>(page_id))
+				continue;
+
+			// copy the pixels as they are, including alpha
+			// the surface still becomes a texture of its own if the page texture can't be created, so its blend mode is restored afterwards
+			SDL_Surface *surface = static_cast<SDL_Surface*>(image_queue[i].surface);
+			SDL_Rect dest = atlas_rects[i];
+			SDL_BlendMode blend_mode = SDL_BLENDMODE_BLEND;
+			SDL_GetSurfaceBlendMode(surface, &blend_mode);
+			SDL_SetSurfaceBlendMode(surface, SDL_BLENDMODE_NONE);
+			SDL_BlitSurface(surface, NULL, page_surface, &dest);
+			SDL_SetSurfaceBlendMode(surface, blend_mode);
+		}
+
+		SDLHardwareImage *page = new SDLHardwareImage(this, renderer);
+		page->surface = SDL_CreateTextureFromSurface(renderer, page_surface);
+		SDL_FreeSurface(page_surface);
+
+		if (!page->surface) {
+			Utils::logError("SDLHardwareRenderDevice: Couldn't create atlas texture: %s", SDL_GetError());
+			delete page;
+			continue;
+		}
+		SDL_SetTextureBlendMode(page->surface, SDL_BLENDMODE_BLEND);
+
+		for (size_t k = 0; k < candidates.size(); ++k) {
+			size_t i = candidates[k];
+			if (page_ids[i] != static_cast<int>(page_id))
+				continue;
+
+			page->ref();
+			atlas_pages[i] = page;
+			packed_images++;
+		}
+
+		// from now on, the page is only kept alive by the images on it
+		page->unref();
+		packed_pages++;
+	}
+
+	if (packed_pages > 0)
+		Utils::logInfo("SDLHardwareRenderDevice: Packed %u images into %u atlas textures.", packed_images, packed_pages);
+}
@@ -45,16 +45,25 @@ public:
 
 	void fillWithColor(const Color& color);
 	void drawPixel(int x, int y, const Color& color);
+	void drawPixelSpan(int x, int y, int w, const Color& color);
 	void drawLine(int x0, int y0, int x1, int y1, const Color& color);
 	void drawFilledRect(int x, int y, int w, int h, const Color& color);
 	void beginPixelBatch();
 	void beginPixelBatch(Rect& bounds);
 	void endPixelBatch();
+	bool usePremultipliedAlpha();
 	Image* resize(int width, int height);
 
+	// gives this image its own texture, so it can be drawn to. Returns false if the texture couldn't be created
+	bool detachFromAtlas();
+
 	SDL_Renderer *renderer;
 	SDL_Texture *surface;
 
+	// images loaded together may share an atlas texture. In that case, surface belongs to atlas_page and this image is atlas_rect within it
+	SDLHardwareImage *atlas_page;
+	Rect atlas_rect;
+
 	SDL_Surface *pixel_batch_surface;
 	int pixel_batch_type;
 	Rect pixel_batch_area;
@@ -68,6 +77,7 @@ private:
 
 	void drawPixelSingle(int x, int y, const Color& color);
 	void drawPixelBatch(int x, int y, const Color& color);
+	void drawPixelSpanBatch(int x, int y, int w, const Color& color);
 };
 
 class SDLHardwareRenderDevice : public RenderDevice {
@@ -99,13 +109,24 @@ public:
 
 	void loadQueuedImages();
 
+	// sends queued draws to the renderer. Must be called before anything else uses the renderer
+	void flushBatch();
+
 protected:
 	int createContextInternal();
 	void createContextError();
 
 private:
+	// atlas pages are at most this size, unless the renderer has a lower limit
+	static const int ATLAS_PAGE_SIZE = 2048;
+	// transparent pixels between packed images, so that texture filtering doesn't pick up neighbouring images
+	static const int ATLAS_PADDING = 2;
+
 	void getWindowSize(short unsigned *screen_w, short unsigned *screen_h);
-	static int loadQueuedImage(void* data);
+	static void loadQueuedImage(void* data);
+	void packQueuedImages(std::vector<SDLHardwareImage*>& atlas_pages, std::vector<Rect>& atlas_rects);
+	bool mapAtlasRect(SDLHardwareImage *image, SDL_Rect& src, SDL_Rect& dest);
+	int drawTexture(SDL_Texture *surface, SDL_BlendMode blend_mode, const SDL_Rect& src, const SDL_Rect& dest, const Color& color_mod, uint8_t alpha_mod);
 
 	SDL_Window *window;
 	SDL_Renderer *renderer;
@@ -118,6 +139,16 @@ private:
 	uint16_t gamma_r[256];
 	uint16_t gamma_g[256];
 	uint16_t gamma_b[256];
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	/* Consecutive draws of the same texture and blend mode are collected here and sent as a single SDL_RenderGeometry() call */
+	SDL_Texture *batch_texture;
+	SDL_BlendMode batch_blend_mode;
+	float batch_texture_w;
+	float batch_texture_h;
+	std::vector<SDL_Vertex> batch_vertices;
+	std::vector<int> batch_indices;
+#endif
 };
 
 #endif
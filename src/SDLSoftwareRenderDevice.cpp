@@ -35,6 +35,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Platform.h"
 #include "SharedResources.h"
 #include "Settings.h"
+#include "ThreadPool.h"
 
 #include "SDLSoftwareRenderDevice.h"
 #include "SDLFontEngine.h"
@@ -115,6 +116,48 @@ void SDLSoftwareImage::drawPixel(int x, int y, const Color& color) {
 	}
 }
 
+/*
+ * Set w pixels in a row, starting at (x, y)
+ */
+void SDLSoftwareImage::drawPixelSpan(int x, int y, int w, const Color& color) {
+	if (!surface) return;
+
+	if (y < 0 || y >= getHeight())
+		return;
+
+	// clip the span to the image
+	if (x < 0) {
+		w += x;
+		x = 0;
+	}
+	if (x + w > getWidth())
+		w = getWidth() - x;
+	if (w <= 0)
+		return;
+
+	int bpp = surface->format->BytesPerPixel;
+	if (bpp != 4) {
+		for (int i = 0; i < w; ++i) {
+			drawPixel(x + i, y, color);
+		}
+		return;
+	}
+
+	Uint32 pixel = MapRGBA(color.r, color.g, color.b, color.a);
+
+	if (SDL_MUSTLOCK(surface)) {
+		SDL_LockSurface(surface);
+	}
+
+	// one plain fill per span, which the compiler can vectorize
+	Uint32 *p = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch) + x;
+	std::fill_n(p, w, pixel);
+
+	if (SDL_MUSTLOCK(surface)) {
+		SDL_UnlockSurface(surface);
+	}
+}
+
 void SDLSoftwareImage::drawLine(int x0, int y0, int x1, int y1, const Color& color) {
 	const int dx = abs(x1-x0);
 	const int dy = abs(y1-y0);
@@ -159,6 +202,38 @@ Uint32 SDLSoftwareImage::MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a) {
 	return SDL_MapRGBA(surface->format, r, g, b, a);
 }
 
+/**
+ * Surface blits can't use a custom blend mode, so the colors are divided by alpha again
+ */
+bool SDLSoftwareImage::usePremultipliedAlpha() {
+	if (!surface || surface->format->BytesPerPixel != 4)
+		return false;
+
+	if (SDL_MUSTLOCK(surface)) {
+		SDL_LockSurface(surface);
+	}
+
+	for (int y = 0; y < surface->h; ++y) {
+		Uint32 *p = reinterpret_cast<Uint32*>(static_cast<Uint8*>(surface->pixels) + y * surface->pitch);
+		for (int x = 0; x < surface->w; ++x) {
+			Uint8 r, g, b, a;
+			SDL_GetRGBA(p[x], surface->format, &r, &g, &b, &a);
+			if (a == 0 || a == 255)
+				continue;
+
+			r = static_cast<Uint8>(std::min(r * 255 / a, 255));
+			g = static_cast<Uint8>(std::min(g * 255 / a, 255));
+			b = static_cast<Uint8>(std::min(b * 255 / a, 255));
+			p[x] = SDL_MapRGBA(surface->format, r, g, b, a);
+		}
+	}
+
+	if (SDL_MUSTLOCK(surface)) {
+		SDL_UnlockSurface(surface);
+	}
+	return true;
+}
+
 /**
  * Resizes an image
  * Deletes the original image and returns a pointer to the resized version
@@ -381,6 +456,7 @@ int SDLSoftwareRenderDevice::render(Renderable& r, Rect& dest) {
 	SDL_SetSurfaceColorMod(surface, r.color_mod.r, r.color_mod.g, r.color_mod.b);
 	SDL_SetSurfaceAlphaMod(surface, r.alpha_mod);
 
+	++draw_calls;
 	return SDL_BlitSurface(surface, &src, screen, &_dest);
 }
 
@@ -400,6 +476,7 @@ int SDLSoftwareRenderDevice::render(Sprite *r) {
 	SDL_SetSurfaceColorMod(surface, r->color_mod.r, r->color_mod.g, r->color_mod.b);
 	SDL_SetSurfaceAlphaMod(surface, r->alpha_mod);
 
+	++draw_calls;
 	return SDL_BlitSurface(surface, &src, screen, &dest);
 }
 
@@ -409,6 +486,10 @@ int SDLSoftwareRenderDevice::renderToImage(Image* src_image, Rect& src, Image* d
 	SDL_Rect _src = src;
 	SDL_Rect _dest = dest;
 
+	// copy the source as it is, without color/alpha changes left over from render()
+	SDL_SetSurfaceColorMod(static_cast<SDLSoftwareImage *>(src_image)->surface, 255, 255, 255);
+	SDL_SetSurfaceAlphaMod(static_cast<SDLSoftwareImage *>(src_image)->surface, 255);
+
 	return SDL_BlitSurface(static_cast<SDLSoftwareImage *>(src_image)->surface, &_src,
 						   static_cast<SDLSoftwareImage *>(dest_image)->surface, &_dest);
 }
@@ -524,6 +605,9 @@ void SDLSoftwareRenderDevice::commitFrame() {
 	SDL_RenderPresent(renderer);
 	inpt->window_resized = false;
 
+	last_draw_calls = draw_calls;
+	draw_calls = 0;
+
 	return;
 }
 
@@ -725,46 +809,37 @@ unsigned short SDLSoftwareRenderDevice::getRefreshRate() {
 	return static_cast<unsigned short>(mode.refresh_rate);
 }
 
-int SDLSoftwareRenderDevice::loadQueuedImage(void* data) {
+void SDLSoftwareRenderDevice::loadQueuedImage(void* data) {
 	QueuedImage* image = static_cast<QueuedImage*>(data);
-	SDL_LockMutex(image->mutex);
 	image->surface = IMG_Load(image->loc_filename.c_str());
-	image->load_attempted = true;
-	SDL_CondSignal(image->loaded);
-	SDL_UnlockMutex(image->mutex);
-	return 0;
+	if (!image->surface)
+		image->load_error = IMG_GetError();
 }
 
+/**
+ * Images are decoded on the worker threads. Creating the images from the decoded data is done here afterwards
+ */
 void SDLSoftwareRenderDevice::loadQueuedImages() {
-	std::vector<SDL_Thread*> threads(image_queue.size(), NULL);
-
 	for (size_t i = 0; i < image_queue.size(); ++i) {
-		std::string thread_name = "Image queue: " + image_queue[i].filename;
-		image_queue[i].mutex = SDL_CreateMutex();
-		image_queue[i].loaded = SDL_CreateCond();
-		threads[i] = SDL_CreateThread(loadQueuedImage, thread_name.c_str(), &image_queue[i]);
+		thread_pool->submit(loadQueuedImage, &image_queue[i]);
 	}
+	thread_pool->wait();
 
 	for (size_t i = 0; i < image_queue.size(); ++i) {
-		SDL_LockMutex(image_queue[i].mutex);
 		SDLSoftwareImage *image = new SDLSoftwareImage(this);
-		if (!image) return;
-
-		if (!image_queue[i].surface && !image_queue[i].load_attempted) {
-			SDL_CondWait(image_queue[i].loaded, image_queue[i].mutex);
-		}
 
 		if (image_queue[i].surface) {
 			image->surface = static_cast<SDL_Surface*>(image_queue[i].surface);
+			image_queue[i].surface = NULL;
 		}
 
 		if(image->surface == NULL) {
 			delete image;
 			if (image_queue[i].error_type != ERROR_NONE)
-				Utils::logError("SDLSoftwareRenderDevice: Couldn't load image: '%s'. %s", image_queue[i].filename.c_str(), IMG_GetError());
+				Utils::logError("SDLSoftwareRenderDevice: Couldn't load image: '%s'. %s", image_queue[i].filename.c_str(), image_queue[i].load_error.c_str());
 
 			if (image_queue[i].error_type == ERROR_EXIT) {
-				Utils::logErrorDialog("SDLSoftwareRenderDevice: Couldn't load image: '%s'.\n%s", image_queue[i].filename.c_str(), IMG_GetError());
+				Utils::logErrorDialog("SDLSoftwareRenderDevice: Couldn't load image: '%s'.\n%s", image_queue[i].filename.c_str(), image_queue[i].load_error.c_str());
 				mods->resetModConfig();
 				Utils::Exit(1);
 			}
@@ -774,17 +849,6 @@ void SDLSoftwareRenderDevice::loadQueuedImages() {
 			cacheStore(image_queue[i].filename, image);
 			image_queue_cleanup.push_back(static_cast<Image*>(image));
 		}
-
-		SDL_UnlockMutex(image_queue[i].mutex);
-
-		SDL_DestroyMutex(image_queue[i].mutex);
-		SDL_DestroyCond(image_queue[i].loaded);
-		image_queue[i].mutex = NULL;
-		image_queue[i].loaded = NULL;
-	}
-
-	for (size_t i = 0; i < threads.size(); ++i) {
-		SDL_WaitThread(threads[i], NULL);
 	}
 
 	image_queue.clear();
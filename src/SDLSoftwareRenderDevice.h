@@ -48,8 +48,10 @@ public:
 
 	void fillWithColor(const Color& color);
 	void drawPixel(int x, int y, const Color& color);
+	void drawPixelSpan(int x, int y, int w, const Color& color);
 	void drawLine(int x0, int y0, int x1, int y1, const Color& color);
 	void drawFilledRect(int x, int y, int w, int h, const Color& color);
+	bool usePremultipliedAlpha();
 	Image* resize(int width, int height);
 
 	SDL_Surface *surface;
@@ -94,7 +96,7 @@ protected:
 private:
 	Uint32 MapRGBA(Uint8 r, Uint8 g, Uint8 b, Uint8 a);
 	void getWindowSize(short unsigned *screen_w, short unsigned *screen_h);
-	static int loadQueuedImage(void* data);
+	static void loadQueuedImage(void* data);
 
 	SDL_Surface* screen;
 	SDL_Window* window;
@@ -27,6 +27,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CommonIncludes.h"
 #include "EngineSettings.h"
 #include "ModManager.h"
+#include "Profiler.h"
 #include "Settings.h"
 #include "SharedGameResources.h"
 #include "SharedResources.h"
@@ -37,11 +38,15 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 class Sound {
 public:
-	Mix_Chunk *chunk;
-	Sound() :  chunk(0), refCnt(0) {}
+	Mix_Chunk *chunk; // NULL while evicted from the cache
+	Sound() :  chunk(0), refCnt(0), playing(0), decoding(false) {}
 private:
 	friend class SDLSoundManager;
 	int refCnt;
+	int playing; // entries in SDLSoundManager::playback for this sound. Its chunk isn't freed while there are any
+	std::string filename;
+	std::list<Sound*>::iterator lru_it; // position in SDLSoundManager::resident_sounds, while chunk is set
+	bool decoding;
 };
 
 SDLSoundManager::SDLSoundManager()
@@ -49,6 +54,20 @@ SDLSoundManager::SDLSoundManager()
 	, music(NULL)
 	, music_filename("")
 	, last_played_sid(-1)
+	, resident_bytes(0)
+	, cache_budget(static_cast<size_t>(settings->sound_cache_size) * 1024 * 1024)
+	, cache_hits(0)
+	, cache_misses(0)
+	, cache_evictions(0)
+	, decode_thread(NULL)
+	, decode_mutex(NULL)
+	, decode_added(NULL)
+	, decode_quit(false)
+	, decode_count(0)
+	, voices_stolen(0)
+	, voices_culled(0)
+	, voices_coalesced(0)
+	, voices_dropped(0)
 {
 	if (settings->audio && Mix_OpenAudio(settings->audio_freq, AUDIO_S16SYS, 2, 1024)) {
 		Utils::logError("SDLSoundManager: Error during Mix_OpenAudio: %s", SDL_GetError());
@@ -64,6 +83,26 @@ SDLSoundManager::SDLSoundManager()
 }
 
 SDLSoundManager::~SDLSoundManager() {
+	if (decode_thread) {
+		SDL_LockMutex(decode_mutex);
+		decode_quit = true;
+		SDL_CondSignal(decode_added);
+		SDL_UnlockMutex(decode_mutex);
+		SDL_WaitThread(decode_thread, NULL);
+	}
+	if (decode_added) SDL_DestroyCond(decode_added);
+	if (decode_mutex) SDL_DestroyMutex(decode_mutex);
+
+	while (!decode_queue.empty()) {
+		delete decode_queue.front();
+		decode_queue.pop();
+	}
+	for (size_t i = 0; i < decode_finished.size(); ++i) {
+		if (decode_finished[i]->chunk)
+			Mix_FreeChunk(decode_finished[i]->chunk);
+		delete decode_finished[i];
+	}
+
 	unloadMusic();
 
 	SDLSoundManager::SoundMapIterator it;
@@ -74,74 +113,118 @@ SDLSoundManager::~SDLSoundManager() {
 }
 
 void SDLSoundManager::logic() {
+	PROFILE_SCOPE("SDLSoundManager::logic");
 
-	PlaybackMapIterator it = playback.begin();
-	if (it == playback.end())
-		return;
+	// cleared first, so the pending plays started below are coalesced with each other and with this frame's plays
+	frame_plays.clear();
+	frame_pending.clear();
+
+	bool decoded = false;
+	if (decode_count > 0)
+		decoded = finishDecodes();
+
+	if (!playback.empty() || !virtual_voices.empty())
+		updateVoices();
+
+	// only trim once the sounds that were waiting for these chunks have started, since playing chunks are never freed
+	if (decoded)
+		trimCache();
+}
 
+/**
+ * Updates the distance of playing sounds, and moves loops between the mixer and virtual_voices
+ */
+void SDLSoundManager::updateVoices() {
 	std::vector<int> cleanup;
+	std::vector<int> out_of_range;
 
+	PlaybackMapIterator it = playback.begin();
 	while(it != playback.end()) {
 
-		/* if sound is finished and should be unloaded add it to cleanup and continue with next */
-		if (it->second.finished && it->second.cleanup) {
+		/* if sound is finished add it to cleanup (which unloads it, if requested) and continue with next */
+		if (it->second.finished) {
 			cleanup.push_back(it->first);
 			++it;
 			continue;
 		}
 
 		/* dont process playback sounds without location */
-		if (it->second.location.x == 0 && it->second.location.y == 0) {
+		if (it->second.finished || (it->second.location.x == 0 && it->second.location.y == 0)) {
 			++it;
 			continue;
 		}
 
-		/* control mixing playback depending on distance */
-		Uint8 dist = 0;
-		if (pc && eset->misc.sound_falloff > 0) {
-			float v = Utils::calcDist(pc->stats.pos, it->second.location) / static_cast<float>(eset->misc.sound_falloff);
-			if (it->second.loop) {
-				if (v < 1.0 && it->second.paused) {
-					Mix_Resume(it->first);
-					it->second.paused = false;
-				}
-				else if (v > 1.0 && !it->second.paused) {
-					Mix_Pause(it->first);
-					it->second.paused = true;
-					++it;
-					continue;
-				}
-			}
-
-			/* update sound mix with new distance/location to hero */
-			v = std::min<float>(std::max<float>(v, 0.0f), 1.0f);
-			dist = Uint8(255.0 * v);
+		/* loops that can't be heard give up their channel until the hero comes closer */
+		float falloff = getFalloff(it->second.location);
+		if (it->second.loop && falloff >= 1.0f) {
+			out_of_range.push_back(it->first);
+			++it;
+			continue;
 		}
 
-		Mix_SetPosition(it->first, 0, dist);
+		/* update sound mix with new distance/location to hero */
+		int dist = getMixDistance(falloff);
+		if (dist != it->second.mix_distance) {
+			Mix_SetPosition(it->first, 0, static_cast<Uint8>(dist));
+			it->second.mix_distance = dist;
+		}
 		++it;
 	}
 
 	/* clenaup finished soundplayback */
-	while (!cleanup.empty()) {
+	for (size_t i = 0; i < cleanup.size(); ++i) {
+		removePlayback(playback.find(cleanup[i]));
+	}
 
-		it = playback.find(cleanup.back());
+	for (size_t i = 0; i < out_of_range.size(); ++i) {
+		virtualizePlayback(playback.find(out_of_range[i]));
+	}
 
-		unload(it->second.sid);
+	/* give channels back to virtual voices that can be heard again */
+	for (size_t i = 0; i < virtual_voices.size(); ) {
+		if (getFalloff(virtual_voices[i].location) >= 1.0f) {
+			++i;
+			continue;
+		}
 
-		/* find and erase virtual channel for playback if exists */
-		VirtualChannelMapIterator vcit = channels.find(it->second.virtual_channel);
-		if (vcit != channels.end())
-			channels.erase(vcit);
+		SoundMapIterator sit = sounds.find(virtual_voices[i].sid);
+		if (sit == sounds.end()) {
+			// the sound was unloaded by its owner
+			virtual_voices.erase(virtual_voices.begin() + i);
+			continue;
+		}
 
-		playback.erase(it);
+		if (!sit->second->chunk) {
+			// the loop is about to be heard. Once decoded, it is the most recently used sound
+			requestDecode(sit->first, sit->second);
+			++i;
+			continue;
+		}
 
-		cleanup.pop_back();
+		// copied, since starting it can make room by adding another voice to virtual_voices
+		Playback voice = virtual_voices[i];
+		if (startPlayback(voice, sit->second->chunk) != -1)
+			virtual_voices.erase(virtual_voices.begin() + i);
+		else
+			++i;
 	}
 }
 
 void SDLSoundManager::reset() {
 
+	// sounds that are still being decoded belong to the previous map
+	for (size_t i = 0; i < pending_plays.size(); ++i) {
+		dropPendingPlay(pending_plays[i]);
+	}
+	pending_plays.clear();
+	frame_pending.clear();
+
+	for (size_t i = 0; i < virtual_voices.size(); ++i) {
+		if (virtual_voices[i].cleanup)
+			unload(virtual_voices[i].sid);
+	}
+	virtual_voices.clear();
+
 	PlaybackMapIterator it = playback.begin();
 	if (it == playback.end())
 		return;
@@ -176,6 +259,7 @@ SoundID SDLSoundManager::load(const std::string& filename, const std::string& er
 	/* load non existing sound */
 	lsnd.chunk = Mix_LoadWAV(realfilename.c_str());
 	lsnd.refCnt = 1;
+	lsnd.filename = realfilename;
 	if (!lsnd.chunk) {
 		Utils::logError("SoundManager: %s: Loading sound %s (%s) failed: %s", errormessage.c_str(),
 				realfilename.c_str(), filename.c_str(), Mix_GetError());
@@ -186,8 +270,10 @@ SoundID SDLSoundManager::load(const std::string& filename, const std::string& er
 	 * so we need to update the ref count to prevent unintentional unloading of our "new" sound */
 	PlaybackMapIterator play_it = playback.begin();
 	while (play_it != playback.end()) {
-		if (play_it->second.sid == sid)
+		if (play_it->second.sid == sid) {
 			lsnd.refCnt++;
+			lsnd.playing++;
+		}
 		++play_it;
 	}
 
@@ -196,6 +282,9 @@ SoundID SDLSoundManager::load(const std::string& filename, const std::string& er
 	*psnd = lsnd;
 	sounds.insert(std::pair<SoundID,Sound *>(sid, psnd));
 
+	addResident(psnd);
+	trimCache();
+
 	return sid;
 }
 
@@ -207,7 +296,8 @@ void SDLSoundManager::unload(SoundID sid) {
 		return;
 
 	if (--it->second->refCnt == 0) {
-		Mix_FreeChunk(it->second->chunk);
+		if (it->second->chunk)
+			freeChunk(it->second);
 		delete it->second;
 		sounds.erase(it);
 	}
@@ -218,7 +308,6 @@ void SDLSoundManager::unload(SoundID sid) {
 void SDLSoundManager::play(SoundID sid, const std::string& channel, const FPoint& pos, bool loop, bool cleanup) {
 
 	SoundMapIterator it;
-	VirtualChannelMapIterator vcit = channels.end();
 
 	// since last_played_sid is primarily used for subtitles, it doesn't make sense to count looped sounds
 	if (!loop && sid)
@@ -231,6 +320,55 @@ void SDLSoundManager::play(SoundID sid, const std::string& channel, const FPoint
 	if (it == sounds.end())
 		return;
 
+	if (!loop && coalescePlay(sid, pos))
+		return;
+
+	Sound* psnd = it->second;
+
+	if (!psnd->chunk) {
+		// the chunk was evicted from the cache, so play it once it has been decoded again
+		cache_misses++;
+		requestDecode(sid, psnd);
+		if (!loop)
+			frame_pending[sid] = pending_plays.size();
+		pending_plays.push_back(PendingPlay(sid, channel, pos, loop, cleanup));
+		return;
+	}
+
+	cache_hits++;
+	touchResident(psnd);
+	playChunk(sid, psnd, channel, pos, loop, cleanup);
+}
+
+/**
+ * A non-looping sound that is played again in the same frame (e.g. a hit sound for every enemy caught in an
+ * explosion) only plays once, from the position closest to the hero. Returns true if the play was merged like that
+ */
+bool SDLSoundManager::coalescePlay(SoundID sid, const FPoint& pos) {
+	std::map<SoundID, int>::iterator fit = frame_plays.find(sid);
+	if (fit != frame_plays.end()) {
+		PlaybackMapIterator pit = playback.find(fit->second);
+		if (pit != playback.end() && pit->second.sid == sid && getFalloff(pos) < getFalloff(pit->second.location))
+			pit->second.location = pos;
+		voices_coalesced++;
+		return true;
+	}
+
+	std::map<SoundID, size_t>::iterator pend_it = frame_pending.find(sid);
+	if (pend_it != frame_pending.end()) {
+		PendingPlay& pending = pending_plays[pend_it->second];
+		if (getFalloff(pos) < getFalloff(pending.pos))
+			pending.pos = pos;
+		voices_coalesced++;
+		return true;
+	}
+
+	return false;
+}
+
+void SDLSoundManager::playChunk(SoundID sid, Sound* psnd, const std::string& channel, const FPoint& pos, bool loop, bool cleanup) {
+	VirtualChannelMapIterator vcit = channels.end();
+
 	/* create playback object and start playback of sound chunk */
 	Playback p;
 	p.sid = sid;
@@ -246,39 +384,197 @@ void SDLSoundManager::play(SoundID sid, const std::string& channel, const FPoint
 		vcit = channels.find(p.virtual_channel);
 		if (vcit != channels.end()) {
 			// temporarily disable the channel finish callback to avoid setting the 'finished' flag when stopping the channel
-			if (!cleanup)
+			if (!cleanup) {
 				Mix_ChannelFinished(NULL);
 
+				// still let logic() drop the stopped playback, so it no longer keeps its chunk in the cache
+				PlaybackMapIterator pit = playback.find(vcit->second);
+				if (pit != playback.end()) {
+					pit->second.cleanup = false;
+					pit->second.finished = true;
+				}
+			}
+
 			Mix_HaltChannel(vcit->second);
+			channels.erase(vcit);
 		}
 
-		vcit = channels.insert(std::pair<std::string, int>(p.virtual_channel, -1)).first;
+		/* the previous sound on this virtual channel might not have a mixer channel right now */
+		for (size_t i = 0; i < virtual_voices.size(); ) {
+			if (virtual_voices[i].virtual_channel == p.virtual_channel) {
+				if (virtual_voices[i].cleanup)
+					unload(virtual_voices[i].sid);
+				virtual_voices.erase(virtual_voices.begin() + i);
+			}
+			else {
+				++i;
+			}
+		}
+	}
+
+	Mix_ChannelFinished(&channel_finished);
+
+	if (getFalloff(p.location) >= 1.0f) {
+		// too far away to be heard. Loops are kept, so they can start when the hero comes closer
+		if (loop)
+			virtual_voices.push_back(p);
+		else
+			voices_culled++;
+		return;
 	}
 
 	// Let playback own a reference to prevent unloading playbacked sound.
 	if (!loop)
-		it->second->refCnt++;
+		psnd->refCnt++;
 
-	Mix_ChannelFinished(&channel_finished);
-	int c = Mix_PlayChannel(-1, it->second->chunk, (loop ? -1 : 0));
+	int c = startPlayback(p, psnd->chunk);
 
-	if (c == -1)
-		Utils::logError("SoundManager: Failed to play sound, no more channels available.");
+	if (c == -1) {
+		if (loop) {
+			virtual_voices.push_back(p);
+		}
+		else {
+			voices_dropped++;
+			unload(sid);
+		}
+		return;
+	}
+
+	if (!loop)
+		frame_plays[sid] = c;
+}
+
+/**
+ * How far a location is from the hero, from 0 (at the hero) to 1 (where sounds can no longer be heard)
+ * Sounds without a location are always at 0
+ */
+float SDLSoundManager::getFalloff(const FPoint& location) {
+	if (!pc || eset->misc.sound_falloff <= 0 || (location.x == 0 && location.y == 0))
+		return 0;
+
+	return Utils::calcDist(pc->stats.pos, location) / static_cast<float>(eset->misc.sound_falloff);
+}
+
+int SDLSoundManager::getMixDistance(float falloff) {
+	return static_cast<int>(255.0f * std::min(std::max(falloff, 0.0f), 1.0f));
+}
+
+/**
+ * Sounds without a location (the interface, the hero's footsteps) come first, then effects, then loops
+ * Within each group, closer sounds are more important
+ */
+float SDLSoundManager::getPriority(const Playback& p) {
+	if (p.location.x == 0 && p.location.y == 0)
+		return static_cast<float>(PRIORITY_INTERFACE) + 1.0f;
+
+	const float category = static_cast<float>(p.loop ? PRIORITY_LOOP : PRIORITY_EFFECT);
+	return category + 1.0f - std::min(getFalloff(p.location), 1.0f);
+}
+
+/**
+ * Starts playing a chunk on a free mixer channel. If every channel is in use, the least important sound is stopped
+ * to make room, as long as it is less important than this one. Returns the channel, or -1 if the sound wasn't started
+ */
+int SDLSoundManager::startPlayback(const Playback& p, Mix_Chunk* chunk) {
+	int c = -1;
+
+	if (Mix_Playing(-1) >= Mix_AllocateChannels(-1)) {
+		PlaybackMapIterator victim = playback.end();
+		float victim_priority = getPriority(p);
+
+		for (PlaybackMapIterator it = playback.begin(); it != playback.end(); ++it) {
+			if (it->second.finished)
+				continue;
+
+			float priority = getPriority(it->second);
+			if (priority < victim_priority) {
+				victim = it;
+				victim_priority = priority;
+			}
+		}
+
+		if (victim == playback.end())
+			return -1;
+
+		c = victim->first;
+		voices_stolen++;
+		if (victim->second.loop) {
+			virtualizePlayback(victim);
+		}
+		else {
+			Mix_HaltChannel(c);
+			removePlayback(playback.find(c));
+		}
+	}
 
-	// precalculate mixing volume if sound has a location
-	Uint8 d = 0;
-	if (pc && eset->misc.sound_falloff > 0 && (p.location.x != 0 || p.location.y != 0)) {
-		float v = 255.0f * (Utils::calcDist(pc->stats.pos, p.location) / static_cast<float>(eset->misc.sound_falloff));
-		v = std::min<float>(std::max<float>(v, 0.0f), 255.0f);
-		d = Uint8(v);
+	c = Mix_PlayChannel(c, chunk, (p.loop ? -1 : 0));
+	if (c == -1) {
+		Utils::logError("SoundManager: Failed to play sound, no more channels available.");
+		return -1;
 	}
 
-	Mix_SetPosition(c, 0, d);
+	// a finished sound on this channel might still be waiting for logic() to clean it up
+	PlaybackMapIterator old = playback.find(c);
+	if (old != playback.end())
+		removePlayback(old);
+
+	Playback started = p;
+	started.finished = false;
+	started.mix_distance = getMixDistance(getFalloff(p.location));
+	Mix_SetPosition(c, 0, static_cast<Uint8>(started.mix_distance));
+
+	playback.insert(std::pair<int, Playback>(c, started));
 
-	if (vcit != channels.end())
-		vcit->second = c;
+	SoundMapIterator sit = sounds.find(started.sid);
+	if (sit != sounds.end())
+		sit->second->playing++;
 
-	playback.insert(std::pair<int, Playback>(c, p));
+	if (started.virtual_channel != DEFAULT_CHANNEL)
+		channels[started.virtual_channel] = c;
+
+	return c;
+}
+
+void SDLSoundManager::removePlayback(PlaybackMapIterator it) {
+	if (it == playback.end())
+		return;
+
+	SoundMapIterator sit = sounds.find(it->second.sid);
+	if (sit != sounds.end() && sit->second->playing > 0)
+		sit->second->playing--;
+
+	if (it->second.cleanup)
+		unload(it->second.sid);
+
+	/* find and erase virtual channel for playback if exists */
+	VirtualChannelMapIterator vcit = channels.find(it->second.virtual_channel);
+	if (vcit != channels.end() && vcit->second == it->first)
+		channels.erase(vcit);
+
+	playback.erase(it);
+}
+
+/**
+ * Stops a looping sound on the mixer, but keeps track of it so that logic() can start it again
+ */
+void SDLSoundManager::virtualizePlayback(PlaybackMapIterator it) {
+	if (it == playback.end())
+		return;
+
+	const int c = it->first;
+	virtual_voices.push_back(it->second);
+
+	SoundMapIterator sit = sounds.find(it->second.sid);
+	if (sit != sounds.end() && sit->second->playing > 0)
+		sit->second->playing--;
+
+	VirtualChannelMapIterator vcit = channels.find(it->second.virtual_channel);
+	if (vcit != channels.end() && vcit->second == c)
+		channels.erase(vcit);
+
+	// erase first, so the finished callback doesn't flag it
+	playback.erase(it);
+	Mix_HaltChannel(c);
 }
 
 void SDLSoundManager::pauseChannel(const std::string& channel) {
@@ -377,3 +673,198 @@ SoundID SDLSoundManager::getLastPlayedSID() {
 	return ret;
 }
 
+void SDLSoundManager::getStats(SoundStats& stats) {
+	stats.hits = cache_hits;
+	stats.misses = cache_misses;
+	stats.evictions = cache_evictions;
+	stats.sound_count = sounds.size();
+	stats.resident_count = 0;
+	for (SoundMapIterator it = sounds.begin(); it != sounds.end(); ++it) {
+		if (it->second->chunk)
+			stats.resident_count++;
+	}
+	stats.resident_bytes = resident_bytes;
+	stats.budget_bytes = cache_budget;
+
+	stats.playing_voices = 0;
+	for (PlaybackMapIterator it = playback.begin(); it != playback.end(); ++it) {
+		if (!it->second.finished)
+			stats.playing_voices++;
+	}
+	stats.virtual_voices = virtual_voices.size();
+	stats.stolen = voices_stolen;
+	stats.culled = voices_culled;
+	stats.coalesced = voices_coalesced;
+	stats.dropped = voices_dropped;
+}
+
+int SDLSoundManager::decodeThreadMain(void* data) {
+	SDLSoundManager* manager = static_cast<SDLSoundManager*>(data);
+
+	SDL_LockMutex(manager->decode_mutex);
+	while (true) {
+		while (manager->decode_queue.empty() && !manager->decode_quit) {
+			SDL_CondWait(manager->decode_added, manager->decode_mutex);
+		}
+		if (manager->decode_quit)
+			break;
+
+		DecodeJob* job = manager->decode_queue.front();
+		manager->decode_queue.pop();
+		SDL_UnlockMutex(manager->decode_mutex);
+
+		manager->decodeJob(job);
+
+		SDL_LockMutex(manager->decode_mutex);
+		manager->decode_finished.push_back(job);
+	}
+	SDL_UnlockMutex(manager->decode_mutex);
+
+	return 0;
+}
+
+void SDLSoundManager::requestDecode(SoundID sid, Sound* psnd) {
+	if (psnd->decoding)
+		return;
+
+	psnd->decoding = true;
+	decode_count++;
+	DecodeJob* job = new DecodeJob(sid, psnd->filename);
+
+	if (!decode_thread && !decode_mutex) {
+		decode_mutex = SDL_CreateMutex();
+		decode_added = SDL_CreateCond();
+		if (decode_mutex && decode_added)
+			decode_thread = SDL_CreateThread(decodeThreadMain, "SDLSoundManager decoder", this);
+		if (!decode_thread)
+			Utils::logError("SoundManager: Could not start the sound decoding thread, decoding on the main thread instead: %s", SDL_GetError());
+	}
+
+	if (!decode_thread) {
+		decodeJob(job);
+		decode_finished.push_back(job);
+		return;
+	}
+
+	SDL_LockMutex(decode_mutex);
+	decode_queue.push(job);
+	SDL_CondSignal(decode_added);
+	SDL_UnlockMutex(decode_mutex);
+}
+
+/**
+ * Runs on the decode thread, unless it couldn't be started. Only touches the job
+ */
+void SDLSoundManager::decodeJob(DecodeJob* job) {
+	job->chunk = Mix_LoadWAV(job->filename.c_str());
+	if (!job->chunk)
+		job->error = Mix_GetError();
+}
+
+/**
+ * Puts chunks decoded by the decode thread back into their sounds, and starts the plays that were waiting for them
+ * Returns true if any chunk was put back, so the cache may need trimming
+ */
+bool SDLSoundManager::finishDecodes() {
+	bool decoded = false;
+
+	std::vector<DecodeJob*> jobs;
+	if (decode_mutex) SDL_LockMutex(decode_mutex);
+	jobs.swap(decode_finished);
+	if (decode_mutex) SDL_UnlockMutex(decode_mutex);
+
+	for (size_t i = 0; i < jobs.size(); ++i) {
+		DecodeJob* job = jobs[i];
+		SoundMapIterator it = sounds.find(job->sid);
+
+		if (!job->chunk) {
+			Utils::logError("SoundManager: Decoding sound %s again failed: %s", job->filename.c_str(), job->error.c_str());
+		}
+		else if (it != sounds.end() && !it->second->chunk) {
+			it->second->chunk = job->chunk;
+			addResident(it->second);
+			job->chunk = NULL;
+			decoded = true;
+		}
+		else {
+			// the sound was unloaded while it was being decoded
+			Mix_FreeChunk(job->chunk);
+		}
+
+		if (it != sounds.end())
+			it->second->decoding = false;
+
+		decode_count--;
+		delete job;
+	}
+
+	for (size_t i = 0; i < pending_plays.size(); ) {
+		SoundMapIterator it = sounds.find(pending_plays[i].sid);
+		if (it != sounds.end() && it->second->decoding) {
+			++i;
+			continue;
+		}
+
+		// drop the play if the sound was unloaded or couldn't be decoded
+		if (it != sounds.end() && it->second->chunk) {
+			// plays from several frames may have waited for the same chunk
+			if (pending_plays[i].loop || !coalescePlay(it->first, pending_plays[i].pos))
+				playChunk(it->first, it->second, pending_plays[i].channel, pending_plays[i].pos, pending_plays[i].loop, pending_plays[i].cleanup);
+		}
+		else {
+			dropPendingPlay(pending_plays[i]);
+		}
+
+		pending_plays.erase(pending_plays.begin() + i);
+	}
+
+	return decoded;
+}
+
+/**
+ * A loop that is cleaned up hands its reference to the sound manager, so it has to be given up when the play is dropped
+ */
+void SDLSoundManager::dropPendingPlay(const PendingPlay& pending) {
+	if (pending.loop && pending.cleanup)
+		unload(pending.sid);
+}
+
+/**
+ * A sound that gets a chunk becomes the most recently used one
+ */
+void SDLSoundManager::addResident(Sound* psnd) {
+	psnd->lru_it = resident_sounds.insert(resident_sounds.end(), psnd);
+	resident_bytes += psnd->chunk->alen;
+}
+
+void SDLSoundManager::touchResident(Sound* psnd) {
+	if (psnd->chunk)
+		resident_sounds.splice(resident_sounds.end(), resident_sounds, psnd->lru_it);
+}
+
+void SDLSoundManager::freeChunk(Sound* psnd) {
+	resident_sounds.erase(psnd->lru_it);
+	resident_bytes -= psnd->chunk->alen;
+	Mix_FreeChunk(psnd->chunk);
+	psnd->chunk = NULL;
+}
+
+/**
+ * Frees the least recently used chunks until they fit in the budget again
+ * Sounds that are playing (including paused channels, which can be resumed) are skipped
+ */
+void SDLSoundManager::trimCache() {
+	if (cache_budget == 0)
+		return;
+
+	std::list<Sound*>::iterator it = resident_sounds.begin();
+	while (resident_bytes > cache_budget && it != resident_sounds.end()) {
+		Sound* psnd = *it;
+		++it;
+		if (psnd->playing > 0)
+			continue;
+
+		freeChunk(psnd);
+		cache_evictions++;
+	}
+}
@@ -18,6 +18,19 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 
 /**
  * class SDLSoundManager
+ *
+ * Sound effects are decoded into Mix_Chunks when they are loaded. If settings->sound_cache_size is set, the chunks
+ * that were played least recently are freed once they take up more memory than that. A freed sound keeps its
+ * SoundID; the next time it is played, it is decoded again on a background thread and starts playing when that
+ * finishes. Chunks that are playing on a mixer channel are never freed.
+ *
+ * Music is streamed from disk by SDL_mixer.
+ *
+ * Sound effects compete for the mixer's channels by priority (see getPriority()). When all channels are busy, a new
+ * sound stops the least important one, if there is one less important than itself. Loops that are too far away to
+ * be heard, or that lose their channel, become virtual: they are tracked without a channel, and start again once
+ * they can be heard and a channel is available. One-shot sounds that can't be heard are not played at all, and a
+ * sound that is played again in the same frame only plays once.
  */
 
 #ifndef SDL_SOUND_MANAGER_H
@@ -52,6 +65,8 @@ public:
 
 	SoundID getLastPlayedSID();
 
+	void getStats(SoundStats& stats);
+
 private:
 	typedef std::map<std::string, int> VirtualChannelMap;
 	typedef VirtualChannelMap::iterator VirtualChannelMapIterator;
@@ -62,9 +77,57 @@ private:
 	typedef std::map<int, class Playback> PlaybackMap;
 	typedef PlaybackMap::iterator PlaybackMapIterator;
 
+	class DecodeJob {
+	public:
+		SoundID sid;
+		std::string filename;
+		Mix_Chunk* chunk;
+		std::string error; // SDL errors are per thread, so the decode thread keeps it here
+		DecodeJob(SoundID _sid, const std::string& _filename) : sid(_sid), filename(_filename), chunk(NULL) {}
+	};
+
+	class PendingPlay {
+	public:
+		SoundID sid;
+		std::string channel;
+		FPoint pos;
+		bool loop;
+		bool cleanup;
+		PendingPlay(SoundID _sid, const std::string& _channel, const FPoint& _pos, bool _loop, bool _cleanup)
+			: sid(_sid), channel(_channel), pos(_pos), loop(_loop), cleanup(_cleanup) {}
+	};
+
+	enum {
+		PRIORITY_LOOP = 0,
+		PRIORITY_EFFECT = 1,
+		PRIORITY_INTERFACE = 2
+	};
+
 	static void channel_finished(int channel);
 	void on_channel_finished(int channel);
 
+	float getFalloff(const FPoint& location);
+	int getMixDistance(float falloff);
+	float getPriority(const Playback& p);
+	int startPlayback(const Playback& p, Mix_Chunk* chunk);
+	void removePlayback(PlaybackMapIterator it);
+	void virtualizePlayback(PlaybackMapIterator it);
+	void updateVoices();
+
+	bool coalescePlay(SoundID sid, const FPoint& pos);
+	void playChunk(SoundID sid, class Sound* psnd, const std::string& channel, const FPoint& pos, bool loop, bool cleanup);
+
+	static int decodeThreadMain(void* data);
+	void requestDecode(SoundID sid, class Sound* psnd);
+	void decodeJob(DecodeJob* job);
+	bool finishDecodes();
+	void dropPendingPlay(const PendingPlay& pending);
+
+	void addResident(class Sound* psnd);
+	void touchResident(class Sound* psnd);
+	void freeChunk(class Sound* psnd);
+	void trimCache();
+
 	SoundMap sounds;
 	VirtualChannelMap channels;
 	PlaybackMap playback;
@@ -73,6 +136,42 @@ private:
 	std::string music_filename;
 
 	SoundID last_played_sid;
+
+	// decoded bytes of every loaded chunk, and the budget from settings->sound_cache_size
+	size_t resident_bytes;
+	size_t cache_budget;
+
+	// the sounds that have a chunk, least recently used first
+	std::list<class Sound*> resident_sounds;
+
+	unsigned long cache_hits;
+	unsigned long cache_misses;
+	unsigned long cache_evictions;
+
+	// the decode thread is started the first time an evicted sound is played
+	SDL_Thread* decode_thread;
+	SDL_mutex* decode_mutex;
+	SDL_cond* decode_added;
+	std::queue<DecodeJob*> decode_queue;
+	std::vector<DecodeJob*> decode_finished;
+	bool decode_quit;
+	unsigned decode_count; // jobs that finishDecodes() hasn't handled yet
+
+	std::vector<PendingPlay> pending_plays;
+
+	// looping sounds without a mixer channel
+	std::vector<Playback> virtual_voices;
+
+	// non-looping sounds started since the last logic(), and their channel
+	std::map<SoundID, int> frame_plays;
+
+	// non-looping sounds played since the last logic() that are waiting for their chunk, and their index in pending_plays
+	std::map<SoundID, size_t> frame_pending;
+
+	unsigned long voices_stolen;
+	unsigned long voices_culled;
+	unsigned long voices_coalesced;
+	unsigned long voices_dropped;
 };
 
 #endif
@@ -748,6 +748,8 @@ void SaveLoad::loadPowerTree() {
 }
 
 void SaveLoad::saveFOW() {
+	if (game_slot <= 0) return;
+
 	std::ofstream outfile;
 
 	// Save fow dark layer
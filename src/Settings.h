@@ -90,6 +90,7 @@ public:
 	unsigned short sound_volume;
 	bool mute_on_focus_loss;
 	unsigned int audio_freq;
+	unsigned int sound_cache_size;
 
 	// Input Settings
 	bool mouse_move;
@@ -133,6 +134,7 @@ public:
 	bool setup_language;
 	bool setup_mousemove;
 	bool enable_threaded_image_load;
+	bool texture_atlas;
 
 	// Dev console: shortcut commands
 	std::string dev_cmd_1;
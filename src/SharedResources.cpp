@@ -37,10 +37,12 @@ Created and destroyed by main.cpp
 #include "MessageEngine.h"
 #include "ModManager.h"
 #include "RenderDevice.h"
+#include "Profiler.h"
 #include "SaveLoad.h"
 #include "Settings.h"
 #include "SharedResources.h"
 #include "SoundManager.h"
+#include "ThreadPool.h"
 #include "TooltipManager.h"
 
 AnimationManager *anim = NULL;
@@ -52,8 +54,10 @@ IconManager *icons = NULL;
 InputState *inpt = NULL;
 MessageEngine *msg = NULL;
 ModManager *mods = NULL;
+Profiler *profiler = NULL;
 RenderDevice *render_device = NULL;
 SaveLoad *save_load = NULL;
 Settings *settings = NULL;
 SoundManager *snd = NULL;
+ThreadPool *thread_pool = NULL;
 TooltipManager *tooltipm = NULL;
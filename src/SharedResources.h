@@ -41,10 +41,12 @@ class IconManager;
 class InputState;
 class MessageEngine;
 class ModManager;
+class Profiler;
 class RenderDevice;
 class SaveLoad;
 class Settings;
 class SoundManager;
+class ThreadPool;
 class TooltipManager;
 
 extern AnimationManager *anim;
@@ -56,10 +58,12 @@ extern IconManager *icons;
 extern InputState *inpt;
 extern MessageEngine *msg;
 extern ModManager *mods;
+extern Profiler *profiler;
 extern RenderDevice *render_device;
 extern SaveLoad *save_load;
 extern Settings *settings;
 extern SoundManager *snd;
+extern ThreadPool *thread_pool;
 extern TooltipManager *tooltipm;
 
 #endif
@@ -22,6 +22,45 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "CommonIncludes.h"
 #include "Utils.h"
 
+/**
+ * class SoundStats
+ *
+ * Counters for the decoded sound effect cache and the mixer channels, see SoundManager::getStats()
+ */
+class SoundStats {
+public:
+	SoundStats()
+		: hits(0)
+		, misses(0)
+		, evictions(0)
+		, sound_count(0)
+		, resident_count(0)
+		, resident_bytes(0)
+		, budget_bytes(0)
+		, playing_voices(0)
+		, virtual_voices(0)
+		, stolen(0)
+		, culled(0)
+		, coalesced(0)
+		, dropped(0) {
+	}
+
+	unsigned long hits; // sounds that were still decoded when played
+	unsigned long misses; // sounds that had to be decoded again when played
+	unsigned long evictions;
+	size_t sound_count;
+	size_t resident_count;
+	size_t resident_bytes;
+	size_t budget_bytes; // 0 is unlimited
+
+	size_t playing_voices;
+	size_t virtual_voices; // looping sounds waiting for the hero to come closer or for a free channel
+	unsigned long stolen; // sounds stopped to make room for a more important one
+	unsigned long culled; // sounds not played because they were too far away
+	unsigned long coalesced; // sounds not played because they already started in the same frame
+	unsigned long dropped; // sounds not played because every channel had a more important sound
+};
+
 /**
  * class SoundManager
  *
@@ -59,6 +98,8 @@ public:
 	virtual void reset() = 0;
 
 	virtual SoundID getLastPlayedSID() = 0;
+
+	virtual void getStats(SoundStats& stats) = 0;
 };
 
 /**
@@ -74,18 +115,18 @@ public:
 		: sid(-1)
 		, location(FPoint())
 		, loop(false)
-		, paused(false)
 		, finished(false)
-		, cleanup(true) {
+		, cleanup(true)
+		, mix_distance(-1) {
 	}
 
 	SoundID sid;
 	std::string virtual_channel;
 	FPoint location;
 	bool loop;
-	bool paused;
 	bool finished;
 	bool cleanup;
+	int mix_distance; // the distance last given to the mixer, from 0 to 255. -1 if none yet
 };
 
 #endif
@@ -0,0 +1,67 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "StringTable.h"
+
+/**
+ * Must be in the same order as the enum in StringTable.h
+ */
+static const char* PREDEFINED_STRINGS[StringTable::PREDEFINED_COUNT] = {
+	"",
+	"stance",
+	"run",
+	"block",
+	"hit",
+	"die",
+	"critdie",
+	"spawn"
+};
+
+StringTable::Table::Table() {
+	for (size_t i = 0; i < PREDEFINED_COUNT; ++i) {
+		ids[PREDEFINED_STRINGS[i]] = static_cast<StringID>(i);
+		strings.push_back(PREDEFINED_STRINGS[i]);
+	}
+}
+
+/**
+ * Created on first use, so IDs can be requested while other static objects are constructed
+ */
+StringTable::Table& StringTable::getTable() {
+	static Table table;
+	return table;
+}
+
+StringID StringTable::get(const std::string& s) {
+	Table& table = getTable();
+
+	std::map<std::string, StringID>::iterator it = table.ids.find(s);
+	if (it != table.ids.end())
+		return it->second;
+
+	StringID id = static_cast<StringID>(table.strings.size());
+	table.ids[s] = id;
+	table.strings.push_back(s);
+	return id;
+}
+
+const std::string& StringTable::getString(StringID id) {
+	Table& table = getTable();
+
+	if (id >= table.strings.size())
+		return table.strings[EMPTY];
+
+	return table.strings[id];
+}
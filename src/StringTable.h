@@ -0,0 +1,61 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class StringTable
+ *
+ * Interns strings, giving each distinct string a small integer ID for the rest of the run. Names that are looked up
+ * often (such as animation names) should be converted once when loading, so that later lookups only compare IDs.
+ *
+ * The names the engine uses directly are interned first, so their IDs are constants. Only use this on the main thread.
+ */
+
+#ifndef STRING_TABLE_H
+#define STRING_TABLE_H
+
+#include "CommonIncludes.h"
+
+typedef unsigned StringID;
+
+class StringTable {
+public:
+	enum {
+		EMPTY = 0,
+		ANIM_STANCE,
+		ANIM_RUN,
+		ANIM_BLOCK,
+		ANIM_HIT,
+		ANIM_DIE,
+		ANIM_CRITDIE,
+		ANIM_SPAWN,
+		PREDEFINED_COUNT
+	};
+
+	// returns the ID of the string, adding it to the table if needed
+	static StringID get(const std::string& s);
+	static const std::string& getString(StringID id);
+
+private:
+	class Table {
+	public:
+		std::map<std::string, StringID> ids;
+		std::vector<std::string> strings;
+		Table();
+	};
+
+	static Table& getTable();
+};
+
+#endif // STRING_TABLE_H
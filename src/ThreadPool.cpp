@@ -0,0 +1,129 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+#include "ThreadPool.h"
+#include "Utils.h"
+
+ThreadPool::ThreadPool()
+	: mutex(NULL)
+	, job_added(NULL)
+	, jobs_finished(NULL)
+	, busy_workers(0)
+	, started(false)
+	, quit(false)
+{
+}
+
+ThreadPool::~ThreadPool() {
+	if (mutex) {
+		SDL_LockMutex(mutex);
+		quit = true;
+		SDL_CondBroadcast(job_added);
+		SDL_UnlockMutex(mutex);
+	}
+
+	for (size_t i = 0; i < workers.size(); ++i) {
+		SDL_WaitThread(workers[i], NULL);
+	}
+
+	if (job_added) SDL_DestroyCond(job_added);
+	if (jobs_finished) SDL_DestroyCond(jobs_finished);
+	if (mutex) SDL_DestroyMutex(mutex);
+}
+
+/**
+ * One core is left for the main thread
+ */
+void ThreadPool::start() {
+	started = true;
+
+	mutex = SDL_CreateMutex();
+	job_added = SDL_CreateCond();
+	jobs_finished = SDL_CreateCond();
+	if (!mutex || !job_added || !jobs_finished) {
+		Utils::logError("ThreadPool: Could not create synchronization objects: %s", SDL_GetError());
+		return;
+	}
+
+	const int worker_count = std::max(1, std::min(static_cast<int>(MAX_WORKERS), SDL_GetCPUCount() - 1));
+	for (int i = 0; i < worker_count; ++i) {
+		SDL_Thread* thread = SDL_CreateThread(workerMain, "ThreadPool worker", this);
+		if (!thread) {
+			Utils::logError("ThreadPool: Could not create worker thread: %s", SDL_GetError());
+			break;
+		}
+		workers.push_back(thread);
+	}
+
+	Utils::logInfo("ThreadPool: Started %d worker thread(s).", static_cast<int>(workers.size()));
+}
+
+int ThreadPool::workerMain(void* data) {
+	ThreadPool* pool = static_cast<ThreadPool*>(data);
+
+	SDL_LockMutex(pool->mutex);
+	while (true) {
+		while (pool->jobs.empty() && !pool->quit) {
+			SDL_CondWait(pool->job_added, pool->mutex);
+		}
+		if (pool->quit)
+			break;
+
+		QueuedJob queued_job = pool->jobs.front();
+		pool->jobs.pop();
+		pool->busy_workers++;
+		SDL_UnlockMutex(pool->mutex);
+
+		queued_job.job(queued_job.data);
+
+		SDL_LockMutex(pool->mutex);
+		pool->busy_workers--;
+		if (pool->jobs.empty() && pool->busy_workers == 0)
+			SDL_CondBroadcast(pool->jobs_finished);
+	}
+	SDL_UnlockMutex(pool->mutex);
+
+	return 0;
+}
+
+void ThreadPool::submit(Job job, void* data) {
+	if (!started)
+		start();
+
+	if (workers.empty()) {
+		job(data);
+		return;
+	}
+
+	SDL_LockMutex(mutex);
+	jobs.push(QueuedJob(job, data));
+	SDL_CondSignal(job_added);
+	SDL_UnlockMutex(mutex);
+}
+
+void ThreadPool::wait() {
+	if (workers.empty())
+		return;
+
+	SDL_LockMutex(mutex);
+	while (!jobs.empty() || busy_workers > 0) {
+		SDL_CondWait(jobs_finished, mutex);
+	}
+	SDL_UnlockMutex(mutex);
+}
+
+size_t ThreadPool::getWorkerCount() const {
+	return workers.size();
+}
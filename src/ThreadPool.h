@@ -0,0 +1,72 @@
+/*
+This file is part of FLARE.
+
+FLARE is free software: you can redistribute it and/or modify it under the terms
+of the GNU General Public License as published by the Free Software Foundation,
+either version 3 of the License, or (at your option) any later version.
+
+FLARE is distributed in the hope that it will be useful, but WITHOUT ANY
+WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A
+PARTICULAR PURPOSE.  See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License along with
+FLARE.  If not, see http://www.gnu.org/licenses/
+*/
+
+/**
+ * class ThreadPool
+ *
+ * A fixed number of worker threads that run jobs from a shared queue.
+ * The number of workers depends on the number of CPU cores. They are started the first time a job is submitted.
+ *
+ * Jobs must not touch the renderer or any other main-thread-only state. The usual pattern is to submit a batch of
+ * jobs that each fill in their own data, call wait(), then finish the work on the main thread.
+ */
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include "CommonIncludes.h"
+
+class ThreadPool {
+public:
+	typedef void (*Job)(void* data);
+
+	// never use more workers than this, no matter how many cores there are
+	static const int MAX_WORKERS = 8;
+
+	ThreadPool();
+	~ThreadPool();
+
+	// queues a job. If no worker threads could be started, the job is run right away
+	void submit(Job job, void* data);
+
+	// blocks until every submitted job has finished
+	void wait();
+
+	size_t getWorkerCount() const;
+
+private:
+	class QueuedJob {
+	public:
+		Job job;
+		void* data;
+		QueuedJob(Job _job, void* _data) : job(_job), data(_data) {}
+	};
+
+	static int workerMain(void* data);
+	void start();
+
+	std::queue<QueuedJob> jobs;
+	std::vector<SDL_Thread*> workers;
+
+	SDL_mutex* mutex;
+	SDL_cond* job_added;
+	SDL_cond* jobs_finished;
+
+	unsigned busy_workers;
+	bool started;
+	bool quit;
+};
+
+#endif // THREAD_POOL_H
@@ -189,6 +189,10 @@ void TileSet::logic() {
 	}
 }
 
+bool TileSet::isAnimated(size_t tile_id) const {
+	return tile_id < anim.size() && anim[tile_id].frames > 0;
+}
+
 TileSet::~TileSet() {
 	for (size_t i = 0; i < sprites.size(); ++i) {
 		if (sprites[i])
@@ -77,6 +77,8 @@ public:
 	void load(const std::string& filename);
 	void logic();
 
+	bool isAnimated(size_t tile_id) const;
+
 	std::vector<Tile_Def> tiles;
 
 	// oversize of the largest tile available, in number of tiles.
@@ -66,6 +66,19 @@ bool Filesystem::fileExists(const std::string &filename) {
 	return exists;
 }
 
+/**
+ * Get the last modification time (in seconds) and the size (in bytes) of a file
+ */
+bool Filesystem::getFileInfo(const std::string &filename, uint64_t &modified_time, uint64_t &size) {
+	struct stat st;
+	if (stat(convertSlashes(filename).c_str(), &st) != 0)
+		return false;
+
+	modified_time = static_cast<uint64_t>(st.st_mtime);
+	size = static_cast<uint64_t>(st.st_size);
+	return true;
+}
+
 /**
  * Returns a vector containing all filenames in a given folder with the given extension
  */
@@ -25,6 +25,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #ifndef UTILS_FILE_SYSTEM_H
 #define UTILS_FILE_SYSTEM_H
 
+#include <stdint.h>
 #include <string>
 
 namespace Filesystem {
@@ -33,6 +34,7 @@ namespace Filesystem {
 	bool pathExists(const std::string &path);
 	void createDir(const std::string &path);
 	bool fileExists(const std::string &filename);
+	bool getFileInfo(const std::string &filename, uint64_t &modified_time, uint64_t &size);
 	int getFileList(const std::string &dir, const std::string &ext, std::vector<std::string> &files);
 	int getDirList(const std::string &dir, std::vector<std::string> &dirs);
 
@@ -26,13 +26,17 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include <limits.h>
 
 #include "AnimationManager.h"
+#include "Benchmark.h"
 #include "CombatText.h"
 #include "DeviceList.h"
 #include "EngineSettings.h"
 #include "GameSwitcher.h"
+#include "InputReplay.h"
 #include "InputState.h"
+#include "MapCache.h"
 #include "MessageEngine.h"
 #include "ModManager.h"
+#include "Profiler.h"
 #include "RenderDevice.h"
 #include "SaveLoad.h"
 #include "SDLFontEngine.h"
@@ -40,6 +44,7 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "SharedResources.h"
 #include "SoundManager.h"
 #include "Stats.h"
+#include "ThreadPool.h"
 #include "TooltipManager.h"
 #include "Utils.h"
 #include "UtilsFileSystem.h"
@@ -47,11 +52,15 @@ FLARE.  If not, see http://www.gnu.org/licenses/
 #include "Version.h"
 
 GameSwitcher *gswitch;
+InputReplay input_replay;
 
 class CmdLineArgs {
 public:
 	std::string render_device_name;
 	std::vector<std::string> mod_list;
+	std::string benchmark;
+	std::string record_input;
+	std::string replay_input;
 };
 
 #define PLATFORM_CPP_INCLUDE
@@ -75,7 +84,7 @@ bool init_finished = false;
 /**
  * Game initialization.
  */
-static void init(const CmdLineArgs& cmd_line_args) {
+static void init(const CmdLineArgs& cmd_line_args, Benchmark* benchmark = NULL) {
 	/**
 	 * Set system paths
 	 * PATH_CONF is for user-configurable settings files (e.g. keybindings)
@@ -109,6 +118,8 @@ static void init(const CmdLineArgs& cmd_line_args) {
 
 	// Shared Resources set-up
 
+	thread_pool = new ThreadPool();
+	profiler = new Profiler();
 	mods = new ModManager(&(cmd_line_args.mod_list));
 
 	if (!mods->haveFallbackMod()) {
@@ -171,9 +182,37 @@ static void init(const CmdLineArgs& cmd_line_args) {
 
 	tooltipm = new TooltipManager();
 
+	// the scenario sets the save slot that the title screen loads
+	if (benchmark)
+		benchmark->loadScenario();
+
 	gswitch = new GameSwitcher();
 }
 
+/**
+ * Tool mode: write the binary cache of every map, then exit without opening a window
+ */
+static void compileMaps(const CmdLineArgs& cmd_line_args) {
+	platform.setPaths();
+
+	settings->setCustomPathData();
+	settings->setGame();
+
+	Utils::createLogFile();
+	Utils::logInfo(VersionInfo::createVersionStringFull().c_str());
+
+	mods = new ModManager(&(cmd_line_args.mod_list));
+	if (!mods->haveFallbackMod()) {
+		Utils::logError("main: Could not find the default mod. Exiting.");
+	}
+	else {
+		MapCache::compileAll();
+	}
+
+	delete mods;
+	mods = NULL;
+}
+
 static float getSecondsElapsed(uint64_t prev_ticks, uint64_t now_ticks) {
 	return (static_cast<float>(now_ticks - prev_ticks) / static_cast<float>(SDL_GetPerformanceFrequency()));
 }
@@ -210,12 +249,17 @@ static void mainLoop () {
 			if (inpt->window_minimized && !inpt->window_restored && !inpt->done)
 				break;
 
-			gswitch->logic();
+			input_replay.beforeLogic();
+			{
+				PROFILE_SCOPE("GameSwitcher::logic");
+				gswitch->logic();
+			}
+			input_replay.afterLogic();
 			inpt->resetScroll();
 
 			// Engine done means the user escapes the main game menu.
 			// Input done means the user closes the window.
-			done = gswitch->done || inpt->done;
+			done = gswitch->done || inpt->done || input_replay.isFinished();
 
 			logic_ticks += static_cast<uint64_t>(seconds_per_frame * static_cast<float>(SDL_GetPerformanceFrequency()));
 			loops++;
@@ -238,14 +282,22 @@ static void mainLoop () {
 
 		if (!inpt->window_minimized) {
 			render_device->blankScreen();
-			gswitch->render();
+			{
+				PROFILE_SCOPE("GameSwitcher::render");
+				gswitch->render();
+			}
 
 			// display the FPS counter
 			if (last_fps != -1) {
 				gswitch->showFPS(last_fps);
 			}
 
-			render_device->commitFrame();
+			profiler->render();
+
+			{
+				PROFILE_SCOPE("RenderDevice::commitFrame");
+				render_device->commitFrame();
+			}
 
 			// calculate the FPS
 			// if the frame completed quickly, we estimate the delay here
@@ -274,6 +326,7 @@ static void mainLoop () {
 			}
 		}
 		prev_ticks = SDL_GetPerformanceCounter();
+		profiler->endFrame();
 	}
 }
 
@@ -291,6 +344,9 @@ static void cleanup() {
 	delete snd;
 	delete save_load;
 	delete eset;
+	delete thread_pool;
+	delete profiler;
+	profiler = NULL;
 
 	if (render_device)
 		render_device->destroyContext();
@@ -299,6 +355,23 @@ static void cleanup() {
 	SDL_Quit();
 }
 
+/**
+ * Tool mode: run a benchmark scenario without a window or audio, then exit
+ */
+static bool runBenchmark(CmdLineArgs& cmd_line_args) {
+	Benchmark benchmark(cmd_line_args.benchmark);
+	benchmark.setupHeadless();
+
+	// the dummy video driver only works with the software renderer
+	cmd_line_args.render_device_name = "sdl";
+
+	init(cmd_line_args, &benchmark);
+	bool success = benchmark.run(gswitch);
+	cleanup();
+
+	return success;
+}
+
 std::string parseArg(const std::string &arg) {
 	std::string result = "";
 
@@ -347,7 +420,9 @@ void EmscriptenMainLoop() {
 
 	render_device->blankScreen();
 	gswitch->render();
+	profiler->render();
 	render_device->commitFrame();
+	profiler->endFrame();
 }
 #endif
 
@@ -355,7 +430,9 @@ int main(int argc, char *argv[]) {
 	settings = new Settings();
 
 	bool debug_event = false;
+	bool compile_maps = false;
 	bool done = false;
+	int exit_code = 0;
 	CmdLineArgs cmd_line_args;
 
 	for (int i = 1 ; i < argc; i++) {
@@ -398,6 +475,18 @@ int main(int argc, char *argv[]) {
 		else if (arg == "safe-video") {
 			settings->safe_video = true;
 		}
+		else if (arg == "compile-maps") {
+			compile_maps = true;
+		}
+		else if (arg == "benchmark") {
+			cmd_line_args.benchmark = parseArgValue(arg_full);
+		}
+		else if (arg == "record-input") {
+			cmd_line_args.record_input = parseArgValue(arg_full);
+		}
+		else if (arg == "replay-input") {
+			cmd_line_args.replay_input = parseArgValue(arg_full);
+		}
 		else if (arg == "help") {
 			Utils::logInfo("Command line options:\n\
 --help                   Prints this message.\n\
@@ -413,7 +502,13 @@ int main(int argc, char *argv[]) {
 --load-slot=<SLOT>       Loads a save slot by numerical index.\n\
 --load-script=<SCRIPT>   Execute's a script upon loading a saved game.\n\
                          The script path is mod-relative.\n\
---safe-video             Launches with the minimum video settings.");
+--safe-video             Launches with the minimum video settings.\n\
+--compile-maps           Writes the binary cache of every map and exits.\n\
+--benchmark=<SCENARIO>   Runs benchmarks/<SCENARIO>.txt without a window and\n\
+                         logs how long each part of the game loop took.\n\
+--record-input=<FILE>    Records the input of every logic tick to a file.\n\
+--replay-input=<FILE>    Plays back a recording made with --record-input, logs\n\
+                         how long each part of the game loop took and exits.");
 			done = true;
 		}
 		else {
@@ -421,9 +516,25 @@ int main(int argc, char *argv[]) {
 		}
 	}
 
+	if (compile_maps && !done) {
+		compileMaps(cmd_line_args);
+		done = true;
+	}
+
+	if (!cmd_line_args.benchmark.empty() && !done) {
+		if (!runBenchmark(cmd_line_args))
+			exit_code = 1;
+		done = true;
+	}
+
 soft_reset:
 	if (!done) {
-		srand(static_cast<unsigned int>(time(NULL)));
+		unsigned int seed = static_cast<unsigned int>(time(NULL));
+		if (!cmd_line_args.replay_input.empty() && input_replay.startPlayback(cmd_line_args.replay_input))
+			seed = input_replay.getSeed();
+		else if (!cmd_line_args.record_input.empty())
+			input_replay.startRecording(cmd_line_args.record_input, seed);
+		srand(seed);
 #ifdef __EMSCRIPTEN__
 		platform.FSInit();
 		emscripten_set_main_loop(EmscriptenMainLoop, settings->max_frames_per_sec, 1);
@@ -433,7 +544,16 @@ soft_reset:
 		if (debug_event)
 			inpt->enableEventLog();
 
+		if (input_replay.isPlaying())
+			profiler->startRecording();
+
 		mainLoop();
+
+		if (input_replay.isPlaying()) {
+			profiler->logSummary();
+			profiler->stopRecording(settings->path_user + "replay.csv", settings->path_user + "replay_trace.json");
+		}
+		input_replay.stop();
 #endif
 
 		if (gswitch)
@@ -452,5 +572,5 @@ soft_reset:
 
 	delete settings;
 
-	return 0;
+	return exit_code;
 }